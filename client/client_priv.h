@@ -110,6 +110,25 @@ enum options_client
   OPT_OB_PROXY_USER,
   OPT_OB_SOCKET5_PROXY,
   OPT_OB_ERROR_SQL,
+  OPT_QUICK_LOOKAHEAD,
+  OPT_PIPELINE_ROWS,
+  OPT_COMPLETION_CACHE,
+  OPT_COMPLETION_CACHE_AGE,
+  OPT_PARALLEL,
+  OPT_PACK_STATEMENTS,
+  OPT_STANDBY_SESSION,
+  OPT_CONNECT_RACE,
+  OPT_SESSION_CACHE,
+  OPT_SESSION_CACHE_TIMEOUT,
+  OPT_RESULT_MEMORY_LIMIT,
+  OPT_CURSOR_FETCH,
+  OPT_LOB_CHUNK_SIZE,
+  OPT_BATCH_INSERTS,
+  OPT_PROFILE_FILE,
+  OPT_CHUNK_ROWS,
+  OPT_CHUNK_BYTES,
+  OPT_COMPRESS_OUTPUT,
+  OPT_COMPRESS_THREADS,
   OPT_MAX_CLIENT_OPTION /* should be always the last */
 };
 
@@ -13,214 +13,129 @@
    along with this program; if not, write to the Free Software
    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1335  USA */
 
-/* Quick & light hash implementation for tab completion purposes
- *
- * by  Andi Gutmans <andi@zend.com>
- * and Zeev Suraski <zeev@zend.com>
- * Small portability changes by Monty. Changed also to use my_malloc/my_free
- */
+/*
+  Word index for tab completion purposes.
+
+  Words are copied into the MEM_ROOT of the index and collected in an
+  array that is sorted and cleared of duplicates before it is searched,
+  so memory grows with the length of the words and not with the number
+  of their prefixes. A lookup costs a binary search for the prefix plus
+  the matches returned.
+*/
 
 #include <my_global.h>
 #include <m_string.h>
 #include <my_sys.h>
 #include "completion_hash.h"
 
-uint hashpjw(const char *arKey, uint nKeyLength)
-{
-  uint h = 0, g, i;
-
-  for (i = 0; i < nKeyLength; i++) {
-    h = (h << 4) + arKey[i];
-    if ((g = (h & 0xF0000000))) {
-      h = h ^ (g >> 24);
-      h = h ^ g;
-    }
-  }
-  return h;
-}
-
-int completion_hash_init(HashTable *ht, uint nSize)
+int completion_index_init(COMPLETION_INDEX *ci)
 {
-  ht->arBuckets = (Bucket **) my_malloc(nSize* sizeof(Bucket *),
-					MYF(MY_ZEROFILL | MY_WME));
-
-  if (!ht->arBuckets)
-  {
-    ht->initialized = 0;
-    return FAILURE;
-  }
-  init_alloc_root(&ht->mem_root, "completion_hash", 8192, 0, MYF(0));
-  ht->pHashFunction = hashpjw;
-  ht->nTableSize = nSize;
-  ht->initialized = 1;
+  bzero((char*) ci, sizeof(*ci));
+  init_alloc_root(&ci->mem_root, "completion_index", 65536, 0, MYF(0));
   return SUCCESS;
 }
 
 
-int completion_hash_update(HashTable *ht, char *arKey, uint nKeyLength,
-			   char *str)
+int add_word(COMPLETION_INDEX *ci, const char *str)
 {
-  uint h, nIndex;
-
-  Bucket *p;
+  char *word;
 
-  h = ht->pHashFunction(arKey, nKeyLength);
-  nIndex = h % ht->nTableSize;
-
-  if (nKeyLength <= 0) {
-    return FAILURE;
-  }
-  p = ht->arBuckets[nIndex];
-  while (p)
+  if (!*str)
+    return SUCCESS;
+  if (ci->count == ci->allocated)
   {
-    if ((p->h == h) && (p->nKeyLength == nKeyLength)) {
-      if (!memcmp(p->arKey, arKey, nKeyLength)) {
-	entry *n;
-
-	if (!(n = (entry *) alloc_root(&ht->mem_root,sizeof(entry))))
-          return FAILURE;
-	n->pNext = p->pData;
-	n->str = str;
-	p->pData = n;
-	p->count++;
-
-	return SUCCESS;
-      }
-    }
-    p = p->pNext;
+    uint allocated= ci->allocated ? ci->allocated * 2 : 1024;
+    char **words= (char**) my_realloc(ci->words, allocated * sizeof(char*),
+                                      MYF(MY_ALLOW_ZERO_PTR));
+    if (!words)
+      return FAILURE;
+    ci->words= words;
+    ci->allocated= allocated;
   }
-
-  if (!(p = (Bucket *) alloc_root(&ht->mem_root, sizeof(Bucket))))
+  if (!(word= strdup_root(&ci->mem_root, str)))
     return FAILURE;
+  ci->words[ci->count++]= word;
+  return SUCCESS;
+}
 
-  p->arKey = arKey;
-  p->nKeyLength = nKeyLength;
-  p->h = h;
-
-  if (!(p->pData = (entry*) alloc_root(&ht->mem_root, sizeof(entry))))
-    return FAILURE;
 
-  p->pData->str = str;
-  p->pData->pNext = 0;
-  p->count = 1;
+static int cmp_words(const void *a, const void *b)
+{
+  return strcmp(*(const char**) a, *(const char**) b);
+}
 
-  p->pNext = ht->arBuckets[nIndex];
-  ht->arBuckets[nIndex] = p;
 
-  return SUCCESS;
-}
+/*
+  Sort the words and remove duplicates. Called by find_all_matches() when
+  words were added since the last search.
+*/
 
-static Bucket *completion_hash_find(HashTable *ht, const char *arKey,
-				    uint nKeyLength)
+void completion_index_sort(COMPLETION_INDEX *ci)
 {
-  uint h, nIndex;
-  Bucket *p;
+  uint i, to;
 
-  h = ht->pHashFunction(arKey, nKeyLength);
-  nIndex = h % ht->nTableSize;
-
-  p = ht->arBuckets[nIndex];
-  while (p)
+  if (ci->sorted == ci->count)
+    return;
+  my_qsort(ci->words, ci->count, sizeof(char*), cmp_words);
+  for (i= to= 0; i < ci->count; i++)
   {
-    if ((p->h == h) && (p->nKeyLength == nKeyLength)) {
-      if (!memcmp(p->arKey, arKey, nKeyLength)) {
-	return p;
-      }
-    }
-    p = p->pNext;
+    if (!to || strcmp(ci->words[to - 1], ci->words[i]))
+      ci->words[to++]= ci->words[i];
   }
-  return (Bucket*) 0;
+  ci->count= ci->sorted= to;
 }
 
 
-int completion_hash_exists(HashTable *ht, char *arKey, uint nKeyLength)
-{
-  uint h, nIndex;
-  Bucket *p;
-
-  h = ht->pHashFunction(arKey, nKeyLength);
-  nIndex = h % ht->nTableSize;
+/*
+  Find the words that start with the first length bytes of str.
 
-  p = ht->arBuckets[nIndex];
-  while (p)
-  {
-    if ((p->h == h) && (p->nKeyLength == nKeyLength))
-    {
-      if (!strcmp(p->arKey, arKey)) {
-	return 1;
-      }
-    }
-    p = p->pNext;
-  }
-  return 0;
-}
+  Returns the number of matches, which are words[*first] onwards. An
+  empty prefix matches all words.
+*/
 
-Bucket *find_all_matches(HashTable *ht, const char *str, uint length,
-			 uint *res_length)
+uint find_all_matches(COMPLETION_INDEX *ci, const char *str, uint length,
+                      uint *first)
 {
-  Bucket *b;
-
-  b = completion_hash_find(ht,str,length);
-  if (!b) {
-    *res_length = 0;
-    return (Bucket*) 0;
-  } else {
-    *res_length = length;
-    return b;
-  }
-}
+  uint low, high, start;
 
-Bucket *find_longest_match(HashTable *ht, char *str, uint length,
-			   uint *res_length)
-{
-  Bucket *b,*return_b;
-  char *s;
-  uint count;
-  uint lm;
-
-  b = completion_hash_find(ht,str,length);
-  if (!b) {
-    *res_length = 0;
-    return (Bucket*) 0;
-  }
+  completion_index_sort(ci);
 
-  count = b->count;
-  lm = length;
-  s = b->pData->str;
-
-  return_b = b;
-  while (s[lm]!=0 && (b=completion_hash_find(ht,s,lm+1))) {
-    if (b->count<count) {
-      *res_length=lm;
-      return return_b;
-    }
-    return_b=b;
-    lm++;
+  /* First word not less than the prefix */
+  for (low= 0, high= ci->count; low < high; )
+  {
+    uint mid= low + (high - low) / 2;
+    if (strncmp(ci->words[mid], str, length) < 0)
+      low= mid + 1;
+    else
+      high= mid;
   }
-  *res_length=lm;
-  return return_b;
-}
+  start= low;
 
-
-void completion_hash_clean(HashTable *ht)
-{
-  free_root(&ht->mem_root,MYF(0));
-  if (size_t s= ht->nTableSize)
-    bzero((char*) ht->arBuckets, s * sizeof(Bucket *));
+  /* First word greater than every word with the prefix */
+  for (high= ci->count; low < high; )
+  {
+    uint mid= low + (high - low) / 2;
+    if (strncmp(ci->words[mid], str, length) <= 0)
+      low= mid + 1;
+    else
+      high= mid;
+  }
+  *first= start;
+  return low - start;
 }
 
 
-void completion_hash_free(HashTable *ht)
+void completion_index_clean(COMPLETION_INDEX *ci)
 {
-  completion_hash_clean(ht);
-  my_free(ht->arBuckets);
+  free_root(&ci->mem_root, MYF(MY_MARK_BLOCKS_FREE));
+  ci->count= ci->sorted= 0;
 }
 
 
-void add_word(HashTable *ht,char *str)
+void completion_index_free(COMPLETION_INDEX *ci)
 {
-  int i;
-  char *pos=str;
-  for (i=1; *pos; i++, pos++)
-    completion_hash_update(ht, str, i, str);
+  free_root(&ci->mem_root, MYF(0));
+  my_free(ci->words);
+  ci->words= 0;
+  ci->count= ci->sorted= ci->allocated= 0;
 }
@@ -25,37 +25,26 @@
 #include <sys/types.h>
 #include <my_sys.h>
 
-typedef struct _entry {
-	char *str;
-	struct _entry *pNext;
-} entry;
-
-typedef struct bucket
-{
-  uint h;					/* Used for numeric indexing */
-  char *arKey;
-  uint nKeyLength;
-  uint count;
-  entry *pData;
-  struct bucket *pNext;
-} Bucket;
-
-typedef struct hashtable {
-  uint nTableSize;
-  uint initialized;
-  MEM_ROOT mem_root;
-  uint(*pHashFunction) (const char *arKey, uint nKeyLength);
-  Bucket **arBuckets;
-} HashTable;
-
-extern int completion_hash_init(HashTable *ht, uint nSize);
-extern int completion_hash_update(HashTable *ht, char *arKey, uint nKeyLength, char *str);
-extern int hash_exists(HashTable *ht, char *arKey);
-extern Bucket *find_all_matches(HashTable *ht, const char *str, uint length, uint *res_length);
-extern Bucket *find_longest_match(HashTable *ht, char *str, uint length, uint *res_length);
-extern void add_word(HashTable *ht,char *str);
-extern void completion_hash_clean(HashTable *ht);
-extern int completion_hash_exists(HashTable *ht, char *arKey, uint nKeyLength);
-extern void completion_hash_free(HashTable *ht);
+/*
+  The words known for tab completion, kept as a sorted array of pointers
+  into a MEM_ROOT. The words starting with a given prefix form a range of
+  the array that is found by binary search.
+*/
+
+typedef struct st_completion_index {
+  MEM_ROOT mem_root;                    /* The words */
+  char **words;
+  uint count;                           /* Words in use */
+  uint allocated;                       /* Size of words */
+  uint sorted;                          /* words[0..sorted) sorted, unique */
+} COMPLETION_INDEX;
+
+extern int completion_index_init(COMPLETION_INDEX *ci);
+extern int add_word(COMPLETION_INDEX *ci, const char *str);
+extern void completion_index_sort(COMPLETION_INDEX *ci);
+extern uint find_all_matches(COMPLETION_INDEX *ci, const char *str,
+                             uint length, uint *first);
+extern void completion_index_clean(COMPLETION_INDEX *ci);
+extern void completion_index_free(COMPLETION_INDEX *ci);
 
 #endif /* _HASH_ */
@@ -0,0 +1,495 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Compressed output files of mysqldump, see compressed_output.h.
+
+  The frames of a stream are kept in a ring. The thread writing to the
+  stream fills the frame after the queued ones and hands it to the
+  compressor threads when it is full. Whenever the oldest frame of the
+  ring is compressed, the writing thread writes it to the file. When the
+  ring is full it waits for it. So the frames reach the file in order,
+  and at most 2 frames per compressor thread are held in memory.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <my_pthread.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "compressed_output.h"
+
+/* Member header with the 'MD' extra field, and CRC32 and ISIZE after */
+#define GZIP_HEADER_SIZE  24
+#define GZIP_TRAILER_SIZE 8
+#define GZIP_OS_UNKNOWN   255
+/* Skippable frame header and the two sizes */
+#define ZSTD_INDEX_SIZE   16
+
+typedef struct st_compressed_output COMPRESSED_OUTPUT;
+
+typedef struct st_compress_frame
+{
+  uchar *data;                  /* COMPRESS_FRAME_SIZE bytes to compress */
+  size_t length;
+  uchar *packed;                /* compress_bound() bytes */
+  size_t packed_length;
+  my_bool done;                 /* packed is ready, under compress_mutex */
+  my_bool error;
+  struct st_compress_frame *next;  /* in compress_queue */
+} COMPRESS_FRAME;
+
+struct st_compressed_output
+{
+  FILE *file;
+  my_bool close_file;
+  int error;                    /* errno of the first failure */
+  COMPRESS_FRAME *frames;       /* ring of compress_ring_size frames */
+  uint first;                   /* oldest frame not written */
+  uint queued;                  /* frames given to the compressors */
+};
+
+static COMPRESS_OPTIONS compress_opts;
+static uint compress_ring_size;
+static pthread_t *compress_threads;
+static uint compress_thread_count;
+static pthread_mutex_t compress_mutex;
+static pthread_cond_t compress_work, compress_done;
+static COMPRESS_FRAME *compress_queue, *compress_queue_last;
+static my_bool compress_stop;
+
+
+const char *compress_options_parse(COMPRESS_OPTIONS *opts, const char *arg)
+{
+  const char *colon= strchr(arg, ':');
+  size_t length= colon ? (size_t) (colon - arg) : strlen(arg);
+  int max_level;
+
+  if (length == 4 && !strncmp(arg, "gzip", 4))
+  {
+    opts->method= COMPRESS_GZIP;
+    opts->level= 6;
+    max_level= 9;
+  }
+  else if (length == 4 && !strncmp(arg, "zstd", 4))
+  {
+#ifdef HAVE_ZSTD
+    opts->method= COMPRESS_ZSTD;
+    opts->level= 3;
+    max_level= ZSTD_maxCLevel();
+#else
+    return "this build has no zstd support";
+#endif
+  }
+  else
+    return "the method must be gzip or zstd";
+
+  if (colon)
+  {
+    char *end;
+    long level= strtol(colon + 1, &end, 10);
+    if (end == colon + 1 || *end || level < 1 || level > max_level)
+      return "invalid compression level";
+    opts->level= (int) level;
+  }
+#ifndef HAVE_FOPENCOOKIE
+  return "not supported on this platform";
+#else
+  return NULL;
+#endif
+}
+
+
+const char *compress_extension(const COMPRESS_OPTIONS *opts)
+{
+  switch (opts->method) {
+  case COMPRESS_GZIP:
+    return ".gz";
+  case COMPRESS_ZSTD:
+    return ".zst";
+  case COMPRESS_NONE:
+    break;
+  }
+  return "";
+}
+
+
+static size_t compress_bound(void)
+{
+#ifdef HAVE_ZSTD
+  if (compress_opts.method == COMPRESS_ZSTD)
+    return ZSTD_INDEX_SIZE + ZSTD_compressBound(COMPRESS_FRAME_SIZE);
+#endif
+  /* compressBound() is for the zlib format, which is larger than raw */
+  return GZIP_HEADER_SIZE + compressBound(COMPRESS_FRAME_SIZE) +
+         GZIP_TRAILER_SIZE;
+}
+
+
+/*
+  Compress the frame into one gzip member. The header is written after
+  the data, which is compressed as raw deflate, as it holds the size of
+  the member.
+*/
+
+static my_bool compress_gzip(z_stream *zs, COMPRESS_FRAME *frame)
+{
+  uchar *to= frame->packed;
+  size_t member_length;
+
+  if (deflateReset(zs) != Z_OK)
+    return 1;
+  zs->next_in= frame->data;
+  zs->avail_in= (uInt) frame->length;
+  zs->next_out= to + GZIP_HEADER_SIZE;
+  zs->avail_out= (uInt) (compress_bound() - GZIP_HEADER_SIZE -
+                         GZIP_TRAILER_SIZE);
+  if (deflate(zs, Z_FINISH) != Z_STREAM_END)
+    return 1;
+  member_length= GZIP_HEADER_SIZE + zs->total_out + GZIP_TRAILER_SIZE;
+
+  to[0]= 0x1f;                                  /* ID1, ID2 */
+  to[1]= 0x8b;
+  to[2]= Z_DEFLATED;                            /* CM */
+  to[3]= 4;                                     /* FLG: FEXTRA */
+  int4store(to + 4, 0);                         /* MTIME */
+  to[8]= 0;                                     /* XFL */
+  to[9]= GZIP_OS_UNKNOWN;
+  int2store(to + 10, 12);                       /* XLEN */
+  to[12]= 'M';
+  to[13]= 'D';
+  int2store(to + 14, 8);
+  int4store(to + 16, (uint32) member_length);
+  int4store(to + 20, (uint32) frame->length);
+
+  to+= GZIP_HEADER_SIZE + zs->total_out;
+  int4store(to, (uint32) crc32(crc32(0L, Z_NULL, 0), frame->data,
+                               (uInt) frame->length));
+  int4store(to + 4, (uint32) frame->length);
+  frame->packed_length= member_length;
+  return 0;
+}
+
+
+#ifdef HAVE_ZSTD
+static my_bool compress_zstd(ZSTD_CCtx *cctx, COMPRESS_FRAME *frame)
+{
+  uchar *to= frame->packed;
+  size_t length= ZSTD_compressCCtx(cctx, to + ZSTD_INDEX_SIZE,
+                                   compress_bound() - ZSTD_INDEX_SIZE,
+                                   frame->data, frame->length,
+                                   compress_opts.level);
+  if (ZSTD_isError(length))
+    return 1;
+  int4store(to, COMPRESS_ZSTD_INDEX_MAGIC);
+  int4store(to + 4, 8);
+  int4store(to + 8, (uint32) length);
+  int4store(to + 12, (uint32) frame->length);
+  frame->packed_length= ZSTD_INDEX_SIZE + length;
+  return 0;
+}
+#endif
+
+
+static void *compress_thread(void *arg __attribute__((unused)))
+{
+  z_stream zs;
+  my_bool ready;
+#ifdef HAVE_ZSTD
+  ZSTD_CCtx *cctx= NULL;
+#endif
+
+  bzero(&zs, sizeof(zs));
+  if (compress_opts.method == COMPRESS_GZIP)
+    ready= deflateInit2(&zs, compress_opts.level, Z_DEFLATED, -MAX_WBITS,
+                        8, Z_DEFAULT_STRATEGY) == Z_OK;
+#ifdef HAVE_ZSTD
+  else
+    ready= (cctx= ZSTD_createCCtx()) != NULL;
+#else
+  else
+    ready= 0;
+#endif
+
+  pthread_mutex_lock(&compress_mutex);
+  for (;;)
+  {
+    COMPRESS_FRAME *frame;
+    my_bool error;
+
+    while (!compress_queue && !compress_stop)
+      pthread_cond_wait(&compress_work, &compress_mutex);
+    if (!(frame= compress_queue))
+      break;
+    if (!(compress_queue= frame->next))
+      compress_queue_last= NULL;
+    pthread_mutex_unlock(&compress_mutex);
+
+    if (!ready)
+      error= 1;
+#ifdef HAVE_ZSTD
+    else if (compress_opts.method == COMPRESS_ZSTD)
+      error= compress_zstd(cctx, frame);
+#endif
+    else
+      error= compress_gzip(&zs, frame);
+
+    pthread_mutex_lock(&compress_mutex);
+    frame->error= error;
+    frame->done= 1;
+    pthread_cond_broadcast(&compress_done);
+  }
+  pthread_mutex_unlock(&compress_mutex);
+
+  if (compress_opts.method == COMPRESS_GZIP && ready)
+    deflateEnd(&zs);
+#ifdef HAVE_ZSTD
+  ZSTD_freeCCtx(cctx);
+#endif
+  return NULL;
+}
+
+
+my_bool compress_threads_start(const COMPRESS_OPTIONS *opts)
+{
+  uint i;
+
+  compress_opts= *opts;
+  compress_ring_size= 2 * opts->threads;
+  if (!(compress_threads= (pthread_t*) my_malloc(opts->threads *
+                                                 sizeof(pthread_t),
+                                                 MYF(MY_WME))))
+    return 1;
+  pthread_mutex_init(&compress_mutex, NULL);
+  pthread_cond_init(&compress_work, NULL);
+  pthread_cond_init(&compress_done, NULL);
+  compress_queue= compress_queue_last= NULL;
+  compress_stop= 0;
+
+  for (i= 0; i < opts->threads; i++)
+  {
+    if (pthread_create(compress_threads + i, NULL, compress_thread, NULL))
+      return 1;
+    compress_thread_count++;
+  }
+  return 0;
+}
+
+
+void compress_threads_end(void)
+{
+  uint i;
+
+  if (!compress_threads)
+    return;
+  pthread_mutex_lock(&compress_mutex);
+  compress_stop= 1;
+  pthread_cond_broadcast(&compress_work);
+  pthread_mutex_unlock(&compress_mutex);
+
+  for (i= 0; i < compress_thread_count; i++)
+    pthread_join(compress_threads[i], NULL);
+  pthread_mutex_destroy(&compress_mutex);
+  pthread_cond_destroy(&compress_work);
+  pthread_cond_destroy(&compress_done);
+  my_free(compress_threads);
+  compress_threads= NULL;
+  compress_thread_count= 0;
+}
+
+
+#ifdef HAVE_FOPENCOOKIE
+
+static COMPRESS_FRAME *fill_frame(COMPRESSED_OUTPUT *out)
+{
+  return out->frames + (out->first + out->queued) % compress_ring_size;
+}
+
+
+static void queue_frame(COMPRESSED_OUTPUT *out)
+{
+  COMPRESS_FRAME *frame= fill_frame(out);
+
+  frame->next= NULL;
+  pthread_mutex_lock(&compress_mutex);
+  if (compress_queue_last)
+    compress_queue_last->next= frame;
+  else
+    compress_queue= frame;
+  compress_queue_last= frame;
+  out->queued++;
+  pthread_cond_signal(&compress_work);
+  pthread_mutex_unlock(&compress_mutex);
+}
+
+
+/*
+  Write the compressed frames at the start of the ring, waiting for them
+  while more than keep frames are queued.
+*/
+
+static int write_frames(COMPRESSED_OUTPUT *out, uint keep)
+{
+  pthread_mutex_lock(&compress_mutex);
+  while (out->queued)
+  {
+    COMPRESS_FRAME *frame= out->frames + out->first;
+    if (!frame->done)
+    {
+      if (out->queued <= keep)
+        break;
+      pthread_cond_wait(&compress_done, &compress_mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&compress_mutex);
+
+    if (out->error)
+      ;                                         /* Only drain the ring */
+    else if (frame->error)
+      out->error= ENOMEM;
+    else if (fwrite(frame->packed, 1, frame->packed_length, out->file) !=
+             frame->packed_length)
+      out->error= errno ? errno : EIO;
+    frame->length= 0;
+    frame->done= 0;
+
+    pthread_mutex_lock(&compress_mutex);
+    out->first= (out->first + 1) % compress_ring_size;
+    out->queued--;
+  }
+  pthread_mutex_unlock(&compress_mutex);
+  if (out->error)
+  {
+    errno= out->error;
+    return -1;
+  }
+  return 0;
+}
+
+
+static ssize_t compressed_output_write(void *cookie, const char *buf,
+                                       size_t size)
+{
+  COMPRESSED_OUTPUT *out= (COMPRESSED_OUTPUT*) cookie;
+  size_t left= size;
+
+  if (out->error)
+  {
+    errno= out->error;
+    return 0;
+  }
+  while (left)
+  {
+    COMPRESS_FRAME *frame= fill_frame(out);
+    size_t length= MY_MIN(left, COMPRESS_FRAME_SIZE - frame->length);
+
+    memcpy(frame->data + frame->length, buf, length);
+    frame->length+= length;
+    buf+= length;
+    left-= length;
+    if (frame->length == COMPRESS_FRAME_SIZE)
+    {
+      queue_frame(out);
+      /* Keep a free frame to fill */
+      if (write_frames(out, compress_ring_size - 1))
+        return 0;
+    }
+  }
+  return (ssize_t) size;
+}
+
+
+static void free_output(COMPRESSED_OUTPUT *out)
+{
+  uint i;
+  for (i= 0; i < compress_ring_size; i++)
+  {
+    my_free(out->frames[i].data);
+    my_free(out->frames[i].packed);
+  }
+  my_free(out);
+}
+
+
+static int compressed_output_close_file(void *cookie)
+{
+  COMPRESSED_OUTPUT *out= (COMPRESSED_OUTPUT*) cookie;
+  int error;
+
+  if (fill_frame(out)->length)
+    queue_frame(out);
+  error= write_frames(out, 0);
+  if (fflush(out->file))
+    error= -1;
+  if (out->close_file && my_fclose(out->file, MYF(MY_WME)))
+    error= -1;
+  free_output(out);
+  return error ? EOF : 0;
+}
+
+
+FILE *compressed_output_open(FILE *file, my_bool close_file)
+{
+  cookie_io_functions_t io= {NULL, compressed_output_write, NULL,
+                             compressed_output_close_file};
+  COMPRESSED_OUTPUT *out;
+  FILE *stream;
+  uint i;
+
+  if (!(out= (COMPRESSED_OUTPUT*) my_malloc(sizeof(*out) +
+                                            compress_ring_size *
+                                            sizeof(COMPRESS_FRAME),
+                                            MYF(MY_WME | MY_ZEROFILL))))
+    return NULL;
+  out->file= file;
+  out->close_file= close_file;
+  out->frames= (COMPRESS_FRAME*) (out + 1);
+  for (i= 0; i < compress_ring_size; i++)
+  {
+    COMPRESS_FRAME *frame= out->frames + i;
+    if (!(frame->data= (uchar*) my_malloc(COMPRESS_FRAME_SIZE, MYF(MY_WME))) ||
+        !(frame->packed= (uchar*) my_malloc(compress_bound(), MYF(MY_WME))))
+    {
+      free_output(out);
+      return NULL;
+    }
+  }
+  if (!(stream= fopencookie(out, "w", io)))
+  {
+    free_output(out);
+    return NULL;
+  }
+  return stream;
+}
+
+#else
+
+FILE *compressed_output_open(FILE *file __attribute__((unused)),
+                             my_bool close_file __attribute__((unused)))
+{
+  return NULL;
+}
+
+#endif /* HAVE_FOPENCOOKIE */
+
+
+int compressed_output_close(FILE *stream)
+{
+  return fclose(stream);
+}
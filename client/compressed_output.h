@@ -0,0 +1,86 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+#ifndef _compressed_output_h_
+#define _compressed_output_h_
+
+/*
+  Compressed output files of mysqldump.
+
+  A compressed output is a FILE stream, so the dump code writes to it as
+  to any other file. What is written is cut into frames of
+  COMPRESS_FRAME_SIZE bytes that are compressed independently by a pool
+  of threads and written to the underlying file in order.
+
+  Every frame starts with its compressed and uncompressed sizes, so that
+  a reader can find all frames from their headers alone and decompress
+  them in parallel, or start at any frame:
+
+  gzip  Each frame is a gzip member (RFC 1952) with an extra field of
+        subfield id 'M','D' and 8 bytes: the size of the whole member
+        and the size of its data, little endian. Any gzip reader
+        decompresses the concatenated members as one stream.
+
+  zstd  Each frame is a skippable frame of magic COMPRESS_ZSTD_INDEX_MAGIC
+        with the same 8 bytes, for the zstd frame that follows it.
+        zstd readers skip it.
+
+  Appending to an existing compressed output just adds frames.
+*/
+
+#include <my_global.h>
+
+C_MODE_START
+
+#define COMPRESS_FRAME_SIZE (1024*1024)
+#define COMPRESS_ZSTD_INDEX_MAGIC 0x184D2A50U
+
+enum enum_compress_method
+{
+  COMPRESS_NONE,
+  COMPRESS_GZIP,
+  COMPRESS_ZSTD
+};
+
+typedef struct st_compress_options
+{
+  enum enum_compress_method method;
+  int level;
+  uint threads;
+} COMPRESS_OPTIONS;
+
+/*
+  Parse "gzip" or "zstd", optionally followed by ":level". Return an
+  error message, or NULL on success.
+*/
+const char *compress_options_parse(COMPRESS_OPTIONS *opts, const char *arg);
+/* File name extension of the method, ".gz" or ".zst" */
+const char *compress_extension(const COMPRESS_OPTIONS *opts);
+
+my_bool compress_threads_start(const COMPRESS_OPTIONS *opts);
+void compress_threads_end(void);
+
+/*
+  Return a stream that compresses into file, or NULL, in which case
+  file is left as it is. Closing the stream writes the last frames and
+  closes file if close_file is set, else only flushes it.
+*/
+FILE *compressed_output_open(FILE *file, my_bool close_file);
+int compressed_output_close(FILE *stream);
+
+C_MODE_END
+
+#endif /* _compressed_output_h_ */
@@ -0,0 +1,67 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Scanning of result values for the bytes the result printers of the
+  mysql client escape.
+*/
+
+#include <my_global.h>
+#include <m_string.h>
+#include "escape_set.h"
+
+void init_escape_set(ESCAPE_SET *set, const char *chars, uint count)
+{
+  DBUG_ASSERT(count <= ESCAPE_SET_MAX);
+  bzero((char*) set, sizeof(*set));
+  set->count= count;
+  for (uint i= 0; i < count; i++)
+  {
+    set->repeated[i]= 0x0101010101010101ULL * (uchar) chars[i];
+    set->member[(uchar) chars[i]]= 1;
+  }
+}
+
+
+const char *find_escape_char(const ESCAPE_SET *set, const char *pos,
+                             const char *end)
+{
+  while (pos < end)
+  {
+    const char *stop= end;
+    if (end - pos >= 8)
+    {
+      ulonglong word, hit= 0;
+      memcpy(&word, pos, 8);
+      for (uint i= 0; i < set->count; i++)
+      {
+        /* Sets the high bit of every byte that is zero after the xor */
+        ulonglong x= word ^ set->repeated[i];
+        hit|= (x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL;
+      }
+      if (!hit)
+      {
+        pos+= 8;
+        continue;
+      }
+      stop= pos + 8;
+    }
+    for (; pos < stop; pos++)
+      if (set->member[(uchar) *pos])
+        return pos;
+  }
+  return end;
+}
@@ -0,0 +1,46 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+#ifndef _escape_set_h_
+#define _escape_set_h_
+
+/*
+  A set of bytes that a result printer has to replace. find_escape_char()
+  compares eight bytes at a time against every member of the set and only
+  looks at single bytes in a word that may contain a hit, so long runs of
+  plain text are copied to the pager in one piece.
+*/
+
+#define ESCAPE_SET_MAX 5
+
+typedef struct st_escape_set
+{
+  uint count;
+  ulonglong repeated[ESCAPE_SET_MAX];     /* member byte in every byte */
+  char member[256];
+} ESCAPE_SET;
+
+/* chars may hold '\0', so count is given */
+void init_escape_set(ESCAPE_SET *set, const char *chars, uint count);
+
+/*
+  Find the first byte of [pos, end) that is a member of set. Return a
+  pointer to it, or end if there is none.
+*/
+const char *find_escape_char(const ESCAPE_SET *set, const char *pos,
+                             const char *end);
+
+#endif /* _escape_set_h_ */
@@ -32,6 +32,10 @@ typedef struct st_line_buffer
   ulong read_length;		/* Length of last read string */
   int error;
   bool truncated;
+  char *map;			/* Input file mapped into memory, or 0 */
+  size_t map_length;		/* Length of the mapping */
+  size_t map_pos;		/* Start of next line in the mapping */
+  size_t map_released;		/* Bytes of the mapping given back */
 } LINE_BUFFER;
 
 extern LINE_BUFFER *batch_readline_init(ulong max_size,FILE *file);
@@ -43,6 +43,7 @@
 #include "my_readline.h"
 #include <signal.h>
 #include <violite.h>
+#include <hash.h>
 #include <my_sys.h>
 #include <source_revision.h>
 #if defined(USE_LIBEDIT_INTERFACE) && defined(HAVE_LOCALE_H)
@@ -50,6 +51,7 @@
 #endif
 
 #include <ob_load_balance.h>
+#include <ma_pvio.h>
 #include <map>
 
 const char *VER = OBCLIENT_VERSION;
@@ -63,6 +65,9 @@ static char *server_version= NULL;
 /* Array of options to pass to libemysqld */
 #define MAX_SERVER_ARGS               64
 
+/* Most rows fetched per round trip with --cursor-fetch */
+#define CURSOR_MAX_PREFETCH           65536
+
 #include "sql_string.h"
 
 extern "C" {
@@ -124,6 +129,8 @@ static void my_vidattr(chtype attrs)
 #endif
 
 #include "completion_hash.h"
+#include "statement_kind.h"
+#include "escape_set.h"
 #include <welcome_copyright_notice.h> // OB_WELCOME_COPYRIGHT_NOTICE
 
 #define PROMPT_CHAR '\\'
@@ -152,7 +159,8 @@ typedef struct st_status
 } STATUS;
 
 
-static HashTable ht;
+static COMPLETION_INDEX completion_words;
+static pthread_mutex_t completion_lock;
 static char **defaults_argv;
 
 enum enum_info_type { INFO_INFO,INFO_ERROR,INFO_RESULT};
@@ -173,8 +181,43 @@ static MYSQL_BIND dbms_ps_params[2];
 static MYSQL_BIND dbms_rs_bind[2];
 static char dbms_line_buffer[32767];
 static char dbms_status;
+/*
+  Fetches the output lines in batches, joined with new lines into one
+  string. A line that doesn't fit into the string any more is returned
+  separately. The last two values are the number of lines taken off the
+  buffer and the status of the last GET_LINE.
+*/
+static const char *dbms_get_lines =
+  "declare"
+  " line varchar2(32767); st integer := 0; n integer := 0;"
+  " lines varchar2(32767); overflow_line varchar2(32767);"
+  "begin"
+  " while n < ? loop"
+  "  dbms_output.get_line(line, st);"
+  "  exit when st <> 0;"
+  "  n := n + 1;"
+  "  if line is not null then"
+  "   if nvl(lengthb(lines), 0) + lengthb(line) + 1 > 32767 then"
+  "    overflow_line := line;"
+  "    exit;"
+  "   end if;"
+  "   lines := lines || line || chr(10);"
+  "  end if;"
+  " end loop;"
+  " ? := lines; ? := overflow_line; ? := n; ? := st;"
+  "end;";
+#define DBMS_LINES_MIN 16               /* Lines asked for at first */
+#define DBMS_LINES_MAX 32768
+static MYSQL_STMT *dbms_lines_stmt = NULL;
+static my_bool dbms_lines_unsupported = 0;
+static my_bool dbms_lines_checked = 0;   /* The call has worked once */
+static MYSQL_BIND dbms_lines_params[5];
+static MYSQL_BIND dbms_lines_bind[4];
+static char dbms_lines_buffer[2][32768];
+static int dbms_lines_count, dbms_lines_status, dbms_lines_max;
 static int put_stmt_error(MYSQL *con, MYSQL_STMT *stmt);
 static void call_dbms_get_line(MYSQL *mysql, uint error);
+static my_bool call_dbms_get_lines(MYSQL *mysql, uint error);
 
 #define  NS  13
 static regex_t pl_create_sql_re;
@@ -209,6 +252,8 @@ static uint pl_type_len = 0, pl_object_len = 0, pl_schema_len = 0;
 static int handle_oracle_sql(MYSQL *mysql, String *buffer);
 
 static MYSQL mysql;			/* The connection */
+static MYSQL standby_mysql;		/* Kept open beside it, --standby-session */
+static my_bool standby_connected= 0;
 static my_bool ignore_errors=0,wait_flag=0,quick=0,
                connected=0,opt_raw_data=0,unbuffered=0,output_tables=0,
 	       opt_rehash=1,skip_updates=0,safe_updates=0,one_database=0,
@@ -228,11 +273,24 @@ static my_bool preserve_comments_invalid= 0;
 static my_bool skip_comments = 0;
 static my_bool in_com_source, aborted= 0;
 static ulong opt_max_allowed_packet, opt_net_buffer_length;
+static ulong opt_quick_lookahead, opt_pipeline_rows;
+static ulonglong opt_result_memory_limit= 0;
+static ulong opt_cursor_fetch= 0, opt_lob_chunk_size= 0;
+static uint opt_parallel= 0;
+static my_bool opt_pack_statements= 0;
+static uint opt_batch_inserts= 0;
+static char *opt_profile_file= 0;
+static my_bool opt_standby_session= 0;
+static uint opt_connect_race= 0;
+static uint opt_session_cache= 0;
+static ulong opt_session_cache_timeout;
 static uint verbose=0,opt_silent=0,opt_mysql_port=0, opt_local_infile=0;
 static uint my_end_arg;
 static char * opt_mysql_unix_port=0;
 static unsigned long connect_flag=CLIENT_INTERACTIVE;
 static my_bool opt_binary_mode= FALSE;
+static my_bool opt_completion_cache= 0;
+static ulong opt_completion_cache_age;
 static my_bool opt_connect_expired_password= FALSE;
 static int interrupted_query= 0;
 static char *current_host,*current_db,*current_user=0,*opt_password=0,
@@ -267,7 +325,10 @@ static const char *month_names[]={"Jan","Feb","Mar","Apr","May","Jun","Jul",
 static char default_pager[FN_REFLEN];
 static char pager[FN_REFLEN], outfile[FN_REFLEN];
 static FILE *PAGER, *OUTFILE;
-static MEM_ROOT hash_mem_root;
+#define TEE_BUFFER_SIZE (64*1024)
+static char tee_buffer[TEE_BUFFER_SIZE];
+static size_t tee_buffer_used= 0;
+static FILE *tee_buffer_file= NULL;    /* Stream tee_buffer is written to */
 static uint prompt_counter;
 static char delimiter[16]= DEFAULT_DELIMITER;
 static uint delimiter_length= 1;
@@ -291,6 +352,10 @@ void tee_fprintf(FILE *file, const char *fmt, ...);
 void tee_fputs(const char *s, FILE *file);
 void tee_puts(const char *s, FILE *file);
 void tee_putc(int c, FILE *file);
+static void tee_write(const char *s, size_t length, FILE *file);
+static void tee_fill(char c, size_t count, FILE *file);
+static void tee_flush();
+static void init_escape_sets();
 static void tee_print_sized_data(const char *, unsigned int, unsigned int, bool);
 /* The names of functions that actually do the manipulation. */
 static int get_options(int argc,char **argv);
@@ -302,6 +367,8 @@ static int com_quit(String *str,char*),
 	   com_help(String *str,char*), com_clear(String *str,char*),
 	   com_connect(String *str,char*), com_status(String *str,char*),
 	   com_use(String *str,char*), com_source(String *str, char*),
+	   com_parallel_source(String *str, char*),
+	   com_profile(String *str, char*),
 	   com_rehash(String *str, char*), com_tee(String *str, char*),
            com_notee(String *str, char*), com_charset(String *str,char*),
            com_prompt(String *str, char*), com_delimiter(String *str, char*),
@@ -314,6 +381,7 @@ static int com_nopager(String *str, char*), com_pager(String *str, char*),
 
 static int read_and_execute(bool interactive);
 static int sql_connect(char *host,char *database,char *user,char *password, uint silent);
+static int sql_real_connect(char *host,char *database,char *user,char *password, uint silent);
 static const char *server_version_string(MYSQL *mysql);
 static int put_info(const char *str,INFO_TYPE info,uint error=0,
                     const char *sql_state = 0, my_bool oracle_mode = FALSE);
@@ -324,6 +392,25 @@ static void init_pager();
 static void end_pager();
 static void init_tee(const char *);
 static void end_tee();
+#ifdef HAVE_READLINE
+static void completion_build_end(bool wait);
+#endif
+static void set_connect_options(MYSQL *con, String &socket5_proxy,
+                                const char *charset= NullS);
+static const char *connect_charset_name();
+static void standby_open();
+static void standby_close();
+static void session_cache_put(MYSQL *con);
+static void session_cache_free();
+static bool parallel_dispatch(String *buffer, int *error);
+static bool pack_statement(String *buffer, int *error);
+static int pack_flush();
+static bool batch_insert(String *buffer, int *error);
+static int batch_flush();
+static void profile_record();
+static void profile_write();
+static int parallel_begin(uint connections);
+static int parallel_end();
 static const char* construct_prompt();
 enum get_arg_mode { CHECK, GET, GET_NEXT};
 static int rewrite_by_oracle(char *line);
@@ -362,6 +449,7 @@ static char* get_trim_comment_sql(const char* str, int len);
 static my_bool is_oracle_pl_escape_sql(const char *str, int len);
 static my_bool is_termout_oracle_enable(MYSQL *mysql);
 static int run_oracle_command(String *buffer, const char *line);
+static bool may_be_oracle_command(String &buffer);
 static int set_cmd_oracle(const char *str, int len);
 static int set_param_oracle(const char *str, int len);
 static void set_key_value(const char *strkey, const char *strval);
@@ -378,6 +466,34 @@ static char* get_login_info();
 #define IS_CMD_SLASH 1    //oracle /
 #define IS_CMD_LINE 2     //\s,\h...
 static String last_execute_buffer;
+
+/* Statements collected by --pack-statements */
+typedef struct st_packed_statement
+{
+  size_t offset;                /* Start in pack_buffer */
+  ulong line;                   /* Line the statement started on */
+} PACKED_STATEMENT;
+
+static String pack_buffer;
+static DYNAMIC_ARRAY pack_statements;
+static char *pack_file_name;
+
+/* Rows of the INSERT statements collected by --batch-inserts */
+typedef struct st_batched_row
+{
+  size_t offset;                /* Start of the row in batch_buffer */
+  ulong line;                   /* Line the statement started on */
+} BATCHED_ROW;
+
+static String batch_buffer;     /* The common head, then the rows */
+static size_t batch_head_length;
+static DYNAMIC_ARRAY batch_rows;
+static char *batch_file_name;
+/* Head and database of the last table checked for transactions */
+static String batch_checked_head;
+static char batch_checked_db[NAME_LEN + 1];
+static bool batch_checked_transactional;
+
 static int is_cmd_line(char *pos, size_t len);
 
 #define COMMAND_MAX 50
@@ -387,9 +503,74 @@ static char disable_comands[COMMAND_MAX][COMMAND_NAME_LEN] = { 0 };
 static int disable_command_count = 0;
 static my_bool is_command_valid(const char* name);
 
-static std::map<void*, void*> global_define_map;
+/* DEFINE variables of Oracle mode, found without regard to case */
+typedef struct st_define_var
+{
+  char *name;
+  size_t name_length;
+  char *value;
+  size_t value_length;
+} DEFINE_VAR;
+
+static HASH global_define_hash;
 static void free_global_define_map();
 
+/* How a result cursor reads LOB columns, see result_cursor_open() */
+enum enum_lob_fetch { LOB_WHOLE, LOB_CUT, LOB_PIECES };
+
+/*
+  Result of a statement run with --cursor-fetch or --lob-chunk-size,
+  see result_cursor_open()
+*/
+typedef struct st_result_cursor
+{
+  MYSQL_STMT *stmt;
+  MYSQL_RES *metadata;
+  MYSQL_BIND *bind;
+  MYSQL_ROW row;
+  ulong *lengths;
+  my_bool *is_null, *truncated;
+  uint num_fields;
+  ulong *lob_lengths;                   /* Of LOBs printed piece by piece */
+  ulong lob_buffer;                     /* Bytes of a LOB read at a time */
+  enum enum_lob_fetch lob_fetch;
+  ulong lob_cut;                        /* LOB values cut, with LOB_CUT */
+  ulong prefetch;                       /* Rows per round trip */
+  ulong batch_rows;                     /* Rows of the batch printed so far */
+  ulonglong batch_bytes;
+  ulonglong batch_start;
+} RESULT_CURSOR;
+
+static RESULT_CURSOR cursor, *result_cursor= NULL;
+
+/* Phases of a statement timed by com_go(), see profile_record() */
+enum enum_profile_phase
+{
+  PROFILE_SEND, PROFILE_SERVER, PROFILE_TRANSFER, PROFILE_RENDER,
+  PROFILE_TOTAL, PROFILE_PHASES
+};
+
+/*
+  Log-linear buckets of microseconds: values below 16 have a bucket each,
+  above that every power of two is split in 16, for 1/16 precision.
+*/
+#define PROFILE_SUB_BUCKETS  16
+#define PROFILE_BUCKETS      (PROFILE_SUB_BUCKETS * 61)
+
+typedef struct st_profile_histogram
+{
+  ulonglong count, sum, max;
+  ulonglong buckets[PROFILE_BUCKETS];
+} PROFILE_HISTOGRAM;
+
+static struct st_statement_profile
+{
+  /* Times of the statement being run, from microsecond_interval_timer() */
+  ulonglong start, sent, first, last_row;
+  ulonglong last[PROFILE_PHASES];       /* Of the last statement */
+  PROFILE_HISTOGRAM phases[PROFILE_PHASES];
+} statement_profile;
+
 static char* ob_proxy_user_str = 0;
 static char* ob_socket5_proxy_str = 0;
 
@@ -436,7 +617,14 @@ static COMMANDS commands[] = {
     "Set PAGER [to_pager]. Print the query results via PAGER." , NULL},
 #endif
   { "print",  'p', com_print,  0, "Print current command." , NULL},
+  { "profile", 'f', com_profile, 1,
+    "Show the time taken by each phase of the statements run so far. "
+    "Takes an optional 'reset' to start over.", NULL},
   { "prompt", 'R', com_prompt, 1, "Change your mysql prompt.", NULL},
+  { "psource", 0, com_parallel_source, 1,
+    "Execute an SQL script file on several connections at once. Takes an "
+    "optional number of connections, default --parallel, and a file name.",
+    NULL},
   { "quit",   'q', com_quit,   0, "Quit mysql." , NULL},
   { "rehash", '#', com_rehash, 0, "Rebuild completion hash." , NULL},
   { "source", '.', com_source, 1,
@@ -1220,6 +1408,12 @@ static void print_table_data_html(MYSQL_RES *result);
 static void print_table_data_xml(MYSQL_RES *result);
 static void print_tab_data(MYSQL_RES *result);
 static void print_table_data_vertically(MYSQL_RES *result);
+static void row_pipeline_start(MYSQL_RES *result);
+static bool row_pipeline_end();
+static int result_store_read(MYSQL_RES **result);
+static void result_store_end();
+static int result_cursor_open(String *buffer);
+static void result_cursor_end();
 static void print_warnings(void);
 static void end_timer(ulonglong start_time, char *buff);
 static void nice_time(double sec,char *buff,bool part_second);
@@ -1316,6 +1510,25 @@ void init_dbms_output(void)
   dbms_rs_bind[1].buffer = &dbms_status;
   dbms_rs_bind[1].buffer_length = sizeof(dbms_status);
 
+  memset(&dbms_lines_params, 0, sizeof(dbms_lines_params));
+  dbms_lines_params[0].buffer_type = MYSQL_TYPE_LONG;
+  dbms_lines_params[0].buffer = &dbms_lines_max;
+  for (int i = 1; i < 5; i++)
+    dbms_lines_params[i].buffer_type = MYSQL_TYPE_NULL;
+
+  memset(&dbms_lines_bind, 0, sizeof(dbms_lines_bind));
+  for (int i = 0; i < 2; i++) {
+    dbms_lines_bind[i].buffer_type = MYSQL_TYPE_STRING;
+    dbms_lines_bind[i].buffer = dbms_lines_buffer[i];
+    dbms_lines_bind[i].buffer_length = sizeof(dbms_lines_buffer[i]);
+    dbms_lines_bind[i].is_null = &dbms_lines_bind[i].is_null_value;
+    dbms_lines_bind[i].length = &dbms_lines_bind[i].length_value;
+  }
+  dbms_lines_bind[2].buffer_type = MYSQL_TYPE_LONG;
+  dbms_lines_bind[2].buffer = &dbms_lines_count;
+  dbms_lines_bind[3].buffer_type = MYSQL_TYPE_LONG;
+  dbms_lines_bind[3].buffer = &dbms_lines_status;
+
   dbms_enable_buffer.append(dbms_enable_sql, strlen(dbms_enable_sql));
   dbms_disable_buffer.append(dbms_disable_sql, strlen(dbms_disable_sql));
 }
@@ -1503,6 +1716,7 @@ int main(int argc,char *argv[])
   charset_index= get_command_index('C');
   delimiter_index= get_command_index('d');
   delimiter_str= delimiter;
+  init_escape_sets();
   default_prompt = my_strdup(getenv("MYSQL_PS1") ? 
 			     getenv("MYSQL_PS1") : "obclient(\\u@\\T)[\\d]> ",MYF(MY_WME));
   current_prompt = my_strdup(default_prompt,MYF(MY_WME));
@@ -1595,8 +1809,8 @@ int main(int argc,char *argv[])
   preserve_comments = (skip_comments ? 0:1);
   sf_leaking_memory= 0;
   glob_buffer.realloc(512);
-  completion_hash_init(&ht, 128);
-  init_alloc_root(&hash_mem_root, "hash", 16384, 0, MYF(0));
+  completion_index_init(&completion_words);
+  pthread_mutex_init(&completion_lock, NULL);
   if (sql_connect(current_host,current_db,current_user,opt_password, opt_silent))
   {
     quick= 1;					// Avoid history
@@ -1701,7 +1915,14 @@ int main(int argc,char *argv[])
   //start glogin.sql
   start_login_sql(&mysql, &glob_buffer, get_login_sql_path());
 
-  status.exit_status= read_and_execute(!status.batch);
+  if (status.batch && opt_parallel > 1 && parallel_begin(opt_parallel) > 0)
+    status.exit_status= 1;
+  else
+  {
+    status.exit_status= read_and_execute(!status.batch);
+    if (parallel_end() > 0)
+      status.exit_status= 1;
+  }
   if (opt_outfile)
     end_tee();
   mysql_end(0);
@@ -1727,6 +1948,9 @@ sig_handler mysql_end(int sig)
 #endif
 
   mysql_close(&mysql);
+  standby_close();
+  session_cache_free();
+  profile_write();
 #ifdef HAVE_READLINE
   if (!status.batch && !quick && !opt_html && !opt_xml &&
       histfile && histfile[0])
@@ -1738,14 +1962,19 @@ sig_handler mysql_end(int sig)
       my_rename(histfile_tmp, histfile, MYF(MY_WME));
   }
   batch_readline_end(status.line_buff);
-  completion_hash_free(&ht);
-  free_root(&hash_mem_root,MYF(0));
+  completion_build_end(1);
+  completion_index_free(&completion_words);
 
 #endif
   if (sig >= 0)
     put_info(sig ? "Aborted" : "Bye", INFO_RESULT);
   glob_buffer.free();
   old_buffer.free();
+  pack_buffer.free();
+  delete_dynamic(&pack_statements);
+  batch_buffer.free();
+  batch_checked_head.free();
+  delete_dynamic(&batch_rows);
   processed_prompt.free();
   my_free(server_version);
   my_free(opt_password);
@@ -1776,8 +2005,9 @@ sig_handler mysql_end(int sig)
 /*
   set connection-specific options and call mysql_real_connect
 */
-static bool do_connect(MYSQL *mysql, const char *host, const char *user,
-                       const char *password, const char *database, ulong flags)
+static bool do_connect(MYSQL *mysql, const char *host, uint port,
+                       const char *user, const char *password,
+                       const char *database, ulong flags)
 {
   bool is_success = 0;
   if (opt_secure_auth)
@@ -1813,10 +2043,8 @@ static bool do_connect(MYSQL *mysql, const char *host, const char *user,
   if (ob_proxy_user_str && ob_proxy_user_str[0]) {
     mysql_options(mysql, OB_OPT_PROXY_USER, ob_proxy_user_str);
   }
-  if (mysql_real_connect(mysql, host, user, password, database, opt_mysql_port, opt_mysql_unix_port, flags)) {
+  if (mysql_real_connect(mysql, host, user, password, database, port, opt_mysql_unix_port, flags)) {
     is_success = 1;
-    current_host_success = my_strdup(host?host:"", MYF(MY_WME));
-    current_port_success = opt_mysql_port;
   }
   return is_success;
 }
@@ -1841,13 +2069,6 @@ sig_handler handle_sigint(int sig)
     goto err;
   }
 
-  kill_mysql= mysql_init(kill_mysql);
-  if (!do_connect(kill_mysql,current_host, current_user, opt_password, "", 0))
-  {
-    tee_fprintf(stdout, "Ctrl-C -- sorry, cannot connect to server to kill query, giving up ...\n");
-    goto err;
-  }
-
   /* First time try to kill the query, second time the connection */
   interrupted_query++;
 
@@ -1862,8 +2083,24 @@ sig_handler handle_sigint(int sig)
   if (verbose)
     tee_fprintf(stdout, "Ctrl-C -- sending \"%s\" to server ...\n",
                 kill_buffer);
-  mysql_real_query(kill_mysql, kill_buffer, (uint) strlen(kill_buffer));
-  mysql_close(kill_mysql);
+
+  /* The standby session is logged in to the same server already */
+  if (standby_connected &&
+      mysql_real_query(&standby_mysql, kill_buffer, (uint) strlen(kill_buffer)) &&
+      mysql_errno(&standby_mysql) >= CR_MIN_ERROR)
+    standby_close();
+  if (!standby_connected)
+  {
+    kill_mysql= mysql_init(kill_mysql);
+    if (!do_connect(kill_mysql, current_host, opt_mysql_port, current_user,
+                    opt_password, "", 0))
+    {
+      tee_fprintf(stdout, "Ctrl-C -- sorry, cannot connect to server to kill query, giving up ...\n");
+      goto err;
+    }
+    mysql_real_query(kill_mysql, kill_buffer, (uint) strlen(kill_buffer));
+    mysql_close(kill_mysql);
+  }
   tee_fprintf(stdout, "Ctrl-C -- query killed. Continuing normally.\n");
   if (in_com_source)
     aborted= 1;                                 // Abort source command
@@ -1924,6 +2161,17 @@ static struct my_option my_long_options[] =
   {"batch", 'B',
    "Don't use history file. Disable interactive behavior. (Enables --silent.)",
    0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"batch-inserts", OPT_BATCH_INSERTS,
+   "In batch mode, join consecutive single row INSERT and REPLACE "
+   "statements of literal values with the same table and columns into "
+   "multi-row statements of up to this many rows and --max-allowed-packet "
+   "bytes. Only for transactional tables: when such a statement fails, "
+   "its rows are run one by one, so that each error is reported against "
+   "the line of its row and, with --force, the other rows are inserted. "
+   "Not used in Oracle mode, with --parallel or with --show-warnings. 0 "
+   "runs each statement alone.",
+   &opt_batch_inserts, &opt_batch_inserts, 0, GET_UINT, REQUIRED_ARG, 0, 0,
+   UINT_MAX, 0, 1, 0},
   {"binary-as-hex", 0, "Print binary data as hex", &opt_binhex, &opt_binhex,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"character-sets-dir", OPT_CHARSETS_DIR,
@@ -1939,9 +2187,41 @@ static struct my_option my_long_options[] =
    " The default is comments, disable with --skip-comments", 
    &skip_comments, &skip_comments,
    0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"completion-cache", OPT_COMPLETION_CACHE,
+   "Keep the names used for table and column completion in "
+   "~/.obclient_completion, and take them from there when connecting to the "
+   "same server and database again. 'rehash' reads them from the server. "
+   "The names of every table and column are written to the file, so this "
+   "is off by default.",
+   &opt_completion_cache, &opt_completion_cache, 0, GET_BOOL, NO_ARG, 0, 0,
+   0, 0, 0, 0},
+  {"completion-cache-age", OPT_COMPLETION_CACHE_AGE,
+   "Seconds the names of --completion-cache are used for. Older names are "
+   "read from the server again, so that tables created or altered since "
+   "are completed.",
+   &opt_completion_cache_age, &opt_completion_cache_age, 0, GET_ULONG,
+   REQUIRED_ARG, 3600, 0, 30*86400, 0, 1, 0},
   {"compress", 'C', "Use compression in server/client protocol.",
    &opt_compress, &opt_compress, 0, GET_BOOL, NO_ARG, 0, 0, 0,
    0, 0, 0},
+  {"connect-race", OPT_CONNECT_RACE,
+   "Number of hosts of a host list (-hhost1:port1,host2:port2) that are "
+   "logged in to at the same time, started 200 ms apart. The first session "
+   "to be opened is kept, and hosts that fail are blacklisted for a "
+   "minute. Not with --ob-service-name. With 0 or 1 the hosts are tried "
+   "one after the other.",
+   &opt_connect_race, &opt_connect_race, 0, GET_UINT, REQUIRED_ARG, 0, 0, 64,
+   0, 1, 0},
+  {"cursor-fetch", OPT_CURSOR_FETCH,
+   "Run SELECT and WITH statements as prepared statements with a read-only "
+   "server cursor, and fetch this many rows per round trip to begin with. "
+   "The number then follows the size of the rows and the time taken to "
+   "print them. Only in MySQL mode, and only for results of strings, "
+   "DECIMAL and integers: FLOAT, DOUBLE, temporal and ZEROFILL columns "
+   "would print differently, so such results are read as usual. 0 reads "
+   "results as usual.",
+   &opt_cursor_fetch, &opt_cursor_fetch, 0, GET_ULONG, REQUIRED_ARG, 0, 0,
+   CURSOR_MAX_PREFETCH, 0, 1, 0},
 #ifdef DBUG_OFF
   {"debug", '#', "This is a non-debug version. Catch this and exit.",
    0,0, 0, GET_DISABLED, OPT_ARG, 0, 0, 0, 0, 0, 0},
@@ -1987,6 +2267,17 @@ static struct my_option my_long_options[] =
    GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
   {"local-infile", OPT_LOCAL_INFILE, "Enable/disable LOAD DATA LOCAL INFILE.",
    &opt_local_infile, &opt_local_infile, 0, GET_BOOL, OPT_ARG, 1, 0, 0, 0, 0, 0},
+  {"lob-chunk-size", OPT_LOB_CHUNK_SIZE,
+   "In Oracle mode, run SELECT and WITH statements that return CLOB or BLOB "
+   "columns, and otherwise only character and NUMBER columns, through a "
+   "server cursor, and print the LOBs this many bytes at a time. The "
+   "client library still receives each row whole, so this limits the "
+   "copies made for printing, not the memory a row takes. In batch mode "
+   "with tab separated output the pieces are written one after the "
+   "other; on a terminal only the part of a LOB that fits its column is "
+   "printed, and a cut CLOB ends with '...'. 0 prints LOBs whole.",
+   &opt_lob_chunk_size, &opt_lob_chunk_size, 0, GET_ULONG, REQUIRED_ARG, 0, 0,
+   1024*1024*1024, 0, 1024, 0},
   {"no-beep", 'b', "Turn off beep on error.", &opt_nobeep,
    &opt_nobeep, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"host", 'h', "Connect to host.", &current_host,
@@ -2015,6 +2306,13 @@ static struct my_option my_long_options[] =
    "Ignore statements except those that occur while the default "
    "database is the one named at the command line.",
    0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"pack-statements", OPT_PACK_STATEMENTS,
+   "In batch mode, send consecutive INSERT, REPLACE, UPDATE and DELETE "
+   "statements together as one multi-statement query of up to "
+   "--max-allowed-packet bytes, which must not exceed the server's "
+   "max_allowed_packet. Not used with --parallel or --show-warnings.",
+   &opt_pack_statements, &opt_pack_statements, 0, GET_BOOL, NO_ARG,
+   0, 0, 0, 0, 0, 0},
 #ifdef USE_POPEN
   {"pager", OPT_PAGER,
    "Pager to use to display results. If you don't supply an option, the "
@@ -2024,9 +2322,25 @@ static struct my_option my_long_options[] =
    "This option is disabled by default.",
    0, 0, 0, GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
 #endif
+  {"parallel", OPT_PARALLEL,
+   "Execute the statements of a script on this many connections at once. "
+   "Statements on the same table keep their order, while statements that "
+   "can't be assigned to a table, and transactions, run alone on the main "
+   "connection. Tables the script gives foreign keys stay on the main "
+   "connection; to fill tables with foreign keys made otherwise, the "
+   "script must set foreign_key_checks=0 as mysqldump does. Used in batch "
+   "mode and by psource.",
+   &opt_parallel, &opt_parallel, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 256, 0, 1, 0},
   {"password", 'p',
    "Password to use when connecting to server. If password is not given it's asked from the tty.",
    0, 0, 0, GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
+  {"pipeline-rows", OPT_PIPELINE_ROWS,
+   "With --quick, read the result in a separate thread and pass it to the "
+   "printing thread in batches of this many rows, so that fetching and "
+   "formatting overlap. 0 reads and prints in the same thread.",
+   &opt_pipeline_rows, &opt_pipeline_rows, 0, GET_ULONG, REQUIRED_ARG,
+   0, 0, 1024*1024L, 0, 1, 0},
 #ifdef __WIN__
   {"pipe", 'W', "Use named pipes to connect to server.", 0, 0, 0, GET_NO_ARG,
    NO_ARG, 0, 0, 0, 0, 0, 0},
@@ -2043,6 +2357,11 @@ static struct my_option my_long_options[] =
    "Get progress reports for long running commands (like ALTER TABLE)",
    &opt_progress_reports, &opt_progress_reports, 0, GET_BOOL, NO_ARG, 1, 0,
    0, 0, 0, 0},
+  {"profile-file", OPT_PROFILE_FILE,
+   "Write the statement timings that the profile command shows to this "
+   "file as JSON on exit, histograms included.",
+   &opt_profile_file, &opt_profile_file, 0, GET_STR, REQUIRED_ARG, 0, 0, 0,
+   0, 0, 0},
   {"prompt", OPT_PROMPT, "Set the command line prompt to this value.",
    &current_prompt, &current_prompt, 0, GET_STR_ALLOC,
    REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
@@ -2053,17 +2372,35 @@ static struct my_option my_long_options[] =
    "Don't cache result, print it row by row. This may slow down the server "
    "if the output is suspended. Doesn't use history file.",
    &quick, &quick, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"quick-lookahead", OPT_QUICK_LOOKAHEAD,
+   "Number of rows read ahead with --quick to size the columns of table "
+   "output. Rows are printed as soon as the window is filled. 0 sizes the "
+   "columns from the declared column lengths.",
+   &opt_quick_lookahead, &opt_quick_lookahead, 0, GET_ULONG, REQUIRED_ARG,
+   1000, 0, 1024*1024L, 0, 1, 0},
   {"raw", 'r', "Write fields without conversion. Used with --batch.",
    &opt_raw_data, &opt_raw_data, 0, GET_BOOL, NO_ARG, 0, 0, 0,
    0, 0, 0},
   {"reconnect", OPT_RECONNECT, "Reconnect if the connection is lost. Disable "
    "with --disable-reconnect. This option is enabled by default.",
    &opt_reconnect, &opt_reconnect, 0, GET_BOOL, NO_ARG, 1, 0, 0, 0, 0, 0},
+  {"result-memory-limit", OPT_RESULT_MEMORY_LIMIT,
+   "Bytes of a result kept in memory before further rows are written to a "
+   "temporary file, to be printed from there. Does not apply with --quick. "
+   "0 keeps the whole result in memory.",
+   &opt_result_memory_limit, &opt_result_memory_limit, 0, GET_ULL,
+   REQUIRED_ARG, 0, 0, ~(ulonglong) 0, 0, 1024, 0},
   {"silent", 's', "Be more silent. Print results with a tab as separator, "
    "each row on new line.", 0, 0, 0, GET_NO_ARG, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"socket", 'S', "The socket file to use for connection.",
    &opt_mysql_unix_port, &opt_mysql_unix_port, 0, GET_STR_ALLOC,
    REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"standby-session", OPT_STANDBY_SESSION,
+   "Keep a second session logged in to the server of the main one. Ctrl-C "
+   "sends KILL QUERY through it, and when the connection is lost while it "
+   "still answers, it becomes the main session and another is opened.",
+   &opt_standby_session, &opt_standby_session, 0, GET_BOOL, NO_ARG, 0, 0, 0,
+   0, 0, 0},
 #include "sslopt-longopts.h"
   {"table", 't', "Output in table format.", &output_tables,
    &output_tables, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
@@ -2114,6 +2451,16 @@ static struct my_option my_long_options[] =
     &opt_secure_auth, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
   {"server-arg", OPT_SERVER_ARG, "Send embedded server this as a parameter.",
    0, 0, 0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"session-cache", OPT_SESSION_CACHE,
+   "Number of sessions kept open when connect switches to another user or "
+   "tenant. Connecting again with the same host, port, user, password and "
+   "database reuses the session instead of logging in. 0 disables.",
+   &opt_session_cache, &opt_session_cache, 0, GET_UINT, REQUIRED_ARG,
+   0, 0, 64, 0, 1, 0},
+  {"session-cache-timeout", OPT_SESSION_CACHE_TIMEOUT,
+   "Seconds a session of --session-cache is kept open while unused.",
+   &opt_session_cache_timeout, &opt_session_cache_timeout, 0, GET_ULONG,
+   REQUIRED_ARG, 300, 1, 86400, 0, 1, 0},
   {"show-warnings", OPT_SHOW_WARNINGS, "Show warnings after every statement.",
     &show_warnings, &show_warnings, 0, GET_BOOL, NO_ARG,
     0, 0, 0, 0, 0, 0},
@@ -2565,14 +2912,16 @@ static int read_and_execute(bool interactive)
       char *p = line;
       while (my_isspace(charset_info, *p)) p++;
 
-      if (strlen(p) == 0 && !is_oracle_pl_escape_sql(glob_buffer.c_ptr_safe(), glob_buffer.length())) {
+      if (strlen(p) == 0 && !is_pl_escape_sql &&
+          !is_oracle_pl_escape_sql(glob_buffer.c_ptr_safe(), glob_buffer.length())) {
         glob_buffer.length(0);
         continue;
       }
     }
 
     //support oracle mode command
-    if (last_session_mode && !ml_comment && !in_string && !is_pl_escape_sql) {
+    if (last_session_mode && !ml_comment && !in_string && !is_pl_escape_sql &&
+        may_be_oracle_command(glob_buffer)) {
       int ret = run_oracle_command(&glob_buffer, line);
       if (CMD_STATE_RUNED == ret) {
         continue;
@@ -2589,7 +2938,8 @@ static int read_and_execute(bool interactive)
     if ((named_cmds || glob_buffer.is_empty())
 	&& !ml_comment && !in_string && (com= find_command(line)))
     {
-      if (com->cmdstr && ((*com->func)(&glob_buffer,com->cmdstr) > 0))
+      if (com->cmdstr && (pack_flush() > 0 ||
+                          (*com->func)(&glob_buffer,com->cmdstr) > 0))
 	break;
       if (glob_buffer.is_empty())		// If buffer was emptied
 	in_string=0;
@@ -2615,6 +2965,9 @@ static int read_and_execute(bool interactive)
 	status.exit_status=0;
     }
   }
+  /* Send the statements still packed, and stop at an error in them */
+  if (pack_flush() > 0)
+    status.exit_status= 1;
 
 #if defined(__WIN__)
   buffer.free();
@@ -2763,6 +3116,85 @@ static COMMANDS *find_command(char *name)
   DBUG_RETURN((COMMANDS *) 0);
 }
 
+/**
+  Find the first word of the statement in buffer, after leading comments.
+
+  @param buffer  statement collected so far
+  @param length  set to the length of the word
+
+  @return the word, or NULL if buffer holds only comments
+*/
+
+static const char *statement_first_word(String &buffer, size_t *length)
+{
+  const char *pos= get_trim_comment_sql(buffer.c_ptr(), buffer.length());
+  const char *end= buffer.ptr() + buffer.length(), *word;
+
+  if (!pos)
+    return NULL;
+  while (pos < end && my_isspace(charset_info, *pos))
+    pos++;
+  for (word= pos; pos < end && !my_isspace(charset_info, *pos); pos++)
+    ;
+  *length= (size_t) (pos - word);
+  return word;
+}
+
+
+/**
+  Check whether find_command() may take the statement in buffer for a
+  client command, by comparing only its first word with the command names.
+
+  add_line() asks this after every line it adds, so that the lines of a
+  long statement don't cause the whole statement to be copied and scanned
+  by find_command() again and again.
+*/
+
+static bool may_be_command(String &buffer)
+{
+  size_t length;
+  const char *word= statement_first_word(buffer, &length);
+
+  if (!word)
+    return 0;                                   // Only comments
+  if (word + length == buffer.ptr() + buffer.length())
+    return 1;                                   // First word may go on
+  for (uint i= 0; commands[i].func; i++)
+  {
+    if (!my_strnncoll(&my_charset_latin1, (uchar*) word, length,
+                      (uchar*) commands[i].name, strlen(commands[i].name)))
+      return 1;
+  }
+  return 0;
+}
+
+
+/**
+  Same as may_be_command() for the commands of run_oracle_command().
+  An empty buffer always qualifies as the command is then on the new line.
+*/
+
+static bool may_be_oracle_command(String &buffer)
+{
+  static const struct { const char *name; size_t min_length; } names[]=
+  {{"prompt", 3}, {"define", 3}, {"execute", 4}};
+  size_t length;
+  const char *word;
+
+  if (buffer.is_empty() || !(word= statement_first_word(buffer, &length)))
+    return 1;
+  if (word + length == buffer.ptr() + buffer.length())
+    return 1;
+  for (uint i= 0; i < array_elements(names); i++)
+  {
+    if (length >= names[i].min_length && length <= strlen(names[i].name) &&
+        !strncasecmp(names[i].name, word, length))
+      return 1;
+  }
+  return 0;
+}
+
+
 static bool add_line(String &buffer, char *line, size_t line_length,
   char *in_string, bool *ml_comment, bool *is_pl_escape_sql, bool truncated)
 {
@@ -2884,7 +3316,7 @@ static bool add_line(String &buffer, char *line, size_t line_length,
           out= line;
         }
         
-        if ((*com->func)(&buffer,pos-1) > 0)
+        if (pack_flush() > 0 || (*com->func)(&buffer,pos-1) > 0)
           DBUG_RETURN(1);                       // Quit
 
         //deom: /* abc */ \s
@@ -2987,7 +3419,7 @@ static bool add_line(String &buffer, char *line, size_t line_length,
 
       if ((com= find_command(buffer.c_ptr())))
       {
-        if ((*com->func)(&buffer, com->cmdstr) > 0)
+        if (pack_flush() > 0 || (*com->func)(&buffer, com->cmdstr) > 0)
           DBUG_RETURN(1);                       // Quit 
       }
       else
@@ -3137,11 +3569,16 @@ static bool add_line(String &buffer, char *line, size_t line_length,
       length++;
       add_n = 1;
     }
+    /*
+      Grow the buffer geometrically, a long PL/SQL block is added line by
+      line and would otherwise be copied again every few lines.
+    */
     if (buffer.length() + length >= buffer.alloced_length())
-      buffer.realloc(buffer.length()+length+IO_SIZE);
+      buffer.realloc(MY_MAX(buffer.length() + length + IO_SIZE,
+                            (size_t) buffer.alloced_length() * 2));
     if ((!*ml_comment || preserve_comments) && buffer.append(line, length))
       DBUG_RETURN(1);
-    if (!buffer.is_empty()) {
+    if (!buffer.is_empty() && may_be_command(buffer)) {
       String tmpbuf;
       tmpbuf.append(buffer);
       if (add_n) {
@@ -3149,7 +3586,7 @@ static bool add_line(String &buffer, char *line, size_t line_length,
         p[tmpbuf.length()-1] = 0;
       }
       if (NULL!=(com = find_command(tmpbuf.c_ptr()))) {
-        if ((*com->func)(&tmpbuf, com->cmdstr) > 0)
+        if (pack_flush() > 0 || (*com->func)(&tmpbuf, com->cmdstr) > 0)
           DBUG_RETURN(1);
         buffer.length(0);
       }
@@ -3304,6 +3741,7 @@ static char **new_mysql_completion(const char *text,
                                    int start __attribute__((unused)),
                                    int end __attribute__((unused)))
 {
+  completion_build_end(0);
   if (!status.batch && !quick)
 #if defined(USE_NEW_READLINE_INTERFACE)
     return rl_completion_matches(text, new_command_generator);
@@ -3316,203 +3754,414 @@ static char **new_mysql_completion(const char *text,
 
 static char *new_command_generator(const char *text,int state)
 {
-  static int textlen;
-  char *ptr;
-  static Bucket *b;
-  static entry *e;
-  static uint i;
+  static uint next, end;
 
   if (!state)
-    textlen=(uint) strlen(text);
+  {
+    uint first;
+    end= find_all_matches(&completion_words, text, (uint) strlen(text),
+                          &first);
+    next= first;
+    end+= first;
+  }
+  if (next < end)
+    return strdup(completion_words.words[next++]);
+  return NullS;
+}
 
-  if (textlen>0)
-  {						/* lookup in the hash */
-    if (!state)
-    {
-      uint len;
 
-      b = find_all_matches(&ht,text,(uint) strlen(text),&len);
-      if (!b)
-	return NullS;
-      e = b->pData;
-    }
+/*
+  Completion of database, table and column names.
 
-    if (e)
-    {
-      ptr= strdup(e->str);
-      e = e->pNext;
-      return ptr;
-    }
+  A thread of its own reads the names, from the cache file written by an
+  earlier session for the same server, user and database if it is newer
+  than --completion-cache-age, else with one query on a session it opens
+  for that, and builds the word index. The main connection and the
+  prompt are free at once, and until the thread is done only the
+  commands are completed. The names are passed on as lines of the form
+
+    D <tab> database
+    T <tab> table
+    C <tab> table <tab> column
+
+  which is also the format of the cache file.
+*/
+
+typedef struct st_completion_build
+{
+  COMPLETION_INDEX index;
+  char *names;                          /* Name lines */
+  size_t names_length;
+  char cache_file[FN_REFLEN];
+  bool read_cache, write_cache;
+  /* Login of the session the names are read with */
+  char *host, *user, *password, *database, *charset;
+  uint port;
+  bool done;
+  bool threaded;                        /* Built by completion_build_thread */
+  pthread_t thread;
+} COMPLETION_BUILD;
+
+static COMPLETION_BUILD completion_build;
+static bool completion_building= 0;
+
+
+/**
+  Get the name of the cache file for the current connection and database.
+
+  @return 0 if no cache is to be used
+*/
+
+static bool completion_cache_name(char *to)
+{
+  char dir[FN_REFLEN], key[FN_REFLEN], *pos;
+  const char *home;
+
+  if (!opt_completion_cache || !(home= getenv("HOME")))
+    return 0;
+  strxnmov(dir, sizeof(dir) - 1, home, "/.obclient_completion", NullS);
+  (void) my_mkdir(dir, 0700, MYF(0));           /* May exist already */
+  my_snprintf(key, sizeof(key), "%s@%s_%u_%s",
+              current_user ? current_user : "",
+              current_host_success ? current_host_success : LOCAL_HOST,
+              current_port_success, current_db);
+  for (pos= key; *pos; pos++)
+  {
+    if (!my_isalnum(&my_charset_latin1, *pos) && !strchr(".-@", *pos))
+      *pos= '_';
+  }
+  fn_format(to, key, dir, "", MYF(0));
+  return 1;
+}
+
+
+static char *read_completion_cache(const char *name, size_t *length)
+{
+  MY_STAT stat_info;
+  File file;
+  char *buff;
+
+  *length= 0;
+  if (!my_stat(name, &stat_info, MYF(0)) ||
+      (file= my_open(name, O_RDONLY, MYF(0))) < 0)
+    return 0;
+  if ((buff= (char*) my_malloc((size_t) stat_info.st_size + 1, MYF(0))) &&
+      my_read(file, (uchar*) buff, (size_t) stat_info.st_size, MYF(MY_NABP)))
+  {
+    my_free(buff);
+    buff= 0;
   }
+  if (buff)
+    *length= (size_t) stat_info.st_size;
+  my_close(file, MYF(0));
+  return buff;
+}
+
+
+static void write_completion_cache(const char *name, const char *names,
+                                   size_t length)
+{
+  char tmp_name[FN_REFLEN];
+  File file;
+
+  my_snprintf(tmp_name, sizeof(tmp_name), "%s.%lu", name, (ulong) getpid());
+  if ((file= my_create(tmp_name, 0600, O_WRONLY | O_TRUNC, MYF(0))) < 0)
+    return;
+  if (my_write(file, (const uchar*) names, length, MYF(MY_NABP)) |
+      my_close(file, MYF(0)))
+    (void) my_delete(tmp_name, MYF(0));
   else
-  { /* traverse the entire hash, ugly but works */
+    (void) my_rename(tmp_name, name, MYF(0));
+}
 
-    if (!state)
-    {
-      /* find the first used bucket */
-      for (i=0 ; i < ht.nTableSize ; i++)
-      {
-	if (ht.arBuckets[i])
-	{
-	  b = ht.arBuckets[i];
-	  e = b->pData;
-	  break;
-	}
-      }
-    }
-    ptr= NullS;
-    while (e && !ptr)
-    {					/* find valid entry in bucket */
-      if ((uint) strlen(e->str) == b->nKeyLength)
-	ptr = strdup(e->str);
-      /* find the next used entry */
-      e = e->pNext;
-      if (!e)
-      { /* find the next used bucket */
-	b = b->pNext;
-	if (!b)
-	{
-	  for (i++ ; i<ht.nTableSize; i++)
-	  {
-	    if (ht.arBuckets[i])
-	    {
-	      b = ht.arBuckets[i];
-	      e = b->pData;
-	      break;
-	    }
-	  }
-	}
-	else
-	  e = b->pData;
-      }
+
+/* Put the commands and the name lines in cb->names into cb->index */
+
+static void add_completion_names(COMPLETION_BUILD *cb)
+{
+  char *pos= cb->names, *end= pos + cb->names_length;
+
+  for (COMMANDS *cmd= commands; cmd->name; cmd++)
+    add_word(&cb->index, cmd->name);
+
+  while (pos < end)
+  {
+    char *line= pos, *table, *column;
+    char name[NAME_LEN * 2 + 2];
+    char *eol= (char*) memchr(pos, '\n', (size_t) (end - pos));
+
+    if (!eol)
+      eol= end;                                 /* names has room for a NUL */
+    *eol= 0;
+    pos= eol + 1;
+    if (!line[0] || line[1] != '\t')
+      continue;
+    table= line + 2;
+    switch (line[0]) {
+    case 'D':
+      add_word(&cb->index, table);
+      break;
+    case 'C':
+      if (!(column= strchr(table, '\t')))
+        break;
+      *column++= 0;
+      strxnmov(name, sizeof(name) - 1, table, ".", column, NullS);
+      add_word(&cb->index, name);
+      add_word(&cb->index, column);
+      /* fall through */
+    case 'T':
+      add_word(&cb->index, table);
+      break;
     }
-    if (ptr)
-      return ptr;
   }
-  return NullS;
 }
 
 
-/* Build up the completion hash */
+/**
+  Replace the completion index with the one built by the completion thread.
+
+  @param wait  Wait for the thread; else return at once if it isn't done
+*/
 
-static void build_completion_hash(bool rehash, bool write_info)
+static void completion_build_end(bool wait)
 {
-  COMMANDS *cmd=commands;
-  MYSQL_RES *databases=0,*tables=0;
-  MYSQL_RES *fields;
-  static char ***field_names= 0;
-  MYSQL_ROW database_row,table_row;
-  MYSQL_FIELD *sql_field;
-  char buf[NAME_LEN*2+2];		 // table name plus field name plus 2
-  int i,j,num_fields;
-  DBUG_ENTER("build_completion_hash");
+  COMPLETION_BUILD *cb= &completion_build;
 
-  if (status.batch || quick || !current_db)
-    DBUG_VOID_RETURN;			// We don't need completion in batches
-  if (!rehash)
-    DBUG_VOID_RETURN;
+  if (!completion_building)
+    return;
+  if (!wait && cb->threaded)
+  {
+    bool done;
+    pthread_mutex_lock(&completion_lock);
+    done= cb->done;
+    pthread_mutex_unlock(&completion_lock);
+    if (!done)
+      return;
+  }
+  if (cb->threaded)
+    pthread_join(cb->thread, NULL);
+  my_free(cb->host);
+  my_free(cb->user);
+  my_free(cb->password);
+  my_free(cb->database);
+  my_free(cb->charset);
+  completion_building= 0;
+  completion_index_free(&completion_words);
+  completion_words= cb->index;
+}
 
-  /* Free old used memory */
-  if (field_names)
-    field_names=0;
-  completion_hash_clean(&ht);
-  free_root(&hash_mem_root,MYF(0));
 
-  /* hash this file's known subset of SQL commands */
-  while (cmd->name) {
-    add_word(&ht,(char*) cmd->name);
-    cmd++;
+static void append_completion_name(DYNAMIC_STRING *names, char type,
+                                   const char *table, const char *column)
+{
+  char head[2];
+
+  /* Such names can't be stored as lines, and are rare enough to skip */
+  if (!table || strpbrk(table, "\t\n") || (column && strpbrk(column, "\t\n")))
+    return;
+  head[0]= type;
+  head[1]= '\t';
+  dynstr_append_mem(names, head, 2);
+  dynstr_append(names, table);
+  if (column)
+  {
+    dynstr_append_mem(names, "\t", 1);
+    dynstr_append(names, column);
   }
+  dynstr_append_mem(names, "\n", 1);
+}
+
+
+/**
+  Read the databases and the tables and columns of the current database
+  from the server.
+
+  The columns come from one query on information_schema.COLUMNS, or
+  ALL_TAB_COLUMNS in Oracle mode. If that fails, only the table names are
+  read.
+
+  @param write_info  Tell the user that table information is being read,
+                     and about errors; not from the completion thread
+
+  @return the name lines, to be freed with my_free()
+*/
 
-  /* hash MySQL functions (to be implemented) */
+static char *read_completion_names(MYSQL *con, size_t *length,
+                                   bool write_info)
+{
+  DYNAMIC_STRING names;
+  MYSQL_RES *res;
+  MYSQL_ROW row;
+  const char *query= con->oracle_mode ?
+    "SELECT TABLE_NAME, COLUMN_NAME FROM ALL_TAB_COLUMNS "
+    "WHERE OWNER = SYS_CONTEXT('USERENV', 'CURRENT_SCHEMA')" :
+    "SELECT TABLE_NAME, COLUMN_NAME FROM information_schema.COLUMNS "
+    "WHERE TABLE_SCHEMA = DATABASE()";
+
+  *length= 0;
+  if (init_dynamic_string(&names, "", 65536, 65536))
+    return 0;
 
-  /* hash all database names */
-  if (mysql_query(&mysql,"show databases") == 0)
+  if (mysql_query(con, "show databases") == 0)
   {
-    if (!(databases = mysql_store_result(&mysql)))
-      put_info(mysql_error(&mysql),INFO_INFO);
+    if (!(res= mysql_store_result(con)))
+    {
+      if (write_info)
+        put_info(mysql_error(con), INFO_INFO);
+    }
     else
     {
-      while ((database_row=mysql_fetch_row(databases)))
-      {
-	char *str=strdup_root(&hash_mem_root, (char*) database_row[0]);
-	if (str)
-	  add_word(&ht,(char*) str);
-      }
-      mysql_free_result(databases);
+      while ((row= mysql_fetch_row(res)))
+        append_completion_name(&names, 'D', row[0], NullS);
+      mysql_free_result(res);
     }
   }
-  /* hash all table names */
-  if (mysql_query(&mysql,"show tables")==0)
+
+  if (mysql_query(con, query) == 0 && (res= mysql_use_result(con)))
   {
-    if (!(tables = mysql_store_result(&mysql)))
-      put_info(mysql_error(&mysql),INFO_INFO);
-    else
+    for (bool first= 1; (row= mysql_fetch_row(res)); first= 0)
     {
-      if (mysql_num_rows(tables) > 0 && !opt_silent && write_info)
-      {
-	tee_fprintf(stdout, "\
+      if (first && !opt_silent && write_info)
+        tee_fprintf(stdout, "\
 Reading table information for completion of table and column names\n\
 You can turn off this feature to get a quicker startup with -A\n\n");
-      }
-      while ((table_row=mysql_fetch_row(tables)))
-      {
-	char *str=strdup_root(&hash_mem_root, (char*) table_row[0]);
-	if (str &&
-	    !completion_hash_exists(&ht,(char*) str, (uint) strlen(str)))
-	  add_word(&ht,str);
-      }
+      append_completion_name(&names, 'C', row[0], row[1]);
     }
+    mysql_free_result(res);
   }
-
-  /* hash all field names, both with the table prefix and without it */
-  if (!tables)					/* no tables */
+  else if (mysql_query(con, "show tables") == 0)
   {
-    DBUG_VOID_RETURN;
+    if (!(res= mysql_store_result(con)))
+    {
+      if (write_info)
+        put_info(mysql_error(con), INFO_INFO);
+    }
+    else
+    {
+      while ((row= mysql_fetch_row(res)))
+        append_completion_name(&names, 'T', row[0], NullS);
+      mysql_free_result(res);
+    }
   }
-  mysql_data_seek(tables,0);
-  if (!(field_names= (char ***) alloc_root(&hash_mem_root,sizeof(char **) *
-					   (uint) (mysql_num_rows(tables)+1))))
-  {
-    mysql_free_result(tables);
+  *length= names.length;
+  return names.str;
+}
+
+
+/*
+  Read the names with a session of the completion thread, so that the
+  statements of the user don't wait for the query on the main connection.
+*/
+
+static char *read_completion_session(COMPLETION_BUILD *cb, size_t *length)
+{
+  MYSQL con;
+  String socket5_proxy;
+  char *names= 0;
+
+  *length= 0;
+  mysql_init(&con);
+  set_connect_options(&con, socket5_proxy, cb->charset);
+  if (do_connect(&con, cb->host, cb->port, cb->user, cb->password,
+                 cb->database, 0))
+    names= read_completion_names(&con, length, 0);
+  mysql_close(&con);
+  return names;
+}
+
+
+static void build_completion_names(COMPLETION_BUILD *cb)
+{
+  if (cb->read_cache)
+    cb->names= read_completion_cache(cb->cache_file, &cb->names_length);
+  else if (!cb->names)
+    cb->names= read_completion_session(cb, &cb->names_length);
+  if (cb->write_cache && cb->names)
+    write_completion_cache(cb->cache_file, cb->names, cb->names_length);
+
+  completion_index_init(&cb->index);
+  add_completion_names(cb);
+  completion_index_sort(&cb->index);
+  my_free(cb->names);
+  cb->names= 0;
+}
+
+
+pthread_handler_t completion_build_thread(void *arg)
+{
+  COMPLETION_BUILD *cb= (COMPLETION_BUILD*) arg;
+
+  mysql_thread_init();
+  build_completion_names(cb);
+  pthread_mutex_lock(&completion_lock);
+  cb->done= 1;
+  pthread_mutex_unlock(&completion_lock);
+  mysql_thread_end();
+  return 0;
+}
+
+
+/**
+  Build up the completion hash.
+
+  @param rehash      Do nothing if not set
+  @param write_info  Tell the user that table information is being read
+  @param use_cache   Take the names from the cache file if there is one
+                     newer than --completion-cache-age, else read them
+                     from the server and update the cache
+*/
+
+static void build_completion_hash(bool rehash, bool write_info,
+                                  bool use_cache)
+{
+  COMPLETION_BUILD *cb= &completion_build;
+  COMMANDS *cmd=commands;
+  MY_STAT stat_info;
+  DBUG_ENTER("build_completion_hash");
+
+  if (status.batch || quick || !current_db)
+    DBUG_VOID_RETURN;			// We don't need completion in batches
+  if (!rehash)
     DBUG_VOID_RETURN;
+
+  /* Free old used memory, complete only the commands until the build ends */
+  completion_build_end(1);
+  completion_index_clean(&completion_words);
+  while (cmd->name) {
+    add_word(&completion_words, cmd->name);
+    cmd++;
   }
-  i=0;
-  while ((table_row=mysql_fetch_row(tables)))
+
+  bzero((char*) cb, sizeof(*cb));
+  if (completion_cache_name(cb->cache_file))
   {
-    if ((fields=mysql_list_fields(&mysql,(const char*) table_row[0],NullS)))
-    {
-      num_fields=mysql_num_fields(fields);
-      if (!(field_names[i] = (char **) alloc_root(&hash_mem_root,
-						  sizeof(char *) *
-						  (num_fields*2+1))))
-      {
-        mysql_free_result(fields);
-        break;
-      }
-      field_names[i][num_fields*2]= NULL;
-      j=0;
-      while ((sql_field=mysql_fetch_field(fields)))
-      {
-	sprintf(buf,"%.64s.%.64s",table_row[0],sql_field->name);
-	field_names[i][j] = strdup_root(&hash_mem_root,buf);
-	add_word(&ht,field_names[i][j]);
-	field_names[i][num_fields+j] = strdup_root(&hash_mem_root,
-						   sql_field->name);
-	if (!completion_hash_exists(&ht,field_names[i][num_fields+j],
-				    (uint) strlen(field_names[i][num_fields+j])))
-	  add_word(&ht,field_names[i][num_fields+j]);
-	j++;
-      }
-      mysql_free_result(fields);
-    }
+    if (use_cache && my_stat(cb->cache_file, &stat_info, MYF(0)) &&
+        time(NULL) - stat_info.st_mtime < (time_t) opt_completion_cache_age)
+      cb->read_cache= 1;
     else
-      field_names[i]= 0;
-
-    i++;
+      cb->write_cache= 1;
+  }
+  cb->host= my_strdup(current_host_success ? current_host_success : "",
+                      MYF(MY_WME));
+  cb->user= my_strdup(current_user ? current_user : "", MYF(MY_WME));
+  cb->password= my_strdup(opt_password ? opt_password : "", MYF(MY_WME));
+  cb->database= my_strdup(current_db, MYF(MY_WME));
+  cb->charset= my_strdup(connect_charset_name(), MYF(MY_WME));
+  cb->port= current_port_success;
+
+  completion_building= 1;
+  if (!cb->host || !cb->user || !cb->password || !cb->database ||
+      !cb->charset ||
+      pthread_create(&cb->thread, NULL, completion_build_thread, (void*) cb))
+  {
+    /* Build it here instead, with the main connection */
+    if (!cb->read_cache)
+      cb->names= read_completion_names(&mysql, &cb->names_length, write_info);
+    build_completion_names(cb);
+    completion_build_end(1);
   }
-  mysql_free_result(tables);
-  field_names[i]=0;				// End pointer
+  else
+    cb->threaded= 1;
   DBUG_VOID_RETURN;
 }
 
@@ -3544,12 +4193,294 @@ char *rindex(const char *s,int c)
 #endif /* HAVE_READLINE */
 
 
-static int reconnect(void)
+/*
+  Sessions of --session-cache. The MYSQL handles are moved in and out of
+  the global connection by value, the way mariadb_reconnect() moves a new
+  handle into an old one.
+*/
+
+#define SESSION_KEY_LENGTH 512
+
+typedef struct st_cached_session
 {
-  /* purecov: begin tested */
-  if (opt_reconnect)
-  {
-    put_info("No connection. Trying to reconnect...",INFO_INFO);
+  MYSQL mysql;
+  char key[SESSION_KEY_LENGTH];               /* Empty if the slot is free */
+  char *password;
+  ulonglong last_used;
+} CACHED_SESSION;
+
+static CACHED_SESSION *session_cache= 0;
+/* Key and password of the session in mysql, set when it is cached */
+static char session_key[SESSION_KEY_LENGTH];
+static char *session_password= 0;
+/* Same for standby_mysql, set when it is opened */
+static char standby_key[SESSION_KEY_LENGTH];
+static char *standby_password= 0;
+
+
+/* The init command of --safe-updates */
+
+static const char *safe_updates_command(char *buff, size_t size)
+{
+  my_snprintf(buff, size,
+              "SET SQL_SAFE_UPDATES=1,SQL_SELECT_LIMIT=%lu,MAX_JOIN_SIZE=%lu",
+              select_limit, max_join_size);
+  return buff;
+}
+
+
+static void session_key_make(char *key, const char *host, uint port,
+                             const char *user, const char *database)
+{
+  my_snprintf(key, SESSION_KEY_LENGTH, "%s@%s:%u/%s", user ? user : "",
+              host ? host : "", port, database ? database : "");
+}
+
+
+static void session_move(MYSQL *to, MYSQL *from)
+{
+  *to= *from;
+  to->net.pvio->mysql= to;
+}
+
+
+/* Run what set_connect_options() gives a new connection as init commands */
+
+static int session_init_commands(MYSQL *con)
+{
+  char buff[100];
+  if (opt_init_command && mysql_query(con, opt_init_command))
+    return 1;
+  return safe_updates &&
+         mysql_query(con, safe_updates_command(buff, sizeof(buff)));
+}
+
+
+static void session_cache_close(CACHED_SESSION *cached)
+{
+  mysql_close(&cached->mysql);
+  my_free(cached->password);
+  cached->password= 0;
+  cached->key[0]= 0;
+}
+
+
+static void session_cache_expire(ulonglong now)
+{
+  ulonglong timeout= opt_session_cache_timeout * 1000000000ULL;
+  for (uint i= 0; i < opt_session_cache; i++)
+    if (session_cache[i].key[0] && session_cache[i].last_used + timeout < now)
+      session_cache_close(&session_cache[i]);
+}
+
+
+/**
+  Keep the session of a connection that is being replaced, or close it.
+  A session with prepared statements is always closed, as they point to
+  the handle. Without --session-cache it is just closed, as it always was.
+
+  Otherwise its transaction ends as when the client exits: committed in
+  Oracle mode with exitcommit on, else rolled back. A kept session is
+  reset, so that it is taken out as a new login would find it.
+*/
+
+static void session_cache_put(MYSQL *con)
+{
+  ulonglong now= my_interval_timer();
+  CACHED_SESSION *slot= NULL;
+
+  if (!opt_session_cache)
+  {
+    mysql_close(con);
+    return;
+  }
+  if (is_exitcommit_oracle && con->oracle_mode)
+    mysql_commit(con);
+  if (!session_key[0] || con->stmts ||
+      mysql_reset_connection(con) ||
+      (!session_cache &&
+       !(session_cache= (CACHED_SESSION*)
+         my_malloc(opt_session_cache * sizeof(CACHED_SESSION),
+                   MYF(MY_WME | MY_ZEROFILL)))))
+  {
+    mysql_close(con);
+    return;
+  }
+  session_cache_expire(now);
+  /* A free slot, else the least recently used one */
+  for (uint i= 0; i < opt_session_cache; i++)
+  {
+    CACHED_SESSION *cached= &session_cache[i];
+    if (!cached->key[0])
+    {
+      slot= cached;
+      break;
+    }
+    if (!slot || cached->last_used < slot->last_used)
+      slot= cached;
+  }
+  if (slot->key[0])
+    session_cache_close(slot);
+  session_move(&slot->mysql, con);
+  strmake(slot->key, session_key, sizeof(slot->key) - 1);
+  slot->password= session_password;
+  slot->last_used= now;
+  session_password= 0;
+  session_key[0]= 0;
+}
+
+
+/**
+  Move a cached session for the connection into con.
+
+  mysql_reset_connection() kept the current database, which USE may
+  have changed since the login, and dropped the settings of the init
+  commands, so both are set again.
+
+  @return 1 if a session was found and is ready for use
+*/
+
+static bool session_cache_get(MYSQL *con, const char *host, const char *user,
+                              const char *password, const char *database)
+{
+  char key[SESSION_KEY_LENGTH];
+
+  if (!session_cache)
+    return 0;
+  session_cache_expire(my_interval_timer());
+  session_key_make(key, host, opt_mysql_port, user, database);
+  for (uint i= 0; i < opt_session_cache; i++)
+  {
+    CACHED_SESSION *cached= &session_cache[i];
+    if (!cached->key[0] || strcmp(cached->key, key))
+      continue;
+    /* Reusing it must not skip the check of the password */
+    if (!cached->password || strcmp(cached->password, password ? password : ""))
+      return 0;
+    session_move(con, &cached->mysql);
+    my_free(cached->password);
+    cached->password= 0;
+    cached->key[0]= 0;
+    if (!mysql_ping(con) &&
+        (database && *database ? !mysql_select_db(con, database) : !con->db) &&
+        !session_init_commands(con))
+      return 1;
+    mysql_close(con);
+    return 0;
+  }
+  return 0;
+}
+
+
+static void session_cache_free()
+{
+  my_free(session_password);
+  session_password= 0;
+  if (!session_cache)
+    return;
+  for (uint i= 0; i < opt_session_cache; i++)
+    if (session_cache[i].key[0])
+      session_cache_close(&session_cache[i]);
+  my_free(session_cache);
+  session_cache= 0;
+}
+
+
+/**
+  Open the standby session on the server of the main connection, if
+  --standby-session asks for it. Failing to open it is not an error,
+  Ctrl-C then connects for each KILL as without the option.
+
+  It is logged in like the main connection, so that standby_take() can
+  make it the main connection when that one is lost.
+*/
+
+static void standby_open()
+{
+  String socket5_proxy;
+
+  standby_close();
+  if (!opt_standby_session || !connected)
+    return;
+  mysql_init(&standby_mysql);
+  set_connect_options(&standby_mysql, socket5_proxy);
+  if (do_connect(&standby_mysql, current_host_success, current_port_success,
+                 current_user, opt_password, "",
+                 connect_flag | CLIENT_MULTI_STATEMENTS))
+  {
+    standby_connected= 1;
+    session_key_make(standby_key, current_host_success, current_port_success,
+                     current_user, "");
+    standby_password= my_strdup(opt_password ? opt_password : "",
+                                MYF(MY_WME));
+  }
+  else
+    mysql_close(&standby_mysql);
+}
+
+
+static void standby_close()
+{
+  if (standby_connected)
+  {
+    standby_connected= 0;
+    mysql_close(&standby_mysql);
+  }
+  my_free(standby_password);
+  standby_password= 0;
+}
+
+
+/**
+  True if the server of the standby session still answers, so that a
+  lost main connection can be opened again on the same server.
+*/
+
+static bool standby_alive()
+{
+  if (standby_connected && mysql_ping(&standby_mysql))
+    standby_close();
+  return standby_connected;
+}
+
+
+/**
+  Move the standby session into con, if it is logged in as a connect to
+  host, user and database would be. It becomes a new main session, as a
+  login would make it but without the round trips, and the caller opens
+  another standby.
+
+  @return 1 if the standby was taken and is ready for use
+*/
+
+static bool standby_take(MYSQL *con, const char *host, const char *user,
+                         const char *password, const char *database)
+{
+  char key[SESSION_KEY_LENGTH];
+
+  if (!standby_connected)
+    return 0;
+  session_key_make(key, host, opt_mysql_port, user, "");
+  if (strcmp(key, standby_key) ||
+      strcmp(standby_password, password ? password : ""))
+    return 0;
+  standby_connected= 0;
+  session_move(con, &standby_mysql);
+  standby_close();
+  if (!mysql_ping(con) &&
+      (!database || !*database || !mysql_select_db(con, database)))
+    return 1;
+  mysql_close(con);
+  return 0;
+}
+
+
+static int reconnect(void)
+{
+  /* purecov: begin tested */
+  if (opt_reconnect)
+  {
+    put_info("No connection. Trying to reconnect...",INFO_INFO);
     (void) com_connect((String *) 0, 0);
     if (opt_rehash)
       com_rehash(NULL, NULL);
@@ -3598,8 +4529,12 @@ int mysql_real_query_for_lazy(const char *buf, size_t length)
   for (uint retry=0;; retry++)
   {
     int error;
-    if (!mysql_real_query(&mysql,buf,(ulong)length))
-      return 0;
+    if (!mysql_send_query(&mysql, buf, (ulong) length))
+    {
+      statement_profile.sent= microsecond_interval_timer();
+      if (!mysql_read_query_result(&mysql))
+        return 0;
+    }
     error= put_error(&mysql);
     if (mysql_errno(&mysql) != CR_SERVER_GONE_ERROR || retry > 1 ||
         !opt_reconnect)
@@ -3827,6 +4762,8 @@ com_go(String *buffer,char *line __attribute__((unused)))
   ulong		warnings= 0;
   uint		error= 0;
   int           err= 0;
+  enum enum_statement_kind kind;
+  bool          pipeline_oom= 0;
 
   interrupted_query= 0;
   if (!status.batch)
@@ -3852,8 +4789,12 @@ com_go(String *buffer,char *line __attribute__((unused)))
       scan_define_oracle(buffer, 1);
     }
 
-    if (CMD_STATE_UNKNOW != set_cmd_oracle(buffer->c_ptr(), strlen(buffer->c_ptr())) || 
-      CMD_STATE_UNKNOW != set_param_oracle(buffer->c_ptr(), strlen(buffer->c_ptr()))) {
+    /* Only the statements that may be client commands are parsed again */
+    kind= get_statement_kind(buffer->ptr(), buffer->length());
+    if ((kind == STATEMENT_KIND_SET &&
+         CMD_STATE_UNKNOW != set_cmd_oracle(buffer->c_ptr(), buffer->length())) ||
+        (kind == STATEMENT_KIND_COLUMN &&
+         CMD_STATE_UNKNOW != set_param_oracle(buffer->c_ptr(), buffer->length()))) {
       buffer->length(0);
       return 0;
     }
@@ -3865,7 +4806,9 @@ com_go(String *buffer,char *line __attribute__((unused)))
     }
 
     //handle pl_show_errors_sql_re, pl_create_sql_re
-    handle_oracle_sql(&mysql, buffer);
+    if (kind == STATEMENT_KIND_SHOW_ERRORS ||
+        kind == STATEMENT_KIND_CREATE_PL || kind == STATEMENT_KIND_ALTER_PL)
+      handle_oracle_sql(&mysql, buffer);
   } else {
     if (verbose)
       (void)com_print(buffer, 0);
@@ -3886,10 +4829,25 @@ com_go(String *buffer,char *line __attribute__((unused)))
     return 0;
   }
 
+  if (parallel_dispatch(buffer, &err))
+  {
+    buffer->length(0);
+    return err;
+  }
+
+  if (batch_insert(buffer, &err) || pack_statement(buffer, &err))
+  {
+    buffer->length(0);
+    return err;
+  }
+
   timer= microsecond_interval_timer();
+  statement_profile.start= statement_profile.sent= timer;
   executing_query= 1;
   
-  error = mysql_real_query_for_lazy(buffer->ptr(), buffer->length());
+  if ((error= result_cursor_open(buffer)) < 0)
+    error= mysql_real_query_for_lazy(buffer->ptr(), buffer->length());
+  statement_profile.first= microsecond_interval_timer();
   report_progress_end();
 
   last_execute_buffer.length(0);
@@ -3912,8 +4870,15 @@ com_go(String *buffer,char *line __attribute__((unused)))
   do
   {
     char *pos;
+    my_bool saved_quick= quick;
 
-    if (quick)
+    if (result_cursor)
+    {
+      /* The rows come as with --quick, the printers must not wait for all */
+      result= result_cursor->metadata;
+      quick= 1;
+    }
+    else if (quick)
     {
       if (!(result=mysql_use_result(&mysql)) && mysql_field_count(&mysql))
       {
@@ -3923,10 +4888,15 @@ com_go(String *buffer,char *line __attribute__((unused)))
     }
     else
     {
-      error= mysql_store_result_for_lazy(&result);
+      if (opt_result_memory_limit)
+        error= result_store_read(&result);
+      else
+        error= mysql_store_result_for_lazy(&result);
       if (error)
         goto end;
     }
+    /* Streamed rows set it when the last one arrives, see fetch_result_row() */
+    statement_profile.last_row= quick ? 0 : microsecond_interval_timer();
 
     if (verbose >= 3 || !opt_silent)
       end_timer(timer, time_buff);
@@ -3954,6 +4924,8 @@ com_go(String *buffer,char *line __attribute__((unused)))
       else
       {
 	init_pager();
+        if (quick && opt_pipeline_rows && !result_cursor)
+          row_pipeline_start(result);
 	if (opt_html)
 	  print_table_data_html(result);
 	else if (opt_xml)
@@ -3965,11 +4937,25 @@ com_go(String *buffer,char *line __attribute__((unused)))
 	  print_tab_data(result);
 	else
 	  print_table_data(result);
+        pipeline_oom= row_pipeline_end();
 	snprintf(buff, sizeof(buff), "%ld %s in set",
 		(long) mysql_num_rows(result),
 		(long) mysql_num_rows(result) == 1 ? "row" : "rows");
+        if (result_cursor && result_cursor->lob_cut)
+        {
+          size_t length= strlen(buff);
+          snprintf(buff + length, sizeof(buff) - length,
+                   ", %lu LOB %s cut to %lu bytes", result_cursor->lob_cut,
+                   result_cursor->lob_cut == 1 ? "value" : "values",
+                   result_cursor->lob_buffer);
+        }
 	end_pager();
-        if (mysql_errno(&mysql))
+        if (pipeline_oom)
+          error= put_info("Out of memory reading the result", INFO_ERROR,
+                          CR_OUT_OF_MEMORY);
+        else if (result_cursor && mysql_stmt_errno(result_cursor->stmt))
+          error= put_stmt_error(&mysql, result_cursor->stmt);
+        else if (mysql_errno(&mysql))
           error= put_error(&mysql);
       }
     }
@@ -4012,11 +4998,15 @@ com_go(String *buffer,char *line __attribute__((unused)))
       put_info("", INFO_RESULT);			// Empty row
     }
 
-    if (result && !mysql_eof(result))	/* Something wrong when using quick */
+    if (result && !result_cursor && !pipeline_oom &&
+        !mysql_eof(result))	/* Something wrong when using quick */
       error= put_error(&mysql);
     else if (unbuffered)
       fflush(stdout);
+    result_store_end();
     mysql_free_result(result);
+    result_cursor_end();
+    quick= saved_quick;
   } while (!(err= mysql_next_result(&mysql)));
   if (err >= 1)
     error= put_error(&mysql);
@@ -4040,6 +5030,8 @@ end:
     call_dbms_get_line(&mysql, error);
   }
 
+  if (!error)
+    profile_record();
   executing_query= 0;
   return error;				/* New command follows */
 }
@@ -4059,10 +5051,13 @@ static void init_pager()
   else
 #endif
     PAGER= stdout;
+  tee_buffer_file= PAGER;
 }
 
 static void end_pager()
 {
+  tee_flush();
+  tee_buffer_file= NULL;
 #ifdef USE_POPEN
   if (!opt_nopager)
     pclose(PAGER);
@@ -4248,29 +5243,38 @@ is_binary_field_oracle(MYSQL_FIELD *field)
   return 0;
 }
 
+/* Print the bytes of str as upper case hex digits, without a prefix */
+
+static void
+print_hex_digits(FILE *output_file, const char *str, size_t len)
+{
+  char buff[4096];
+  const uchar *ptr= (const uchar*) str, *end= ptr + len;
+  while (ptr < end)
+  {
+    size_t length= MY_MIN((size_t) (end - ptr), sizeof(buff) / 2);
+    tee_write(buff, (size_t) (bin2hex(buff, ptr, length) - buff), output_file);
+    ptr+= length;
+  }
+}
+
 /* Print binary value as hex literal (0x ...) */
 
 static void
 print_as_hex(FILE *output_file, const char *str, size_t len, size_t total_bytes_to_send)
 {
-  const char *ptr= str, *end= ptr+len;
-  size_t i;
-  fprintf(output_file, "0x");
-  for(; ptr < end; ptr++)
-    fprintf(output_file, "%02X", *((uchar*)ptr));
-  for (i= 2*len+2; i < total_bytes_to_send; i++)
-    tee_putc((int)' ', output_file);
+  tee_write("0x", 2, output_file);
+  print_hex_digits(output_file, str, len);
+  if (2*len+2 < total_bytes_to_send)
+    tee_fill(' ', total_bytes_to_send - (2*len+2), output_file);
 }
 
 static void
 print_as_hex_oracle(FILE *output_file, const char *str, ulong len, ulong total_bytes_to_send)
 {
-  const char *ptr = str, *end = ptr + len;
-  ulong i;
-  for (; ptr < end; ptr++)
-    fprintf(output_file, "%02X", *((uchar*)ptr));
-  for (i = 2 * len; i < total_bytes_to_send; i++)
-    tee_putc((int)' ', output_file);
+  print_hex_digits(output_file, str, len);
+  if (2 * len < total_bytes_to_send)
+    tee_fill(' ', total_bytes_to_send - 2 * len, output_file);
 }
 
 int auto_incr(char *str, int pos) {
@@ -4739,1078 +5743,3543 @@ format_fix_width_num_binary(const char *str, ulong len)
   }
 }
 
-static void
-print_table_data(MYSQL_RES *result)
-{
-  String separator(256);
-  MYSQL_ROW	cur;
-  MYSQL_FIELD	*field;
-  bool		*num_flag;
+/**
+  Copy a row returned by mysql_fetch_row() into mem_root, because the
+  library reuses its row buffer on the next call.
 
-  num_flag=(bool*) my_alloca(sizeof(bool)*mysql_num_fields(result));
-  if (column_types_flag)
+  @return 1 on out of memory, else 0
+*/
+
+static bool
+copy_result_row(MEM_ROOT *mem_root, MYSQL_ROW cur, ulong *lengths,
+                uint num_fields, MYSQL_ROW *row, ulong **row_lengths)
+{
+  if (!(*row= (MYSQL_ROW) alloc_root(mem_root, sizeof(char*) * num_fields)) ||
+      !(*row_lengths= (ulong*) memdup_root(mem_root, lengths,
+                                           sizeof(ulong) * num_fields)))
+    return 1;
+  for (uint i= 0; i < num_fields; i++)
   {
-    print_field_types(result);
-    if (!mysql_num_rows(result))
-      return;
-    mysql_field_seek(result,0);
+    if (!cur[i])
+      (*row)[i]= NULL;
+    /* Keep the terminating NUL, the number formatters rely on it */
+    else if (!((*row)[i]= (char*) memdup_root(mem_root, cur[i],
+                                              lengths[i] + 1)))
+      return 1;
   }
-  separator.copy("+",1,charset_info);
-  while ((field = mysql_fetch_field(result)))
+  return 0;
+}
+
+
+/*
+  With --pipeline-rows a thread of its own reads an unbuffered result into
+  a ring of row batches while the printers format the batches read before.
+  The printers get their rows from fetch_result_row(), which takes them
+  from the ring while a pipeline is running. The main thread must not use
+  the connection until row_pipeline_end() has returned.
+*/
+
+#define PIPELINE_BATCHES 4
+
+typedef struct st_row_batch
+{
+  MEM_ROOT mem_root;                    /* Row data, reused per batch */
+  MYSQL_ROW *rows;
+  ulong **lengths;
+  ulong count;
+} ROW_BATCH;
+
+typedef struct st_row_pipeline
+{
+  MYSQL_RES *result;
+  ulong batch_rows;
+  ROW_BATCH batches[PIPELINE_BATCHES];
+  uint head;                    /* Next batch to be filled by the reader */
+  uint filled;                  /* Batches handed over to the printer */
+  bool eof, abort;
+  bool oom;                     /* The reader ran out of memory */
+  /* Only used by the printer */
+  uint tail;                    /* Batch being printed */
+  ulong pos;                    /* Next row of batches[tail] */
+  bool printing;                /* The printer owns batches[tail] */
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} ROW_PIPELINE;
+
+static ROW_PIPELINE pipeline, *row_pipeline= NULL;
+
+
+pthread_handler_t row_pipeline_reader(void *arg)
+{
+  ROW_PIPELINE *pl= (ROW_PIPELINE*) arg;
+  uint num_fields= mysql_num_fields(pl->result);
+  bool eof= 0, oom= 0;
+
+  mysql_thread_init();
+  while (!eof)
   {
-    uint length= column_names ? field->name_length : 0;
-    if (quick) {
-      if (mysql.oracle_mode) {
-        // for oracle mode, use max_length, max_length for use result change
-        length= MY_MAX(length, field->max_length);
-      } else {
-        length= MY_MAX(length,field->length);
-      }
-    } else
-      length= MY_MAX(length,field->max_length);
-    if (length < 4 /*&& !IS_NOT_NULL(field->flags)*/)
-      length=4;					// Room for "NULL"
-    if (mysql.oracle_mode && is_binary_field_oracle(field)) {
-      length = length * 2;
-    } else if (opt_binhex && is_binary_field(field)) {
-      length = 2 + length * 2;
+    ROW_BATCH *batch;
+    MYSQL_ROW cur;
+
+    pthread_mutex_lock(&pl->lock);
+    while (pl->filled == PIPELINE_BATCHES && !pl->abort)
+      pthread_cond_wait(&pl->cond, &pl->lock);
+    if (pl->abort)
+    {
+      pthread_mutex_unlock(&pl->lock);
+      break;
     }
-    field->max_length=length;
-    num_flag[mysql_field_tell(result) - 1]= IS_NUM(field->type);
-    separator.fill(separator.length()+length+2,'-');
-    separator.append('+');
-  }
-  separator.append('\0');                       // End marker for \0
+    batch= &pl->batches[pl->head];
+    pthread_mutex_unlock(&pl->lock);
 
-  if (is_termout_oracle_enable(&mysql)) {
-    tee_puts((char*)separator.ptr(), PAGER);
-    if (column_names)
+    free_root(&batch->mem_root, MYF(MY_MARK_BLOCKS_FREE));
+    for (batch->count= 0; batch->count < pl->batch_rows; batch->count++)
     {
-      mysql_field_seek(result, 0);
-      (void)tee_fputs("|", PAGER);
-      for (uint off = 0; (field = mysql_fetch_field(result)); off++)
+      if (!(cur= mysql_fetch_row(pl->result)))
       {
-        size_t name_length = (uint)strlen(field->name);
-        size_t numcells = charset_info->cset->numcells(charset_info,
-          field->name,
-          field->name + name_length);
-        size_t display_length = field->max_length + name_length - numcells;
-        tee_fprintf(PAGER, " %-*s |", (int)MY_MIN(display_length,
-          MAX_COLUMN_LENGTH),
-          field->name);
+        eof= 1;
+        break;
+      }
+      /*
+        Running out of memory ends the batches early and leaves the
+        rest of the result unread. row_pipeline_end() tells com_go().
+      */
+      if (copy_result_row(&batch->mem_root, cur,
+                          mysql_fetch_lengths(pl->result), num_fields,
+                          &batch->rows[batch->count],
+                          &batch->lengths[batch->count]))
+      {
+        eof= oom= 1;
+        break;
       }
-      (void)tee_fputs("\n", PAGER);
-      tee_puts((char*)separator.ptr(), PAGER);
     }
+
+    pthread_mutex_lock(&pl->lock);
+    pl->head= (pl->head + 1) % PIPELINE_BATCHES;
+    pl->filled++;
+    pl->eof= eof;
+    pl->oom= oom;
+    pthread_cond_signal(&pl->cond);
+    pthread_mutex_unlock(&pl->lock);
   }
+  mysql_thread_end();
+  return 0;
+}
+
 
-  while ((cur= mysql_fetch_row(result)))
+static void row_pipeline_free(ROW_PIPELINE *pl)
+{
+  for (uint i= 0; i < PIPELINE_BATCHES; i++)
   {
-    if (interrupted_query)
-      break;
-    if (!is_termout_oracle_enable(&mysql))
-      continue;
-    
-    ulong *lengths= mysql_fetch_lengths(result);
-    (void) tee_fputs("| ", PAGER);
-    mysql_field_seek(result, 0);
-    for (uint off= 0; off < mysql_num_fields(result); off++)
-    {
-      const char *buffer;
-      uint data_length;
-      uint field_max_length;
-      uint extra_padding;
+    free_root(&pl->batches[i].mem_root, MYF(0));
+    my_free(pl->batches[i].rows);
+    my_free(pl->batches[i].lengths);
+  }
+}
 
-      if (off)
-        (void) tee_fputs(" ", PAGER);
 
-      if (cur[off] == NULL)
-      {
-        buffer= "NULL";
-        data_length= 4;
-      } 
-      else 
-      {
-        buffer= cur[off];
-        data_length= (uint) lengths[off];
-      }
-
-      field= mysql_fetch_field(result);
-      if (!field)
-        continue;
-
-      field_max_length= field->max_length;
+/**
+  Start reading an unbuffered result in a separate thread.
 
-      /* 
-       How many text cells on the screen will this string span?  If it contains
-       multibyte characters, then the number of characters we occupy on screen
-       will be fewer than the number of bytes we occupy in memory.
+  If the thread can't be started, the printers read the rows themselves.
+*/
 
-       We need to find how much screen real-estate we will occupy to know how 
-       many extra padding-characters we should send with the printing function.
-      */
-      size_t visible_length= charset_info->cset->numcells(charset_info, buffer, buffer + data_length);
-      extra_padding= (uint) (data_length - visible_length);
+static void row_pipeline_start(MYSQL_RES *result)
+{
+  ROW_PIPELINE *pl= &pipeline;
 
-      if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type) && IS_NUM_BINARY_TERMINAL(field->type)) {
-        /* 1.23456E+008 */
-        format_fix_width_num_binary(cur[off], lengths[off]);
-        if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
-          tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length, TRUE);
-        else 
-          tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length, FALSE);
-      }
-      else if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type)) {
-        /* 123456.6754321 */
-        format_fix_width_num(cur[off], lengths[off]);
-        //if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
-        tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length+extra_padding, TRUE);
-        //else 
-        //tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length+extra_padding, FALSE);
-        
-      }
-      else if (mysql.oracle_mode && cur[off] && is_binary_field_oracle(field))
-        print_as_hex_oracle(PAGER, cur[off], lengths[off], field_max_length);
-      else if (opt_binhex && cur[off] && is_binary_field(field))
-        print_as_hex(PAGER, cur[off], lengths[off], field_max_length);
-      else if (field_max_length > MAX_COLUMN_LENGTH)
-        tee_print_sized_data(buffer, data_length, MAX_COLUMN_LENGTH+extra_padding, FALSE);
-      else
-      {
-        if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
-          tee_print_sized_data(buffer, data_length, field_max_length+extra_padding, TRUE);
-        else 
-          tee_print_sized_data(buffer, data_length, field_max_length+extra_padding, FALSE);
-      }
-      tee_fputs(" |", PAGER);
+  bzero((char*) pl, sizeof(*pl));
+  pl->result= result;
+  pl->batch_rows= opt_pipeline_rows;
+  for (uint i= 0; i < PIPELINE_BATCHES; i++)
+  {
+    ROW_BATCH *batch= &pl->batches[i];
+    init_alloc_root(&batch->mem_root, "row_pipeline", 65536, 0, MYF(0));
+    if (!(batch->rows= (MYSQL_ROW*) my_malloc(sizeof(MYSQL_ROW) *
+                                              pl->batch_rows, MYF(MY_WME))) ||
+        !(batch->lengths= (ulong**) my_malloc(sizeof(ulong*) *
+                                              pl->batch_rows, MYF(MY_WME))))
+    {
+      row_pipeline_free(pl);
+      return;
     }
-    (void) tee_fputs("\n", PAGER);
   }
-  if (is_termout_oracle_enable(&mysql)) {
-    tee_puts((char*)separator.ptr(), PAGER);
+  pthread_mutex_init(&pl->lock, NULL);
+  pthread_cond_init(&pl->cond, NULL);
+  if (pthread_create(&pl->thread, NULL, row_pipeline_reader, (void*) pl))
+  {
+    pthread_mutex_destroy(&pl->lock);
+    pthread_cond_destroy(&pl->cond);
+    row_pipeline_free(pl);
+    return;
   }
-  my_afree((uchar*) num_flag);
+  row_pipeline= pl;
 }
 
-/**
-  Return the length of a field after it would be rendered into text.
-
-  This doesn't know or care about multibyte characters.  Assume we're
-  using such a charset.  We can't know that all of the upcoming rows 
-  for this column will have bytes that each render into some fraction
-  of a character.  It's at least possible that a row has bytes that 
-  all render into one character each, and so the maximum length is 
-  still the number of bytes.  (Assumption 1:  This can't be better 
-  because we can never know the number of characters that the DB is 
-  going to send -- only the number of bytes.  2: Chars <= Bytes.)
 
-  @param  field  Pointer to a field to be inspected
+/**
+  Stop the reader thread and free the batches. Rows not read yet are
+  left in the result.
 
-  @returns  number of character positions to be used, at most
+  @retval 1  the reader ran out of memory before the end of the result
+  @retval 0  otherwise, or if no pipeline was running
 */
-static int get_field_disp_length(MYSQL_FIELD *field)
-{
-  uint length= column_names ? field->name_length : 0;
-
-  if (quick)
-    length= MY_MAX(length, field->length);
-  else
-    length= MY_MAX(length, field->max_length);
 
-  if (length < 4 && !IS_NOT_NULL(field->flags))
-    length= 4;				/* Room for "NULL" */
+static bool row_pipeline_end()
+{
+  ROW_PIPELINE *pl= row_pipeline;
+  bool oom;
 
-  return length;
+  if (!pl)
+    return 0;
+  pthread_mutex_lock(&pl->lock);
+  pl->abort= 1;
+  pthread_cond_signal(&pl->cond);
+  pthread_mutex_unlock(&pl->lock);
+  pthread_join(pl->thread, NULL);
+  oom= pl->oom;
+  pthread_mutex_destroy(&pl->lock);
+  pthread_cond_destroy(&pl->cond);
+  row_pipeline_free(pl);
+  row_pipeline= NULL;
+  return oom;
 }
 
-/**
-  For a new result, return the max number of characters that any
-  upcoming row may return.
-
-  @param  result  Pointer to the result to judge
 
-  @returns  The max number of characters in any row of this result
+/*
+  With --result-memory-limit a result is read with mysql_use_result()
+  into a store of its own instead of mysql_store_result(). Rows are
+  copied into memory until the limit is reached and the rest is written
+  to a temporary file, each row as the lengths of its columns followed by
+  the values. The printers get the rows back through fetch_result_row(),
+  so only the rows in memory and one row from the file are held at once.
 */
 
-static int get_result_width(MYSQL_RES *result)
-{
-  unsigned int len= 0;
-  MYSQL_FIELD *field;
-  MYSQL_FIELD_OFFSET offset;
-  
-#ifndef DBUG_OFF
-  offset= mysql_field_tell(result);
-  DBUG_ASSERT(offset == 0);
-#else
-  offset= 0;
-#endif
+#define STORE_NULL_LENGTH (~(ulong) 0)
 
-  while ((field= mysql_fetch_field(result)) != NULL)
-    len+= get_field_disp_length(field) + 3; /* plus bar, space, & final space */
+typedef struct st_result_store
+{
+  MEM_ROOT mem_root;
+  DYNAMIC_ARRAY rows;                   /* MYSQL_ROW and lengths, in memory */
+  ulonglong memory;                     /* Bytes used by the rows in memory */
+  IO_CACHE file;                        /* Rows past the limit */
+  ulonglong file_rows;
+  uint num_fields;
+  /* Reading */
+  ulong pos;                            /* Next row in memory */
+  ulonglong file_pos;                   /* Rows read back from the file */
+  MYSQL_ROW row;                        /* The row read from the file */
+  ulong *lengths;
+  char *buffer;
+  size_t buffer_size;
+} RESULT_STORE;
+
+typedef struct st_stored_row
+{
+  MYSQL_ROW row;
+  ulong *lengths;
+} STORED_ROW;
 
-  (void) mysql_field_seek(result, offset);	
+static RESULT_STORE store, *result_store= NULL;
 
-  return len + 1; /* plus final bar. */
-}
 
-static void
-tee_print_sized_data(const char *data, unsigned int data_length, unsigned int total_bytes_to_send, bool right_justified)
+static bool result_store_write(RESULT_STORE *rs, MYSQL_ROW cur, ulong *lengths)
 {
-  /* 
-    For '\0's print ASCII spaces instead, as '\0' is eaten by (at
-    least my) console driver, and that messes up the pretty table
-    grid.  (The \0 is also the reason we can't use fprintf() .) 
-  */
-  unsigned int i;
-  const char *p;
-
-  if (right_justified) 
-    for (i= data_length; i < total_bytes_to_send; i++)
-      tee_putc((int)' ', PAGER);
-
-  for (i= 0, p= data; i < data_length; i+= 1, p+= 1)
+  for (uint i= 0; i < rs->num_fields; i++)
   {
-    if (*p == '\0')
-      tee_putc((int)' ', PAGER);
-    else
-      tee_putc((int)*p, PAGER);
+    ulong length= cur[i] ? lengths[i] : STORE_NULL_LENGTH;
+    if (my_b_write(&rs->file, (uchar*) &length, sizeof(length)))
+      return 1;
   }
+  for (uint i= 0; i < rs->num_fields; i++)
+    if (cur[i] && my_b_write(&rs->file, (uchar*) cur[i], lengths[i]))
+      return 1;
+  rs->file_rows++;
+  return 0;
+}
 
-  if (! right_justified) 
-    for (i= data_length; i < total_bytes_to_send; i++)
-      tee_putc((int)' ', PAGER);
+
+static void result_store_free(RESULT_STORE *rs)
+{
+  free_root(&rs->mem_root, MYF(0));
+  delete_dynamic(&rs->rows);
+  close_cached_file(&rs->file);
+  my_free(rs->row);
+  my_free(rs->lengths);
+  my_free(rs->buffer);
 }
 
 
+/**
+  Read a result into the store, like mysql_store_result_for_lazy() does
+  into the library. The max_length of the fields is set as
+  mysql_store_result() sets it.
+
+  @return 0 on success, else the result of reporting the error
+*/
 
-static void
-print_table_data_html(MYSQL_RES *result)
+static int result_store_read(MYSQL_RES **result)
 {
-  MYSQL_ROW	cur;
-  MYSQL_FIELD	*field;
+  RESULT_STORE *rs= &store;
+  MYSQL_FIELD *fields;
+  MYSQL_ROW cur;
 
-  mysql_field_seek(result,0);
-  (void) tee_fputs("<TABLE BORDER=1>", PAGER);
-  if (column_names)
+  if (!(*result= mysql_use_result(&mysql)))
+    return mysql_field_count(&mysql) ? put_error(&mysql) : 0;
+
+  bzero((char*) rs, sizeof(*rs));
+  rs->num_fields= mysql_num_fields(*result);
+  fields= mysql_fetch_fields(*result);
+  init_alloc_root(&rs->mem_root, "result_store", 65536, 0, MYF(0));
+  if (my_init_dynamic_array(&rs->rows, sizeof(STORED_ROW), 1024, 1024,
+                            MYF(0)) ||
+      open_cached_file(&rs->file, NULL, "obclient", 65536, MYF(MY_WME)) ||
+      !(rs->row= (MYSQL_ROW) my_malloc(sizeof(char*) * rs->num_fields,
+                                       MYF(MY_WME))) ||
+      !(rs->lengths= (ulong*) my_malloc(sizeof(ulong) * rs->num_fields,
+                                        MYF(MY_WME))))
+    goto err;
+
+  while ((cur= mysql_fetch_row(*result)))
   {
-    (void) tee_fputs("<TR>", PAGER);
-    while((field = mysql_fetch_field(result)))
+    ulong *lengths= mysql_fetch_lengths(*result);
+    ulonglong row_size= sizeof(STORED_ROW) +
+                        (sizeof(char*) + sizeof(ulong)) * rs->num_fields;
+    for (uint i= 0; i < rs->num_fields; i++)
     {
-      tee_fputs("<TH>", PAGER);
-      if (field->name && field->name[0])
-        xmlencode_print(field->name, field->name_length);
-      else
-        tee_fputs(field->name ? " &nbsp; " : "NULL", PAGER);
-      tee_fputs("</TH>", PAGER);
+      if (cur[i])
+      {
+        set_if_bigger(fields[i].max_length, lengths[i]);
+        row_size+= lengths[i] + 1;
+      }
     }
-    (void) tee_fputs("</TR>", PAGER);
-  }
-  while ((cur = mysql_fetch_row(result)))
-  {
-    if (interrupted_query)
-      break;
-    ulong *lengths=mysql_fetch_lengths(result);
-    field= mysql_fetch_fields(result);
-    (void) tee_fputs("<TR>", PAGER);
-    for (uint i=0; i < mysql_num_fields(result); i++)
+    if (!rs->file_rows && rs->memory + row_size <= opt_result_memory_limit)
     {
-      (void) tee_fputs("<TD>", PAGER);
-      if (mysql.oracle_mode && is_binary_field_oracle(&field[i])) {
-        if ((!force_set_num_width_close) && cur[i] && IS_NUM_BINARY_TERMINAL(field->type)) {
-          format_fix_width_num_binary(cur[i], lengths[i]); 
-          print_as_hex_oracle(PAGER, obclient_num_array, strlen(obclient_num_array), lengths[i]);
-        } else {
-          print_as_hex_oracle(PAGER, cur[i], lengths[i], lengths[i]);
-        }
-      }
-      else if (opt_binhex && is_binary_field(&field[i]))
-        print_as_hex(PAGER, cur[i], lengths[i], lengths[i]);
-      else {
-        if ((!force_set_num_width_close) && mysql.oracle_mode && cur[i] && IS_NUM_TERMINAL(field->type)) {
-          format_fix_width_num(cur[i], lengths[i]);
-          xmlencode_print(obclient_num_array, strlen(obclient_num_array));
-        } else {
-          xmlencode_print(cur[i], lengths[i]);
-        }
-      }
-      (void) tee_fputs("</TD>", PAGER);
+      STORED_ROW stored;
+      if (copy_result_row(&rs->mem_root, cur, lengths, rs->num_fields,
+                          &stored.row, &stored.lengths) ||
+          insert_dynamic(&rs->rows, (uchar*) &stored))
+        goto err;
+      rs->memory+= row_size;
     }
-    (void) tee_fputs("</TR>", PAGER);
+    else if (result_store_write(rs, cur, lengths))
+      goto err;
+  }
+  if (mysql_errno(&mysql))
+    goto err;
+  if (rs->file_rows &&
+      reinit_io_cache(&rs->file, READ_CACHE, 0L, 0, 0))
+    goto err;
+  result_store= rs;
+  return 0;
+
+err:
+  {
+    int error= mysql_errno(&mysql) ? put_error(&mysql) :
+                                     put_info("Can't store the result",
+                                              INFO_ERROR);
+    result_store_free(rs);
+    mysql_free_result(*result);
+    *result= NULL;
+    return error;
   }
-  (void) tee_fputs("</TABLE>", PAGER);
 }
 
 
-static void
-print_table_data_xml(MYSQL_RES *result)
+static MYSQL_ROW result_store_fetch(RESULT_STORE *rs, ulong **lengths)
 {
-  MYSQL_ROW   cur;
-  MYSQL_FIELD *fields;
-
-  mysql_field_seek(result,0);
+  size_t data_length= 0;
+  char *pos;
 
-  tee_fputs("<?xml version=\"1.0\"?>\n\n<resultset statement=\"", PAGER);
-  xmlencode_print(glob_buffer.ptr(), (int)strlen(glob_buffer.ptr()));
-  tee_fputs("\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">",
-            PAGER);
-
-  fields = mysql_fetch_fields(result);
-  while ((cur = mysql_fetch_row(result)))
+  if (rs->pos < rs->rows.elements)
   {
-    if (interrupted_query)
-      break;
-    ulong *lengths=mysql_fetch_lengths(result);
-    (void) tee_fputs("\n  <row>\n", PAGER);
-    for (uint i=0; i < mysql_num_fields(result); i++)
+    STORED_ROW *stored= dynamic_element(&rs->rows, rs->pos++, STORED_ROW*);
+    *lengths= stored->lengths;
+    return stored->row;
+  }
+  if (rs->file_pos == rs->file_rows ||
+      my_b_read(&rs->file, (uchar*) rs->lengths,
+                sizeof(ulong) * rs->num_fields))
+    return NULL;
+  for (uint i= 0; i < rs->num_fields; i++)
+    if (rs->lengths[i] != STORE_NULL_LENGTH)
+      data_length+= rs->lengths[i] + 1;
+  if (data_length > rs->buffer_size)
+  {
+    char *buffer;
+    if (!(buffer= (char*) my_realloc(rs->buffer, data_length,
+                                     MYF(MY_WME | MY_ALLOW_ZERO_PTR))))
+      return NULL;
+    rs->buffer= buffer;
+    rs->buffer_size= data_length;
+  }
+  pos= rs->buffer;
+  for (uint i= 0; i < rs->num_fields; i++)
+  {
+    if (rs->lengths[i] == STORE_NULL_LENGTH)
     {
-      tee_fprintf(PAGER, "\t<field name=\"");
-      xmlencode_print(fields[i].name, (uint) strlen(fields[i].name));
-      if (cur[i])
-      {
-        tee_fprintf(PAGER, "\">");
-        if (mysql.oracle_mode && is_binary_field_oracle(&fields[i])) {
-          if ((!force_set_num_width_close) && cur[i] && IS_NUM_BINARY_TERMINAL(fields[i].type)) {
-            format_fix_width_num_binary(cur[i], lengths[i]);
-            print_as_hex_oracle(PAGER, obclient_num_array, strlen(obclient_num_array), lengths[i]);
-          } else {
-            print_as_hex_oracle(PAGER, cur[i], lengths[i], lengths[i]);
-          }
-        }
-        else if (opt_binhex && is_binary_field(&fields[i]))
-          print_as_hex(PAGER, cur[i], lengths[i], lengths[i]);
-        else {
-          if ((!force_set_num_width_close) && mysql.oracle_mode && cur[i] && IS_NUM_TERMINAL(fields[i].type)) {
-            format_fix_width_num(cur[i], lengths[i]);
-            xmlencode_print(obclient_num_array, strlen(obclient_num_array));
-          } else {
-            xmlencode_print(cur[i], lengths[i]);
-          }
-        }
-        tee_fprintf(PAGER, "</field>\n");
-      }
-      else
-        tee_fprintf(PAGER, "\" xsi:nil=\"true\" />\n");
+      rs->row[i]= NULL;
+      rs->lengths[i]= 0;
+      continue;
     }
-    (void) tee_fputs("  </row>\n", PAGER);
+    if (my_b_read(&rs->file, (uchar*) pos, rs->lengths[i]))
+      return NULL;
+    rs->row[i]= pos;
+    pos+= rs->lengths[i];
+    *pos++= '\0';                      /* The printers rely on it */
   }
-  (void) tee_fputs("</resultset>\n", PAGER);
+  rs->file_pos++;
+  *lengths= rs->lengths;
+  return rs->row;
 }
 
 
-static void
-print_table_data_vertically(MYSQL_RES *result)
+static void result_store_end()
 {
-  MYSQL_ROW	cur;
-  uint		max_length=0;
-  MYSQL_FIELD	*field;
-
-  while ((field = mysql_fetch_field(result)))
+  if (result_store)
   {
-    uint length= field->name_length;
-    if (length > max_length)
-      max_length= length;
-    field->max_length=length;
+    result_store_free(result_store);
+    result_store= NULL;
   }
+}
 
-  mysql_field_seek(result,0);
-  for (uint row_count=1; (cur= mysql_fetch_row(result)); row_count++)
-  {
-    if (interrupted_query)
-      break;
-    mysql_field_seek(result,0);
-    tee_fprintf(PAGER, 
-		"*************************** %d. row ***************************\n", row_count);
 
-    ulong *lengths= mysql_fetch_lengths(result);
+/*
+  With --cursor-fetch a SELECT runs as a prepared statement with a
+  read-only cursor, and the server sends prefetch rows per COM_STMT_FETCH.
+  The client holds one batch at a time, and unlike with --quick the server
+  doesn't wait on a slow terminal with the result half sent.
 
-    for (uint off=0; off < mysql_num_fields(result); off++)
-    {
-      field= mysql_fetch_field(result);
-      if (!field)
-        continue;
+  After each batch prefetch is set for the next one, so that a batch holds
+  about CURSOR_BATCH_BYTES and is printed in about CURSOR_BATCH_TIME.
+*/
 
-      if (column_names)
-        tee_fprintf(PAGER, "%*s: ",(int) max_length,field->name);
-      if (cur[off])
-      {
-        unsigned int i;
-        const char *p;
-        unsigned long len;
-        if (opt_binhex && is_binary_field(field) && !mysql.oracle_mode)
-           fprintf(PAGER, "0x");
+#define CURSOR_BATCH_BYTES    (1024*1024)
+#define CURSOR_BATCH_TIME     (500*1000*1000ULL)      /* nanoseconds */
+#define CURSOR_COLUMN_BUFFER  4096
 
-        if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_BINARY_TERMINAL(field->type)) {
-          format_fix_width_num_binary(cur[off], lengths[off]);
-          p = obclient_num_array;
-          len = strlen(obclient_num_array);
-        } else if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type)) {
-          format_fix_width_num(cur[off], lengths[off]);
-          p = obclient_num_array;
-          len = strlen(obclient_num_array);
-        } else {
-          p = cur[off];
-          len = lengths[off];
-        }
-        for (i= 0; i < len; i+= 1, p+= 1)
-        {
-          if (opt_binhex && is_binary_field(field))
-            fprintf(PAGER, "%02X", *((uchar*)p));
-          else
-          {
-            if (*p == '\0')
-              tee_putc((int)' ', PAGER);
-            else
-              tee_putc((int)*p, PAGER);
-          }
-        }
-        tee_putc('\n', PAGER);
-      }
-      else
-        tee_fprintf(PAGER, "NULL\n");
-    }
+
+static void result_cursor_free(RESULT_CURSOR *rc)
+{
+  if (rc->bind)
+  {
+    for (uint i= 0; i < rc->num_fields; i++)
+      my_free(rc->bind[i].buffer);
   }
+  my_free(rc->bind);
+  my_free(rc->row);
+  my_free(rc->lengths);
+  my_free(rc->is_null);
+  my_free(rc->truncated);
+  my_free(rc->lob_lengths);
+  mysql_stmt_close(rc->stmt);
 }
 
-/* print_warnings should be called right after executing a statement */
 
-static void print_warnings()
+static bool is_lob_field(MYSQL_FIELD *field)
 {
-  const char   *query = NULL;
-  MYSQL_RES    *result = NULL;
-  MYSQL_ROW    cur;
-  my_ulonglong num_rows;
-  
-  /* Save current error before calling "show warnings" */
-  uint error= mysql_errno(&mysql);
+  return field->type == MYSQL_TYPE_ORA_CLOB ||
+         field->type == MYSQL_TYPE_ORA_BLOB ||
+         field->type == MYSQL_TYPE_BLOB ||
+         field->type == MYSQL_TYPE_LONG_BLOB ||
+         field->type == MYSQL_TYPE_MEDIUM_BLOB ||
+         field->type == MYSQL_TYPE_TINY_BLOB;
+}
 
-  /* Get the warnings */
-  query= "show warnings";
-  if(mysql_real_query_for_lazy(query, strlen(query))){
-    goto end;
-  }
-  if(mysql_store_result_for_lazy(&result)) {
-    goto end;
-  }
 
-  /* Bail out when no warnings */
-  if (!result || !(num_rows= mysql_num_rows(result)))
-    goto end;
+/*
+  In Oracle mode the server formats DATE, TIMESTAMP, INTERVAL and the
+  like for the text protocol with the NLS settings of the session, while
+  the binary protocol sends values that the client library formats its
+  own way. So only the columns that come as the same text either way may
+  share a cursor with the LOBs: characters, and NUMBER, which the binary
+  protocol sends as a decimal string too.
+*/
 
-  cur= mysql_fetch_row(result);
+static bool is_cursor_text_field(MYSQL_FIELD *field)
+{
+  return field->type == MYSQL_TYPE_VARCHAR ||
+         field->type == MYSQL_TYPE_VAR_STRING ||
+         field->type == MYSQL_TYPE_STRING ||
+         field->type == MYSQL_TYPE_OB_NVARCHAR2 ||
+         field->type == MYSQL_TYPE_OB_NCHAR ||
+         field->type == MYSQL_TYPE_NEWDECIMAL;
+}
 
-  /*
-    Don't print a duplicate of the current error.  It is possible for SHOW
-    WARNINGS to return multiple errors with the same code, but different
-    messages.  To be safe, skip printing the duplicate only if it is the only
-    warning.
-  */
-  if (!cur || (num_rows == 1 && error == (uint) strtoul(cur[1], NULL, 10)))
-    goto end;
 
-  /* Print the warnings */
-  init_pager();
-  do
-  {
-    tee_fprintf(PAGER, "%s (Code %s): %s\n", cur[0], cur[1], cur[2]);
-  } while ((cur= mysql_fetch_row(result)));
-  end_pager();
+/*
+  In MySQL mode the binary protocol sends numbers and temporal values in
+  binary, and the client library turns them into text its own way:
+  FLOAT and DOUBLE with other digits than the server, ZEROFILL integers
+  without the zeros, and dates and times with their fractions as it sees
+  fit. Strings, DECIMAL and plain integers come as the same text either
+  way.
+*/
 
-end:
-  if(result)
-    mysql_free_result(result);
+static bool is_cursor_mysql_field(MYSQL_FIELD *field)
+{
+  switch (field->type) {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    return !(field->flags & ZEROFILL_FLAG);
+  case MYSQL_TYPE_VARCHAR:
+  case MYSQL_TYPE_VAR_STRING:
+  case MYSQL_TYPE_STRING:
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_BLOB:
+  case MYSQL_TYPE_NEWDECIMAL:
+    return 1;
+  default:
+    return 0;
+  }
 }
 
 
-static const char *array_value(const char **array, char key)
+/* True if all columns of the result print the same with a cursor */
+
+static bool statement_is_mysql_text(MYSQL_STMT *stmt)
 {
-  for (; *array; array+= 2)
-    if (**array == key)
-      return array[1];
-  return 0;
+  MYSQL_RES *metadata;
+  MYSQL_FIELD *field;
+  bool alike= 1;
+
+  if (!(metadata= mysql_stmt_result_metadata(stmt)))
+    return 0;
+  while (alike && (field= mysql_fetch_field(metadata)))
+    alike= is_cursor_mysql_field(field);
+  mysql_free_result(metadata);
+  return alike;
 }
 
 
-static void
-xmlencode_print(const char *src, uint length)
+/* True if the result has LOBs, and the other columns print the same */
+
+static bool statement_has_lob(MYSQL_STMT *stmt)
 {
-  if (!src)
-    tee_fputs("NULL", PAGER);
-  else
+  MYSQL_RES *metadata;
+  MYSQL_FIELD *field;
+  bool found= 0, other= 0;
+
+  if (!(metadata= mysql_stmt_result_metadata(stmt)))
+    return 0;
+  while (!other && (field= mysql_fetch_field(metadata)))
   {
-    for (const char *p = src; length; p++, length--)
-    {
-      const char *t;
-      if ((t = array_value(xmlmeta, *p)))
-	tee_fputs(t, PAGER);
-      else
-	tee_putc(*p, PAGER);
-    }
+    if (is_lob_field(field))
+      found= 1;
+    else
+      other= !is_cursor_text_field(field);
   }
+  mysql_free_result(metadata);
+  return found && !other;
 }
 
 
-static void
-safe_put_field(const char *pos,ulong length)
+/**
+  Run the statement in buffer with a server cursor if --cursor-fetch, or
+  in Oracle mode --lob-chunk-size, applies to it. The result is then
+  printed from result_cursor, and result_cursor->metadata is freed by
+  the caller like any result.
+
+  With --lob-chunk-size only the first piece of a LOB is copied out of
+  the row. print_tab_data() asks for the rest piece by piece through
+  result_cursor_put_lob(), and on a terminal no more than
+  MAX_COLUMN_LENGTH bytes are shown, so that a large LOB is never copied
+  whole. The client library has the whole row in memory all the same:
+  mysql_stmt_fetch_column() only copies from it. A CLOB cut on a
+  terminal ends with "..." after its last whole character, and com_go()
+  tells how many values were cut. Statements
+  with columns that the binary protocol would print differently, see
+  is_cursor_text_field() and is_cursor_mysql_field(), are sent as usual.
+
+  @retval -1  the statement must be sent as usual
+  @retval 0   the cursor is open
+  @return     else the result of reporting the error
+*/
+
+static int result_cursor_open(String *buffer)
 {
-  if (!pos)
-    tee_fputs("NULL", PAGER);
+  RESULT_CURSOR *rc= &cursor;
+  ulong cursor_type= (ulong) CURSOR_TYPE_READ_ONLY;
+  MYSQL_FIELD *fields;
+  const char *word;
+  size_t length;
+  int error;
+
+  if (!(mysql.oracle_mode ? opt_lob_chunk_size : opt_cursor_fetch) ||
+      !(word= statement_first_word(*buffer, &length)) ||
+      !((length == 6 && !strncasecmp(word, "SELECT", 6)) ||
+        (length == 4 && !strncasecmp(word, "WITH", 4))))
+    return -1;
+
+  bzero((char*) rc, sizeof(*rc));
+  if (!(rc->stmt= mysql_stmt_init(&mysql)))
+    return put_error(&mysql);
+  /*
+    Statements that can't be prepared, like several statements in one,
+    and SELECT ... INTO are sent as usual, which reports their errors.
+  */
+  if (mysql_stmt_prepare(rc->stmt, buffer->ptr(), buffer->length()) ||
+      !(rc->num_fields= mysql_stmt_field_count(rc->stmt)) ||
+      !(mysql.oracle_mode ? statement_has_lob(rc->stmt) :
+                            statement_is_mysql_text(rc->stmt)))
+  {
+    mysql_stmt_close(rc->stmt);
+    return -1;
+  }
+  /*
+    LOBs are cut only on a terminal, and read piece by piece only where
+    com_go() is sure to print with print_tab_data().
+  */
+  if (!mysql.oracle_mode || opt_html || opt_xml)
+    rc->lob_fetch= LOB_WHOLE;
+  else if (!status.batch)
+    rc->lob_fetch= LOB_CUT;
+  else if (opt_silent && verbose <= 2 && !output_tables && !vertical &&
+           !auto_vertical_output)
+    rc->lob_fetch= LOB_PIECES;
   else
+    rc->lob_fetch= LOB_WHOLE;
+  rc->lob_buffer= rc->lob_fetch == LOB_CUT ?
+                  MY_MIN(opt_lob_chunk_size, MAX_COLUMN_LENGTH) :
+                  opt_lob_chunk_size;
+  /* Rows with large LOBs come one at a time until the sizes are known */
+  rc->prefetch= opt_cursor_fetch ? opt_cursor_fetch : 1;
+  if (mysql_stmt_attr_set(rc->stmt, STMT_ATTR_CURSOR_TYPE, &cursor_type) ||
+      mysql_stmt_attr_set(rc->stmt, STMT_ATTR_PREFETCH_ROWS, &rc->prefetch) ||
+      mysql_stmt_execute(rc->stmt))
+    goto err;
+  if (!(rc->metadata= mysql_stmt_result_metadata(rc->stmt)) ||
+      !(rc->bind= (MYSQL_BIND*) my_malloc(sizeof(MYSQL_BIND) * rc->num_fields,
+                                          MYF(MY_WME | MY_ZEROFILL))) ||
+      !(rc->row= (MYSQL_ROW) my_malloc(sizeof(char*) * rc->num_fields,
+                                       MYF(MY_WME))) ||
+      !(rc->lengths= (ulong*) my_malloc(sizeof(ulong) * rc->num_fields,
+                                        MYF(MY_WME))) ||
+      !(rc->is_null= (my_bool*) my_malloc(rc->num_fields, MYF(MY_WME))) ||
+      !(rc->truncated= (my_bool*) my_malloc(rc->num_fields, MYF(MY_WME))) ||
+      !(rc->lob_lengths= (ulong*) my_malloc(sizeof(ulong) * rc->num_fields,
+                                            MYF(MY_WME | MY_ZEROFILL))))
+    goto err;
+
+  /* All columns are fetched as text, as the printers expect them */
+  fields= mysql_fetch_fields(rc->metadata);
+  for (uint i= 0; i < rc->num_fields; i++)
   {
-    if (opt_raw_data)
-    {
-      unsigned long i;
-      /* Can't use tee_fputs(), it stops with NUL characters. */
-      for (i= 0; i < length; i++, pos++)
-        tee_putc(*pos, PAGER);
-    }
-    else for (const char *end=pos+length ; pos != end ; pos++)
+    MYSQL_BIND *bind= &rc->bind[i];
+    ulong size= MY_MIN(fields[i].length, CURSOR_COLUMN_BUFFER) + 1;
+
+    if (mysql.oracle_mode)
     {
-#ifdef USE_MB
-      int l;
-      if (use_mb(charset_info) &&
-          (l = my_ismbchar(charset_info, pos, end)))
-      {
-	  while (l--)
-	    tee_putc(*pos++, PAGER);
-	  pos--;
-	  continue;
-      }
-#endif
-      if (!*pos)
-	tee_fputs("\\0", PAGER); // This makes everything hard
-      else if (*pos == '\t')
-	tee_fputs("\\t", PAGER); // This would destroy tab format
-      else if (*pos == '\n')
-	tee_fputs("\\n", PAGER); // This too
-      else if (*pos == '\\')
-	tee_fputs("\\\\", PAGER);
-	else
-	tee_putc(*pos, PAGER);
-    }
-  }
+      /* Nothing tells the widths for the table formats in advance */
+      fields[i].max_length= MY_MIN(fields[i].length, MAX_COLUMN_LENGTH);
+      if (is_lob_field(&fields[i]))
+        size= rc->lob_buffer + 1;
+    }
+    if (!(bind->buffer= my_malloc(size, MYF(MY_WME))))
+      goto err;
+    bind->buffer_type= MYSQL_TYPE_STRING;
+    bind->buffer_length= size - 1;      /* Room for the end \0 */
+    bind->length= &rc->lengths[i];
+    bind->is_null= &rc->is_null[i];
+    bind->error= &rc->truncated[i];
+  }
+  if (mysql_stmt_bind_result(rc->stmt, rc->bind))
+    goto err;
+  rc->batch_start= my_interval_timer();
+  result_cursor= rc;
+  return 0;
+
+err:
+  error= mysql_stmt_errno(rc->stmt) ? put_stmt_error(&mysql, rc->stmt) :
+                                      put_info("Can't open the cursor",
+                                               INFO_ERROR);
+  if (rc->metadata)
+    mysql_free_result(rc->metadata);
+  result_cursor_free(rc);
+  return error;
 }
 
 
-static void
-print_tab_data(MYSQL_RES *result)
+/**
+  Choose the rows of the next round trip from the batch just printed.
+  Growth is limited to doubling, so that one batch of short rows doesn't
+  make the next one of long rows huge.
+*/
+
+static void result_cursor_adapt(RESULT_CURSOR *rc)
 {
-  MYSQL_ROW	cur;
-  MYSQL_FIELD	*field;
-  ulong		*lengths;
+  ulonglong now= my_interval_timer();
+  ulonglong elapsed= MY_MAX(now - rc->batch_start, 1);
+  ulonglong row_bytes= MY_MAX(rc->batch_bytes / rc->batch_rows, 1);
+  ulonglong rows= MY_MIN(CURSOR_BATCH_BYTES / row_bytes,
+                         rc->batch_rows * CURSOR_BATCH_TIME / elapsed);
+  ulong prefetch;
+
+  set_if_smaller(rows, (ulonglong) rc->prefetch * 2);
+  set_if_smaller(rows, CURSOR_MAX_PREFETCH);
+  set_if_bigger(rows, 1);
+  prefetch= (ulong) rows;
+  if (prefetch != rc->prefetch &&
+      !mysql_stmt_attr_set(rc->stmt, STMT_ATTR_PREFETCH_ROWS, &prefetch))
+    rc->prefetch= prefetch;
+  rc->batch_rows= 0;
+  rc->batch_bytes= 0;
+  rc->batch_start= now;
+}
+
+
+static MYSQL_ROW result_cursor_fetch(RESULT_CURSOR *rc, ulong **lengths)
+{
+  int res;
 
-  if (is_termout_oracle_enable(&mysql)) {
-    if (opt_silent < 2 && column_names)
+  if (rc->batch_rows == rc->prefetch)
+    result_cursor_adapt(rc);
+  if ((res= mysql_stmt_fetch(rc->stmt)) == 1 || res == MYSQL_NO_DATA)
+    return NULL;
+
+  for (uint i= 0; i < rc->num_fields; i++)
+  {
+    MYSQL_BIND *bind= &rc->bind[i];
+
+    rc->lob_lengths[i]= 0;
+    if (rc->is_null[i])
     {
-      int first = 0;
-      while ((field = mysql_fetch_field(result)))
+      rc->row[i]= NULL;
+      rc->lengths[i]= 0;
+      continue;
+    }
+    if (rc->truncated[i] && rc->lob_fetch != LOB_WHOLE &&
+        is_lob_field(&rc->metadata->fields[i]))
+    {
+      /* The first piece is in the buffer, the rest is read when printed */
+      if (rc->lob_fetch == LOB_PIECES)
+        rc->lob_lengths[i]= rc->lengths[i];
+      rc->lengths[i]= bind->buffer_length;
+      if (rc->lob_fetch == LOB_CUT)
       {
-        if (first++)
-          (void)tee_fputs("\t", PAGER);
-        (void)tee_fputs(field->name, PAGER);
+        rc->lob_cut++;
+        if (rc->metadata->fields[i].charsetnr != 63 &&     /* Not binary */
+            bind->buffer_length > 3)
+        {
+          /* Don't show part of a character */
+          char *value= (char*) bind->buffer;
+          size_t keep= bind->buffer_length - 3;
+          int well_formed_error;
+          keep= my_well_formed_length(charset_info, value, value + keep, keep,
+                                      &well_formed_error);
+          memcpy(value + keep, "...", 3);
+          rc->lengths[i]= (ulong) keep + 3;
+        }
       }
-      (void)tee_fputs("\n", PAGER);
     }
-  }
-  
-  while ((cur = mysql_fetch_row(result)))
-  {
-    if (!is_termout_oracle_enable(&mysql))
-      continue;
-
-    lengths=mysql_fetch_lengths(result);
-    field= mysql_fetch_fields(result);
-    if (mysql.oracle_mode && is_binary_field_oracle(&field[0]))
-      print_as_hex_oracle(PAGER, cur[0], lengths[0], lengths[0]);
-    else if (opt_binhex && is_binary_field(&field[0]))
-      print_as_hex(PAGER, cur[0], lengths[0], lengths[0]);
-    else
-      safe_put_field(cur[0],lengths[0]);
-
-    for (uint off=1 ; off < mysql_num_fields(result); off++)
+    else if (rc->truncated[i])
     {
-      (void) tee_fputs("\t", PAGER);
-      if (mysql.oracle_mode && field && is_binary_field_oracle(&field[off]))
-        print_as_hex_oracle(PAGER, cur[off], lengths[off], lengths[off]);
-      else if (opt_binhex && field && is_binary_field(&field[off]))
-        print_as_hex(PAGER, cur[off], lengths[off], lengths[off]);
-      else
-        safe_put_field(cur[off], lengths[off]);
+      /* Keep the larger buffer for the following rows */
+      void *buffer;
+      if (!(buffer= my_realloc(bind->buffer, rc->lengths[i] + 1,
+                               MYF(MY_WME))))
+        return NULL;
+      bind->buffer= buffer;
+      bind->buffer_length= rc->lengths[i];
+      if (mysql_stmt_bind_result(rc->stmt, rc->bind) ||
+          mysql_stmt_fetch_column(rc->stmt, bind, i, 0))
+        return NULL;
     }
-    (void) tee_fputs("\n", PAGER);
+    rc->row[i]= (char*) bind->buffer;
+    rc->row[i][rc->lengths[i]]= '\0';   /* The printers rely on it */
+    rc->batch_bytes+= rc->lengths[i];
   }
+  rc->batch_rows++;
+  rc->metadata->row_count++;            /* For mysql_num_rows() */
+  *lengths= rc->lengths;
+  return rc->row;
 }
 
-static int
-com_tee(String *buffer __attribute__((unused)),
-        char *line __attribute__((unused)))
-{
-  char file_name[FN_REFLEN], *end, *param;
 
-  //if (status.batch)
-  //  return 0;
-  while (my_isspace(charset_info,*line))
-    line++;
-  if (!(param = strchr(line, ' '))) // if outfile wasn't given, use the default
+/**
+  Print the part of a LOB column of the current row that
+  result_cursor_fetch() left out, a piece at a time, the way
+  print_tab_data() printed the first piece.
+*/
+
+static void result_cursor_put_lob(RESULT_CURSOR *rc, uint column)
+{
+  MYSQL_FIELD *field= &rc->metadata->fields[column];
+  MYSQL_BIND piece= rc->bind[column];
+  ulong offset= rc->lengths[column], total= rc->lob_lengths[column];
+  ulong length;
+  my_bool truncated;
+
+  piece.length= &length;
+  piece.error= &truncated;
+  while (offset < total)
   {
-    if (!strlen(outfile))
-    {
-      printf("No previous outfile available, you must give a filename!\n");
-      return 0;
-    }
-    else if (opt_outfile)
-    {
-      tee_fprintf(stdout, "Currently logging to file '%s'\n", outfile);
-      return 0;
-    }
+    ulong bytes;
+    if (mysql_stmt_fetch_column(rc->stmt, &piece, column, offset))
+      break;
+    bytes= MY_MIN(total - offset, piece.buffer_length);
+    if ((mysql.oracle_mode && is_binary_field_oracle(field)) ||
+        (opt_binhex && is_binary_field(field)))
+      print_hex_digits(PAGER, (char*) piece.buffer, bytes);
     else
-      param = outfile;			//resume using the old outfile
+      safe_put_field((char*) piece.buffer, bytes);
+    offset+= bytes;
   }
+}
 
-  /* eliminate the spaces before the parameters */
-  while (my_isspace(charset_info,*param))
-    param++;
-  end= strmake_buf(file_name, param);
-  /* remove end space from command line */
-  while (end > file_name && (my_isspace(charset_info,end[-1]) || 
-			     my_iscntrl(charset_info,end[-1])))
-    end--;
-  end[0]= 0;
-  if (end == file_name)
+
+static void result_cursor_end()
+{
+  if (result_cursor)
   {
-    printf("No outfile specified!\n");
-    return 0;
+    result_cursor_free(result_cursor);
+    result_cursor= NULL;
   }
-  init_tee(file_name);
-  return 0;
 }
 
 
-static int
-com_notee(String *buffer __attribute__((unused)),
-	  char *line __attribute__((unused)))
+/* Where fetch_result_row() takes the rows from */
+
+static MYSQL_ROW read_result_row(MYSQL_RES *result, ulong **lengths)
 {
-  if (opt_outfile)
-    end_tee();
-  tee_fprintf(stdout, "Outfile disabled.\n");
-  return 0;
-}
+  ROW_PIPELINE *pl= row_pipeline;
+  MYSQL_ROW cur;
 
-/*
-  Sorry, this command is not available in Windows.
-*/
-
-#ifdef USE_POPEN
-static int
-com_pager(String *buffer __attribute__((unused)),
-          char *line __attribute__((unused)))
-{
-  char pager_name[FN_REFLEN], *end, *param;
+  if (result_store)
+    return result_store_fetch(result_store, lengths);
+  if (result_cursor)
+    return result_cursor_fetch(result_cursor, lengths);
+  if (!pl)
+  {
+    if ((cur= mysql_fetch_row(result)))
+      *lengths= mysql_fetch_lengths(result);
+    return cur;
+  }
 
-  if (status.batch)
-    return 0;
-  /* Skip spaces in front of the pager command */
-  while (my_isspace(charset_info, *line))
-    line++;
-  /* Skip the pager command */
-  param= strchr(line, ' ');
-  /* Skip the spaces between the command and the argument */
-  while (param && my_isspace(charset_info, *param))
-    param++;
-  if (!param || !strlen(param)) // if pager was not given, use the default
+  for (;;)
   {
-    if (!default_pager_set)
+    if (pl->printing)
     {
-      tee_fprintf(stdout, "Default pager wasn't set, using stdout.\n");
-      opt_nopager=1;
-      strmov(pager, "stdout");
-      PAGER= stdout;
-      return 0;
+      ROW_BATCH *batch= &pl->batches[pl->tail];
+      if (pl->pos < batch->count)
+      {
+        *lengths= batch->lengths[pl->pos];
+        return batch->rows[pl->pos++];
+      }
+      /* Give the batch back to the reader */
+      pthread_mutex_lock(&pl->lock);
+      pl->printing= 0;
+      pl->tail= (pl->tail + 1) % PIPELINE_BATCHES;
+      pl->filled--;
+      pthread_cond_signal(&pl->cond);
+      pthread_mutex_unlock(&pl->lock);
+    }
+
+    pthread_mutex_lock(&pl->lock);
+    while (!pl->filled && !pl->eof)
+      pthread_cond_wait(&pl->cond, &pl->lock);
+    if (!pl->filled)
+    {
+      pthread_mutex_unlock(&pl->lock);
+      return NULL;
     }
-    strmov(pager, default_pager);
-  }
-  else
-  {
-    end= strmake_buf(pager_name, param);
-    while (end > pager_name && (my_isspace(charset_info,end[-1]) || 
-                                my_iscntrl(charset_info,end[-1])))
-      end--;
-    end[0]=0;
-    strmov(pager, pager_name);
-    strmov(default_pager, pager_name);
+    pthread_mutex_unlock(&pl->lock);
+    pl->printing= 1;
+    pl->pos= 0;
   }
-  opt_nopager=0;
-  tee_fprintf(stdout, "PAGER set to '%s'\n", pager);
-  return 0;
 }
 
 
-static int
-com_nopager(String *buffer __attribute__((unused)),
-	    char *line __attribute__((unused)))
+/**
+  Return the next row of the result being printed, together with the
+  lengths of its columns.
+
+  When the rows are streamed (--quick, with or without the row pipeline,
+  or a cursor, which com_go() runs as --quick) the end of the result is
+  when the last row arrived, which is the first time no row is returned:
+  printers that ask again later must not move it. A stored result had all its rows when
+  com_go() set that time, and printing them is not part of it.
+*/
+
+static MYSQL_ROW fetch_result_row(MYSQL_RES *result, ulong **lengths)
 {
-  strmov(pager, "stdout");
-  opt_nopager=1;
-  PAGER= stdout;
-  tee_fprintf(stdout, "PAGER set to stdout\n");
-  return 0;
+  MYSQL_ROW cur;
+
+  if (!(cur= read_result_row(result, lengths)) && quick &&
+      !statement_profile.last_row)
+    statement_profile.last_row= microsecond_interval_timer();
+  return cur;
 }
-#endif
 
 
 /*
-  Sorry, you can't send the result to an editor in Win32
+  Rows read ahead of printing when the result comes from mysql_use_result().
+  The rows are copied, because the library reuses its row buffer on every
+  mysql_fetch_row() call.
 */
 
-#ifdef USE_POPEN
-static int
-com_edit(String *buffer,char *line __attribute__((unused)))
+typedef struct st_row_lookahead
 {
-  char	filename[FN_REFLEN],buff[160];
-  int	fd,tmp,error;
-  const char *editor;
-  MY_STAT stat_arg;
-
-  if ((fd= create_temp_file(filename,NullS,"sql", 0, MYF(MY_WME))) < 0)
-    goto err;
-  if (buffer->is_empty() && !old_buffer.is_empty())
-    (void) my_write(fd,(uchar*) old_buffer.ptr(),old_buffer.length(),
-		    MYF(MY_WME));
-  else
-    (void) my_write(fd,(uchar*) buffer->ptr(),buffer->length(),MYF(MY_WME));
-  (void) my_close(fd,MYF(0));
-
-  if (!(editor = (char *)getenv("EDITOR")) &&
-      !(editor = (char *)getenv("VISUAL")))
-    editor = "vi";
-  strxmov(buff,editor," ",filename,NullS);
-  if ((error= system(buff)))
-  {
-    char errmsg[100];
-    sprintf(errmsg, "Command '%.40s' failed", buff);
-    put_info(errmsg, INFO_ERROR, 0, NullS);
-    goto err;
-  }
-
-  if (!my_stat(filename,&stat_arg,MYF(MY_WME)))
-    goto err;
-  if ((fd = my_open(filename,O_RDONLY, MYF(MY_WME))) < 0)
-    goto err;
-  (void) buffer->alloc((uint) stat_arg.st_size);
-  if ((tmp=read(fd,(char*) buffer->ptr(),buffer->alloced_length())) >= 0L)
-    buffer->length((uint) tmp);
-  else
-    buffer->length(0);
-  (void) my_close(fd,MYF(0));
-  (void) my_delete(filename,MYF(MY_WME));
-err:
-  return 0;
-}
-#endif
+  MEM_ROOT mem_root;
+  MYSQL_ROW *rows;
+  ulong **lengths;
+  ulong count, pos;
+} ROW_LOOKAHEAD;
 
 
-/* If arg is given, exit without errors. This happens on command 'quit' */
+/**
+  Read up to max_rows rows of an unbuffered result and set max_length of
+  every field to the widest value seen.
 
-static int
-com_quit(String *buffer __attribute__((unused)),
-	 char *line __attribute__((unused)))
-{
-  status.exit_status=0;
-  return 1;
-}
+  @return 1 if the result was exhausted within the window, else 0
+*/
 
-static int
-com_rehash(String *buffer __attribute__((unused)),
-	 char *line __attribute__((unused)))
+static bool
+lookahead_fill(ROW_LOOKAHEAD *la, MYSQL_RES *result, ulong max_rows)
 {
-#ifdef HAVE_READLINE
-  build_completion_hash(1, 0);
-#endif
-  return 0;
-}
+  uint num_fields= mysql_num_fields(result);
+  MYSQL_FIELD *fields= mysql_fetch_fields(result);
+  MYSQL_ROW cur;
 
+  init_alloc_root(&la->mem_root, "lookahead", 65536, 0, MYF(0));
+  la->count= la->pos= 0;
+  la->rows= (MYSQL_ROW*) alloc_root(&la->mem_root, sizeof(MYSQL_ROW) * max_rows);
+  la->lengths= (ulong**) alloc_root(&la->mem_root, sizeof(ulong*) * max_rows);
+  if (!la->rows || !la->lengths)
+    return 0;
 
-#ifdef USE_POPEN
-static int
-com_shell(String *buffer __attribute__((unused)),
-          char *line __attribute__((unused)))
-{
-  char *shell_cmd;
+  for (uint i= 0; i < num_fields; i++)
+    fields[i].max_length= 0;
 
-  /* Skip space from line begin */
-  while (my_isspace(charset_info, *line))
-    line++;
-  if (!(shell_cmd = strchr(line, ' ')))
-  {
-    put_info("Usage: \\! shell-command", INFO_ERROR);
-    return -1;
-  }
-  /*
-    The output of the shell command does not
-    get directed to the pager or the outfile
-  */
-  if (system(shell_cmd) == -1)
+  while (la->count < max_rows && !interrupted_query)
   {
-    put_info(strerror(errno), INFO_ERROR, errno);
-    return -1;
+    ulong *lengths;
+
+    if (!(cur= fetch_result_row(result, &lengths)))
+      return 1;
+    if (copy_result_row(&la->mem_root, cur, lengths, num_fields,
+                        &la->rows[la->count], &la->lengths[la->count]))
+      return 0;
+    for (uint i= 0; i < num_fields; i++)
+      if (cur[i])
+        set_if_bigger(fields[i].max_length, lengths[i]);
+    la->count++;
   }
   return 0;
 }
-#endif
 
 
-static int
-com_print(String *buffer,char *line __attribute__((unused)))
-{
-  tee_puts("--------------", stdout);
-  (void) tee_fputs(buffer->c_ptr(), stdout);
-  if (!buffer->length() || (*buffer)[buffer->length()-1] != '\n')
-    tee_putc('\n', stdout);
-  tee_puts("--------------\n", stdout);
-  return 0;					/* If empty buffer */
-}
-
-static std::string get_password() {
-  std::string password;
-  char ch;
+/**
+  Return the next row, first from the look-ahead window and then
+  from the result.
+*/
 
-#ifndef _WIN32
-  while ((ch = sh_getch()) != '\r') {
-#else
-  while ((ch = getch()) != '\r') {
-#endif
-    if (ch == '\b') {
-      if (!password.empty()) {
-        password.pop_back();
-      }
-    } else {
-      password += ch;
-    }
+static MYSQL_ROW
+lookahead_fetch_row(ROW_LOOKAHEAD *la, MYSQL_RES *result, ulong **lengths)
+{
+  if (la && la->pos < la->count)
+  {
+    *lengths= la->lengths[la->pos];
+    return la->rows[la->pos++];
   }
-  tee_fprintf(stdout, "\n");
-  return password;
+  return fetch_result_row(result, lengths);
 }
 
-	/* ARGSUSED */
-static int
-com_connect(String *buffer, char *line)
-{
-  char *tmp, buff[256] = {0};
-  my_bool save_rehash= opt_rehash;
-  int error;
-  int rewrite = 0;
-  char *newuser = NULL, *newtenant = NULL, *oldtenant = NULL;
-  std::string passwd;
-  std::string saveuser = current_user;
-  std::string savehost = current_host_success;
-  int saveport = current_port_success;
 
-  //To relink, need to reinitialize this global variable
-  dbms_serveroutput = 0;
-  dbms_prepared = 0;
-  if (dbms_stmt) {
-    mysql_stmt_close(dbms_stmt);
-    dbms_stmt = NULL;
-  }
+static void
+print_table_data(MYSQL_RES *result)
+{
+  String separator(256);
+  MYSQL_ROW	cur;
+  MYSQL_FIELD	*field;
+  bool		*num_flag;
+  ROW_LOOKAHEAD lookahead, *la= NULL;
+  bool          exact_widths= 0;
 
-  if (current_user) {
-    split_fullname(current_user, NULL, &oldtenant);
+  num_flag=(bool*) my_alloca(sizeof(bool)*mysql_num_fields(result));
+  if (column_types_flag)
+  {
+    print_field_types(result);
+    if (!mysql_num_rows(result))
+      return;
+    mysql_field_seek(result,0);
   }
-
-  bzero(buff, sizeof(buff));
-  if (buffer)
+  if (quick && opt_quick_lookahead)
   {
     /*
-      Two null bytes are needed in the end of buff to allow
-      get_arg to find end of string the second time it's called.
+      Size the columns from the first rows instead of the declared lengths.
+      Later rows wider than the window are printed in full.
     */
-    String tmpbuf;
-    tmpbuf.append(line);
-    if (last_session_mode && is_define_oracle) {
-      scan_define_oracle(&tmpbuf, 0);
+    la= &lookahead;
+    exact_widths= lookahead_fill(la, result, opt_quick_lookahead);
+    mysql_field_seek(result, 0);
+  }
+  separator.copy("+",1,charset_info);
+  while ((field = mysql_fetch_field(result)))
+  {
+    uint length= column_names ? field->name_length : 0;
+    if (la)
+    {
+      length= MY_MAX(length, field->max_length);
+      if (!exact_widths && !field->max_length)
+        length= MY_MAX(length, MY_MIN(field->length, MAX_COLUMN_LENGTH));
     }
-
-    tmp= strmake(buff, tmpbuf.c_ptr(), sizeof(buff)-2);
-#ifdef EXTRA_DEBUG
-    tmp[1]= 0;
-#endif
-
-    rewrite = rewrite_by_oracle(buff);
-    if (-1 == rewrite) {
-      // invalid connect string...
-      tee_fprintf(stdout, "Connect string is invalid...\n");
-      if (oldtenant)
-        my_free(oldtenant);
-      oldtenant = NULL;
-      return 0;
-    } else if (1 == rewrite) {
-      // connect username@tenant[/password[@[//]host[:port]]]
-      // connect username[/password[@[//]host[:port]]]
-      int i = 1;
-      tmp = get_arg_string(buff, GET);
-      if (tmp && *tmp) {
-        my_free(current_user);
-        current_user = my_strdup(tmp, MYF(MY_WME));
-        tmp = get_arg_by_index(buff, i++);
-        if (tmp && *tmp) {
-          int ilen = strlen(tmp);
-          char szbuf[128] = { 0 };
-          memset(szbuf, 0, sizeof(szbuf));
-          if (*tmp == '\"' && *(tmp + ilen-1) == '\"' && ilen > 2) {
-            memcpy(szbuf, tmp + 1, ilen - 2);
-          } else {
-            memcpy(szbuf, tmp, ilen);
-          }
-          my_free(opt_password);
-          opt_password = my_strdup(szbuf, MYF(MY_WME));
-          tmp = get_arg_by_index(buff, i++);
-          if (tmp && *tmp) {
-            my_free(current_host);
-            current_host = my_strdup(tmp, MYF(MY_WME));
-            my_free(current_host_success);
-            current_host_success = my_strdup(tmp, MYF(MY_WME));
-
-            tmp = get_arg_by_index(buff, i++);
-            if (tmp && *tmp) {
-              errno = 0;
-              char *endchar;
-              ulonglong port;
-              port = strtoull(tmp, &endchar, 10);
-              if (errno == ERANGE) {
-                my_getopt_error_reporter(ERROR_LEVEL, "Incorrect unsigned integer value: '%s'", tmp);
-                if (oldtenant)
-                  my_free(oldtenant);
-                oldtenant = NULL;
-                return 1;
-              } else {
-                opt_mysql_port = (uint)port;
-                current_port_success = (int)port;
-              }
-            }
-          }
-        } else {
-          tee_fprintf(stdout, "Enter password:");
-          passwd = get_password();
-          my_free(opt_password);
-          opt_password = my_strdup(passwd.c_str(), MYF(MY_WME));
-        }
-        split_fullname(current_user, &newuser, &newtenant);
-        if (newuser && !newtenant && oldtenant) {
-          snprintf(buff, sizeof(buff), "%s%s", newuser, oldtenant);
-          my_free(current_user);
-          current_user = my_strdup(buff, MYF(MY_WME));
-        }
+    else if (quick) {
+      if (mysql.oracle_mode) {
+        // for oracle mode, use max_length, max_length for use result change
+        length= MY_MAX(length, field->max_length);
       } else {
-        /* Quick re-connect */
-        opt_rehash = 0;                            /* purecov: tested */
+        length= MY_MAX(length,field->length);
       }
-    } else {
-      // connect db host
-      if (last_session_mode) {
-        //oracle mode
-        tmp = get_arg_string(buff, GET);
-        if (tmp && *tmp) {
-          my_free(current_user);
-          current_user = my_strdup(tmp, MYF(MY_WME));
-          split_fullname(current_user, &newuser, &newtenant);
-          if (newuser && !newtenant && oldtenant) {
-            snprintf(buff, sizeof(buff), "%s%s", newuser, oldtenant);
-            my_free(current_user);
-            current_user = my_strdup(buff, MYF(MY_WME));
-          }
-          
-          tee_fprintf(stdout, "Enter password:");
-          passwd = get_password();
-          my_free(opt_password);
-          opt_password = my_strdup(passwd.c_str(), MYF(MY_WME));
-        } else {
-          opt_rehash = 0;                            /* purecov: tested */
-        }
-      } else {
-        tmp = get_arg_string(buff, GET);
-        if (tmp && *tmp) {
-          my_free(current_db);
-          current_db = my_strdup(tmp, MYF(MY_WME));
-          tmp = get_arg_string(buff, GET_NEXT);
-          if (tmp && *tmp) {
-            my_free(current_host);
-            current_host = my_strdup(tmp, MYF(MY_WME));
-            my_free(current_host_success);
-            current_host_success = my_strdup(tmp, MYF(MY_WME));
-          }
-        } else {
-          /* Quick re-connect */
-          opt_rehash = 0;                            /* purecov: tested */
-        }
+    } else
+      length= MY_MAX(length,field->max_length);
+    if (length < 4 /*&& !IS_NOT_NULL(field->flags)*/)
+      length=4;					// Room for "NULL"
+    if (mysql.oracle_mode && is_binary_field_oracle(field)) {
+      length = length * 2;
+    } else if (opt_binhex && is_binary_field(field)) {
+      length = 2 + length * 2;
+    }
+    field->max_length=length;
+    num_flag[mysql_field_tell(result) - 1]= IS_NUM(field->type);
+    separator.fill(separator.length()+length+2,'-');
+    separator.append('+');
+  }
+  separator.append('\0');                       // End marker for \0
+
+  if (is_termout_oracle_enable(&mysql)) {
+    tee_puts((char*)separator.ptr(), PAGER);
+    if (column_names)
+    {
+      mysql_field_seek(result, 0);
+      (void)tee_fputs("|", PAGER);
+      for (uint off = 0; (field = mysql_fetch_field(result)); off++)
+      {
+        size_t name_length = (uint)strlen(field->name);
+        size_t numcells = charset_info->cset->numcells(charset_info,
+          field->name,
+          field->name + name_length);
+        size_t display_length = field->max_length + name_length - numcells;
+        tee_fprintf(PAGER, " %-*s |", (int)MY_MIN(display_length,
+          MAX_COLUMN_LENGTH),
+          field->name);
       }
+      (void)tee_fputs("\n", PAGER);
+      tee_puts((char*)separator.ptr(), PAGER);
     }
-    buffer->length(0);				// command used
-    opt_mysql_port = current_port_success;
-    error = sql_connect(current_host_success, NULL, current_user, opt_password, 100);
-    if (connected && !mysql.oracle_mode) {
-      sprintf(buff, "use %s", current_db);
-      if (mysql_query(&mysql, buff)) {
-        put_error(&mysql);
+  }
+
+  ulong *lengths;
+  while ((cur= lookahead_fetch_row(la, result, &lengths)))
+  {
+    if (interrupted_query)
+      break;
+    if (!is_termout_oracle_enable(&mysql))
+      continue;
+    
+    (void) tee_fputs("| ", PAGER);
+    mysql_field_seek(result, 0);
+    for (uint off= 0; off < mysql_num_fields(result); off++)
+    {
+      const char *buffer;
+      uint data_length;
+      uint field_max_length;
+      uint extra_padding;
+
+      if (off)
+        (void) tee_fputs(" ", PAGER);
+
+      if (cur[off] == NULL)
+      {
+        buffer= "NULL";
+        data_length= 4;
+      } 
+      else 
+      {
+        buffer= cur[off];
+        data_length= (uint) lengths[off];
+      }
+
+      field= mysql_fetch_field(result);
+      if (!field)
+        continue;
+
+      field_max_length= field->max_length;
+
+      /* 
+       How many text cells on the screen will this string span?  If it contains
+       multibyte characters, then the number of characters we occupy on screen
+       will be fewer than the number of bytes we occupy in memory.
+
+       We need to find how much screen real-estate we will occupy to know how 
+       many extra padding-characters we should send with the printing function.
+      */
+      size_t visible_length= charset_info->cset->numcells(charset_info, buffer, buffer + data_length);
+      extra_padding= (uint) (data_length - visible_length);
+
+      if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type) && IS_NUM_BINARY_TERMINAL(field->type)) {
+        /* 1.23456E+008 */
+        format_fix_width_num_binary(cur[off], lengths[off]);
+        if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
+          tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length, TRUE);
+        else 
+          tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length, FALSE);
+      }
+      else if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type)) {
+        /* 123456.6754321 */
+        format_fix_width_num(cur[off], lengths[off]);
+        //if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
+        tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length+extra_padding, TRUE);
+        //else 
+        //tee_print_sized_data(obclient_num_array, strlen(obclient_num_array), field_max_length+extra_padding, FALSE);
+        
+      }
+      else if (mysql.oracle_mode && cur[off] && is_binary_field_oracle(field))
+        print_as_hex_oracle(PAGER, cur[off], lengths[off], field_max_length);
+      else if (opt_binhex && cur[off] && is_binary_field(field))
+        print_as_hex(PAGER, cur[off], lengths[off], field_max_length);
+      else if (field_max_length > MAX_COLUMN_LENGTH)
+        tee_print_sized_data(buffer, data_length, MAX_COLUMN_LENGTH+extra_padding, FALSE);
+      else
+      {
+        if (num_flag[off] != 0) /* if it is numeric, we right-justify it */
+          tee_print_sized_data(buffer, data_length, field_max_length+extra_padding, TRUE);
+        else 
+          tee_print_sized_data(buffer, data_length, field_max_length+extra_padding, FALSE);
       }
+      tee_fputs(" |", PAGER);
+    }
+    (void) tee_fputs("\n", PAGER);
+  }
+  if (is_termout_oracle_enable(&mysql)) {
+    tee_puts((char*)separator.ptr(), PAGER);
+  }
+  if (la)
+    free_root(&la->mem_root, MYF(0));
+  my_afree((uchar*) num_flag);
+}
+
+/**
+  Return the length of a field after it would be rendered into text.
+
+  This doesn't know or care about multibyte characters.  Assume we're
+  using such a charset.  We can't know that all of the upcoming rows 
+  for this column will have bytes that each render into some fraction
+  of a character.  It's at least possible that a row has bytes that 
+  all render into one character each, and so the maximum length is 
+  still the number of bytes.  (Assumption 1:  This can't be better 
+  because we can never know the number of characters that the DB is 
+  going to send -- only the number of bytes.  2: Chars <= Bytes.)
+
+  @param  field  Pointer to a field to be inspected
+
+  @returns  number of character positions to be used, at most
+*/
+static int get_field_disp_length(MYSQL_FIELD *field)
+{
+  uint length= column_names ? field->name_length : 0;
+
+  if (quick)
+    length= MY_MAX(length, field->length);
+  else
+    length= MY_MAX(length, field->max_length);
+
+  if (length < 4 && !IS_NOT_NULL(field->flags))
+    length= 4;				/* Room for "NULL" */
+
+  return length;
+}
+
+/**
+  For a new result, return the max number of characters that any
+  upcoming row may return.
+
+  @param  result  Pointer to the result to judge
+
+  @returns  The max number of characters in any row of this result
+*/
+
+static int get_result_width(MYSQL_RES *result)
+{
+  unsigned int len= 0;
+  MYSQL_FIELD *field;
+  MYSQL_FIELD_OFFSET offset;
+  
+#ifndef DBUG_OFF
+  offset= mysql_field_tell(result);
+  DBUG_ASSERT(offset == 0);
+#else
+  offset= 0;
+#endif
+
+  while ((field= mysql_fetch_field(result)) != NULL)
+    len+= get_field_disp_length(field) + 3; /* plus bar, space, & final space */
+
+  (void) mysql_field_seek(result, offset);	
+
+  return len + 1; /* plus final bar. */
+}
+
+/* Print data to the pager with every '\0' replaced by a space */
+
+static void
+print_nul_as_space(const char *data, size_t length)
+{
+  const char *end= data + length, *nul;
+  while ((nul= (const char*) memchr(data, '\0', (size_t) (end - data))))
+  {
+    tee_write(data, (size_t) (nul - data), PAGER);
+    tee_write(" ", 1, PAGER);
+    data= nul + 1;
+  }
+  tee_write(data, (size_t) (end - data), PAGER);
+}
+
+static void
+tee_print_sized_data(const char *data, unsigned int data_length, unsigned int total_bytes_to_send, bool right_justified)
+{
+  /* 
+    For '\0's print ASCII spaces instead, as '\0' is eaten by (at
+    least my) console driver, and that messes up the pretty table
+    grid.  (The \0 is also the reason we can't use fprintf() .) 
+  */
+  unsigned int padding= data_length < total_bytes_to_send ?
+                        total_bytes_to_send - data_length : 0;
+
+  if (right_justified) 
+    tee_fill(' ', padding, PAGER);
+
+  print_nul_as_space(data, data_length);
+
+  if (! right_justified) 
+    tee_fill(' ', padding, PAGER);
+}
+
+
+
+static void
+print_table_data_html(MYSQL_RES *result)
+{
+  MYSQL_ROW	cur;
+  MYSQL_FIELD	*field;
+  ulong		*lengths;
+
+  mysql_field_seek(result,0);
+  (void) tee_fputs("<TABLE BORDER=1>", PAGER);
+  if (column_names)
+  {
+    (void) tee_fputs("<TR>", PAGER);
+    while((field = mysql_fetch_field(result)))
+    {
+      tee_fputs("<TH>", PAGER);
+      if (field->name && field->name[0])
+        xmlencode_print(field->name, field->name_length);
+      else
+        tee_fputs(field->name ? " &nbsp; " : "NULL", PAGER);
+      tee_fputs("</TH>", PAGER);
+    }
+    (void) tee_fputs("</TR>", PAGER);
+  }
+  while ((cur = fetch_result_row(result, &lengths)))
+  {
+    if (interrupted_query)
+      break;
+    field= mysql_fetch_fields(result);
+    (void) tee_fputs("<TR>", PAGER);
+    for (uint i=0; i < mysql_num_fields(result); i++)
+    {
+      (void) tee_fputs("<TD>", PAGER);
+      if (mysql.oracle_mode && is_binary_field_oracle(&field[i])) {
+        if ((!force_set_num_width_close) && cur[i] && IS_NUM_BINARY_TERMINAL(field->type)) {
+          format_fix_width_num_binary(cur[i], lengths[i]); 
+          print_as_hex_oracle(PAGER, obclient_num_array, strlen(obclient_num_array), lengths[i]);
+        } else {
+          print_as_hex_oracle(PAGER, cur[i], lengths[i], lengths[i]);
+        }
+      }
+      else if (opt_binhex && is_binary_field(&field[i]))
+        print_as_hex(PAGER, cur[i], lengths[i], lengths[i]);
+      else {
+        if ((!force_set_num_width_close) && mysql.oracle_mode && cur[i] && IS_NUM_TERMINAL(field->type)) {
+          format_fix_width_num(cur[i], lengths[i]);
+          xmlencode_print(obclient_num_array, strlen(obclient_num_array));
+        } else {
+          xmlencode_print(cur[i], lengths[i]);
+        }
+      }
+      (void) tee_fputs("</TD>", PAGER);
+    }
+    (void) tee_fputs("</TR>", PAGER);
+  }
+  (void) tee_fputs("</TABLE>", PAGER);
+}
+
+
+static void
+print_table_data_xml(MYSQL_RES *result)
+{
+  MYSQL_ROW   cur;
+  MYSQL_FIELD *fields;
+  ulong       *lengths;
+
+  mysql_field_seek(result,0);
+
+  tee_fputs("<?xml version=\"1.0\"?>\n\n<resultset statement=\"", PAGER);
+  xmlencode_print(glob_buffer.ptr(), (int)strlen(glob_buffer.ptr()));
+  tee_fputs("\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">",
+            PAGER);
+
+  fields = mysql_fetch_fields(result);
+  while ((cur = fetch_result_row(result, &lengths)))
+  {
+    if (interrupted_query)
+      break;
+    (void) tee_fputs("\n  <row>\n", PAGER);
+    for (uint i=0; i < mysql_num_fields(result); i++)
+    {
+      tee_fprintf(PAGER, "\t<field name=\"");
+      xmlencode_print(fields[i].name, (uint) strlen(fields[i].name));
+      if (cur[i])
+      {
+        tee_fprintf(PAGER, "\">");
+        if (mysql.oracle_mode && is_binary_field_oracle(&fields[i])) {
+          if ((!force_set_num_width_close) && cur[i] && IS_NUM_BINARY_TERMINAL(fields[i].type)) {
+            format_fix_width_num_binary(cur[i], lengths[i]);
+            print_as_hex_oracle(PAGER, obclient_num_array, strlen(obclient_num_array), lengths[i]);
+          } else {
+            print_as_hex_oracle(PAGER, cur[i], lengths[i], lengths[i]);
+          }
+        }
+        else if (opt_binhex && is_binary_field(&fields[i]))
+          print_as_hex(PAGER, cur[i], lengths[i], lengths[i]);
+        else {
+          if ((!force_set_num_width_close) && mysql.oracle_mode && cur[i] && IS_NUM_TERMINAL(fields[i].type)) {
+            format_fix_width_num(cur[i], lengths[i]);
+            xmlencode_print(obclient_num_array, strlen(obclient_num_array));
+          } else {
+            xmlencode_print(cur[i], lengths[i]);
+          }
+        }
+        tee_fprintf(PAGER, "</field>\n");
+      }
+      else
+        tee_fprintf(PAGER, "\" xsi:nil=\"true\" />\n");
+    }
+    (void) tee_fputs("  </row>\n", PAGER);
+  }
+  (void) tee_fputs("</resultset>\n", PAGER);
+}
+
+
+static void
+print_table_data_vertically(MYSQL_RES *result)
+{
+  MYSQL_ROW	cur;
+  uint		max_length=0;
+  MYSQL_FIELD	*field;
+
+  while ((field = mysql_fetch_field(result)))
+  {
+    uint length= field->name_length;
+    if (length > max_length)
+      max_length= length;
+    field->max_length=length;
+  }
+
+  mysql_field_seek(result,0);
+  ulong *lengths;
+  for (uint row_count=1; (cur= fetch_result_row(result, &lengths)); row_count++)
+  {
+    if (interrupted_query)
+      break;
+    mysql_field_seek(result,0);
+    tee_fprintf(PAGER, 
+		"*************************** %d. row ***************************\n", row_count);
+
+    for (uint off=0; off < mysql_num_fields(result); off++)
+    {
+      field= mysql_fetch_field(result);
+      if (!field)
+        continue;
+
+      if (column_names)
+        tee_fprintf(PAGER, "%*s: ",(int) max_length,field->name);
+      if (cur[off])
+      {
+        const char *p;
+        unsigned long len;
+        if (opt_binhex && is_binary_field(field) && !mysql.oracle_mode)
+           tee_write("0x", 2, PAGER);
+
+        if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_BINARY_TERMINAL(field->type)) {
+          format_fix_width_num_binary(cur[off], lengths[off]);
+          p = obclient_num_array;
+          len = strlen(obclient_num_array);
+        } else if ((!force_set_num_width_close) && mysql.oracle_mode && cur[off] && IS_NUM_TERMINAL(field->type)) {
+          format_fix_width_num(cur[off], lengths[off]);
+          p = obclient_num_array;
+          len = strlen(obclient_num_array);
+        } else {
+          p = cur[off];
+          len = lengths[off];
+        }
+        if (opt_binhex && is_binary_field(field))
+          print_hex_digits(PAGER, p, len);
+        else
+          print_nul_as_space(p, len);
+        tee_putc('\n', PAGER);
+      }
+      else
+        tee_fprintf(PAGER, "NULL\n");
+    }
+  }
+}
+
+/* print_warnings should be called right after executing a statement */
+
+static void print_warnings()
+{
+  const char   *query = NULL;
+  MYSQL_RES    *result = NULL;
+  MYSQL_ROW    cur;
+  my_ulonglong num_rows;
+  
+  /* Save current error before calling "show warnings" */
+  uint error= mysql_errno(&mysql);
+
+  /* Get the warnings */
+  query= "show warnings";
+  if(mysql_real_query_for_lazy(query, strlen(query))){
+    goto end;
+  }
+  if(mysql_store_result_for_lazy(&result)) {
+    goto end;
+  }
+
+  /* Bail out when no warnings */
+  if (!result || !(num_rows= mysql_num_rows(result)))
+    goto end;
+
+  cur= mysql_fetch_row(result);
+
+  /*
+    Don't print a duplicate of the current error.  It is possible for SHOW
+    WARNINGS to return multiple errors with the same code, but different
+    messages.  To be safe, skip printing the duplicate only if it is the only
+    warning.
+  */
+  if (!cur || (num_rows == 1 && error == (uint) strtoul(cur[1], NULL, 10)))
+    goto end;
+
+  /* Print the warnings */
+  init_pager();
+  do
+  {
+    tee_fprintf(PAGER, "%s (Code %s): %s\n", cur[0], cur[1], cur[2]);
+  } while ((cur= mysql_fetch_row(result)));
+  end_pager();
+
+end:
+  if(result)
+    mysql_free_result(result);
+}
+
+
+static ESCAPE_SET tab_escapes, xml_escapes;
+
+static void init_escape_sets()
+{
+  init_escape_set(&tab_escapes, "\0\t\n\\", 4);
+  init_escape_set(&xml_escapes, "&<>\"\0", 5);
+}
+
+
+static const char *array_value(const char **array, char key)
+{
+  for (; *array; array+= 2)
+    if (**array == key)
+      return array[1];
+  return 0;
+}
+
+
+static void
+xmlencode_print(const char *src, uint length)
+{
+  if (!src)
+    tee_fputs("NULL", PAGER);
+  else
+  {
+    const char *end= src + length;
+    while (src < end)
+    {
+      const char *p= find_escape_char(&xml_escapes, src, end);
+      tee_write(src, (size_t) (p - src), PAGER);
+      if (p == end)
+        break;
+      tee_fputs(array_value(xmlmeta, *p), PAGER);
+      src= p + 1;
+    }
+  }
+}
+
+
+static const char *tab_escape_str(char c)
+{
+  switch (c) {
+  case '\0': return "\\0";     // This makes everything hard
+  case '\t': return "\\t";     // This would destroy tab format
+  case '\n': return "\\n";     // This too
+  default:   return "\\\\";
+  }
+}
+
+
+static void
+safe_put_field(const char *pos,ulong length)
+{
+  if (!pos)
+    tee_fputs("NULL", PAGER);
+  else if (opt_raw_data)
+  {
+    /* Can't use tee_fputs(), it stops with NUL characters. */
+    tee_write(pos, length, PAGER);
+  }
+  else
+  {
+    const char *end= pos + length;
+#ifdef USE_MB
+    /*
+      Multi-byte characters of charsets like GBK or SJIS may contain '\\'
+      in a trail byte, so those are walked character by character. In
+      UTF-8 and single byte charsets no escaped byte can be part of a
+      longer character and the word at a time scan is used.
+    */
+    if (use_mb(charset_info) &&
+        !(charset_info->mbminlen == 1 && (charset_info->state & MY_CS_UNICODE)))
+    {
+      const char *run= pos;
+      for (; pos < end; pos++)
+      {
+        int l;
+        if ((uchar) *pos >= 0x80 &&
+            (l= my_ismbchar(charset_info, pos, end)))
+        {
+          pos+= l - 1;
+          continue;
+        }
+        if (tab_escapes.member[(uchar) *pos])
+        {
+          tee_write(run, (size_t) (pos - run), PAGER);
+          tee_fputs(tab_escape_str(*pos), PAGER);
+          run= pos + 1;
+        }
+      }
+      tee_write(run, (size_t) (pos - run), PAGER);
+      return;
+    }
+#endif
+    while (pos < end)
+    {
+      const char *p= find_escape_char(&tab_escapes, pos, end);
+      tee_write(pos, (size_t) (p - pos), PAGER);
+      if (p == end)
+        break;
+      tee_fputs(tab_escape_str(*p), PAGER);
+      pos= p + 1;
+    }
+  }
+}
+
+
+static void
+print_tab_data(MYSQL_RES *result)
+{
+  MYSQL_ROW	cur;
+  MYSQL_FIELD	*field;
+  ulong		*lengths;
+
+  if (is_termout_oracle_enable(&mysql)) {
+    if (opt_silent < 2 && column_names)
+    {
+      int first = 0;
+      while ((field = mysql_fetch_field(result)))
+      {
+        if (first++)
+          (void)tee_fputs("\t", PAGER);
+        (void)tee_fputs(field->name, PAGER);
+      }
+      (void)tee_fputs("\n", PAGER);
+    }
+  }
+  
+  while ((cur = fetch_result_row(result, &lengths)))
+  {
+    if (!is_termout_oracle_enable(&mysql))
+      continue;
+
+    field= mysql_fetch_fields(result);
+    if (mysql.oracle_mode && is_binary_field_oracle(&field[0]))
+      print_as_hex_oracle(PAGER, cur[0], lengths[0], lengths[0]);
+    else if (opt_binhex && is_binary_field(&field[0]))
+      print_as_hex(PAGER, cur[0], lengths[0], lengths[0]);
+    else
+      safe_put_field(cur[0],lengths[0]);
+    if (result_cursor && result_cursor->lob_lengths[0])
+      result_cursor_put_lob(result_cursor, 0);
+
+    for (uint off=1 ; off < mysql_num_fields(result); off++)
+    {
+      (void) tee_fputs("\t", PAGER);
+      if (mysql.oracle_mode && field && is_binary_field_oracle(&field[off]))
+        print_as_hex_oracle(PAGER, cur[off], lengths[off], lengths[off]);
+      else if (opt_binhex && field && is_binary_field(&field[off]))
+        print_as_hex(PAGER, cur[off], lengths[off], lengths[off]);
+      else
+        safe_put_field(cur[off], lengths[off]);
+      if (result_cursor && result_cursor->lob_lengths[off])
+        result_cursor_put_lob(result_cursor, off);
+    }
+    (void) tee_fputs("\n", PAGER);
+  }
+}
+
+static int
+com_tee(String *buffer __attribute__((unused)),
+        char *line __attribute__((unused)))
+{
+  char file_name[FN_REFLEN], *end, *param;
+
+  //if (status.batch)
+  //  return 0;
+  while (my_isspace(charset_info,*line))
+    line++;
+  if (!(param = strchr(line, ' '))) // if outfile wasn't given, use the default
+  {
+    if (!strlen(outfile))
+    {
+      printf("No previous outfile available, you must give a filename!\n");
+      return 0;
+    }
+    else if (opt_outfile)
+    {
+      tee_fprintf(stdout, "Currently logging to file '%s'\n", outfile);
+      return 0;
+    }
+    else
+      param = outfile;			//resume using the old outfile
+  }
+
+  /* eliminate the spaces before the parameters */
+  while (my_isspace(charset_info,*param))
+    param++;
+  end= strmake_buf(file_name, param);
+  /* remove end space from command line */
+  while (end > file_name && (my_isspace(charset_info,end[-1]) || 
+			     my_iscntrl(charset_info,end[-1])))
+    end--;
+  end[0]= 0;
+  if (end == file_name)
+  {
+    printf("No outfile specified!\n");
+    return 0;
+  }
+  init_tee(file_name);
+  return 0;
+}
+
+
+static int
+com_notee(String *buffer __attribute__((unused)),
+	  char *line __attribute__((unused)))
+{
+  if (opt_outfile)
+    end_tee();
+  tee_fprintf(stdout, "Outfile disabled.\n");
+  return 0;
+}
+
+/*
+  Sorry, this command is not available in Windows.
+*/
+
+#ifdef USE_POPEN
+static int
+com_pager(String *buffer __attribute__((unused)),
+          char *line __attribute__((unused)))
+{
+  char pager_name[FN_REFLEN], *end, *param;
+
+  if (status.batch)
+    return 0;
+  /* Skip spaces in front of the pager command */
+  while (my_isspace(charset_info, *line))
+    line++;
+  /* Skip the pager command */
+  param= strchr(line, ' ');
+  /* Skip the spaces between the command and the argument */
+  while (param && my_isspace(charset_info, *param))
+    param++;
+  if (!param || !strlen(param)) // if pager was not given, use the default
+  {
+    if (!default_pager_set)
+    {
+      tee_fprintf(stdout, "Default pager wasn't set, using stdout.\n");
+      opt_nopager=1;
+      strmov(pager, "stdout");
+      PAGER= stdout;
+      return 0;
+    }
+    strmov(pager, default_pager);
+  }
+  else
+  {
+    end= strmake_buf(pager_name, param);
+    while (end > pager_name && (my_isspace(charset_info,end[-1]) || 
+                                my_iscntrl(charset_info,end[-1])))
+      end--;
+    end[0]=0;
+    strmov(pager, pager_name);
+    strmov(default_pager, pager_name);
+  }
+  opt_nopager=0;
+  tee_fprintf(stdout, "PAGER set to '%s'\n", pager);
+  return 0;
+}
+
+
+static int
+com_nopager(String *buffer __attribute__((unused)),
+	    char *line __attribute__((unused)))
+{
+  strmov(pager, "stdout");
+  opt_nopager=1;
+  PAGER= stdout;
+  tee_fprintf(stdout, "PAGER set to stdout\n");
+  return 0;
+}
+#endif
+
+
+/*
+  Sorry, you can't send the result to an editor in Win32
+*/
+
+#ifdef USE_POPEN
+static int
+com_edit(String *buffer,char *line __attribute__((unused)))
+{
+  char	filename[FN_REFLEN],buff[160];
+  int	fd,tmp,error;
+  const char *editor;
+  MY_STAT stat_arg;
+
+  if ((fd= create_temp_file(filename,NullS,"sql", 0, MYF(MY_WME))) < 0)
+    goto err;
+  if (buffer->is_empty() && !old_buffer.is_empty())
+    (void) my_write(fd,(uchar*) old_buffer.ptr(),old_buffer.length(),
+		    MYF(MY_WME));
+  else
+    (void) my_write(fd,(uchar*) buffer->ptr(),buffer->length(),MYF(MY_WME));
+  (void) my_close(fd,MYF(0));
+
+  if (!(editor = (char *)getenv("EDITOR")) &&
+      !(editor = (char *)getenv("VISUAL")))
+    editor = "vi";
+  strxmov(buff,editor," ",filename,NullS);
+  if ((error= system(buff)))
+  {
+    char errmsg[100];
+    sprintf(errmsg, "Command '%.40s' failed", buff);
+    put_info(errmsg, INFO_ERROR, 0, NullS);
+    goto err;
+  }
+
+  if (!my_stat(filename,&stat_arg,MYF(MY_WME)))
+    goto err;
+  if ((fd = my_open(filename,O_RDONLY, MYF(MY_WME))) < 0)
+    goto err;
+  (void) buffer->alloc((uint) stat_arg.st_size);
+  if ((tmp=read(fd,(char*) buffer->ptr(),buffer->alloced_length())) >= 0L)
+    buffer->length((uint) tmp);
+  else
+    buffer->length(0);
+  (void) my_close(fd,MYF(0));
+  (void) my_delete(filename,MYF(MY_WME));
+err:
+  return 0;
+}
+#endif
+
+
+/* If arg is given, exit without errors. This happens on command 'quit' */
+
+static int
+com_quit(String *buffer __attribute__((unused)),
+	 char *line __attribute__((unused)))
+{
+  status.exit_status=0;
+  return 1;
+}
+
+static int
+com_rehash(String *buffer __attribute__((unused)),
+	 char *line __attribute__((unused)))
+{
+#ifdef HAVE_READLINE
+  build_completion_hash(1, 0, 0);
+#endif
+  return 0;
+}
+
+
+#ifdef USE_POPEN
+static int
+com_shell(String *buffer __attribute__((unused)),
+          char *line __attribute__((unused)))
+{
+  char *shell_cmd;
+
+  /* Skip space from line begin */
+  while (my_isspace(charset_info, *line))
+    line++;
+  if (!(shell_cmd = strchr(line, ' ')))
+  {
+    put_info("Usage: \\! shell-command", INFO_ERROR);
+    return -1;
+  }
+  /*
+    The output of the shell command does not
+    get directed to the pager or the outfile
+  */
+  if (system(shell_cmd) == -1)
+  {
+    put_info(strerror(errno), INFO_ERROR, errno);
+    return -1;
+  }
+  return 0;
+}
+#endif
+
+
+static int
+com_print(String *buffer,char *line __attribute__((unused)))
+{
+  tee_puts("--------------", stdout);
+  (void) tee_fputs(buffer->c_ptr(), stdout);
+  if (!buffer->length() || (*buffer)[buffer->length()-1] != '\n')
+    tee_putc('\n', stdout);
+  tee_puts("--------------\n", stdout);
+  return 0;					/* If empty buffer */
+}
+
+static std::string get_password() {
+  std::string password;
+  char ch;
+
+#ifndef _WIN32
+  while ((ch = sh_getch()) != '\r') {
+#else
+  while ((ch = getch()) != '\r') {
+#endif
+    if (ch == '\b') {
+      if (!password.empty()) {
+        password.pop_back();
+      }
+    } else {
+      password += ch;
+    }
+  }
+  tee_fprintf(stdout, "\n");
+  return password;
+}
+
+	/* ARGSUSED */
+static int
+com_connect(String *buffer, char *line)
+{
+  char *tmp, buff[256] = {0};
+  my_bool save_rehash= opt_rehash;
+  int error;
+  int rewrite = 0;
+  char *newuser = NULL, *newtenant = NULL, *oldtenant = NULL;
+  std::string passwd;
+  std::string saveuser = current_user;
+  std::string savehost = current_host_success;
+  int saveport = current_port_success;
+
+  //To relink, need to reinitialize this global variable
+  dbms_serveroutput = 0;
+  dbms_prepared = 0;
+  if (dbms_stmt) {
+    mysql_stmt_close(dbms_stmt);
+    dbms_stmt = NULL;
+  }
+  dbms_lines_unsupported = 0;
+  dbms_lines_checked = 0;
+  if (dbms_lines_stmt) {
+    mysql_stmt_close(dbms_lines_stmt);
+    dbms_lines_stmt = NULL;
+  }
+
+  if (current_user) {
+    split_fullname(current_user, NULL, &oldtenant);
+  }
+
+  bzero(buff, sizeof(buff));
+  if (buffer)
+  {
+    /*
+      Two null bytes are needed in the end of buff to allow
+      get_arg to find end of string the second time it's called.
+    */
+    String tmpbuf;
+    tmpbuf.append(line);
+    if (last_session_mode && is_define_oracle) {
+      scan_define_oracle(&tmpbuf, 0);
+    }
+
+    tmp= strmake(buff, tmpbuf.c_ptr(), sizeof(buff)-2);
+#ifdef EXTRA_DEBUG
+    tmp[1]= 0;
+#endif
+
+    rewrite = rewrite_by_oracle(buff);
+    if (-1 == rewrite) {
+      // invalid connect string...
+      tee_fprintf(stdout, "Connect string is invalid...\n");
+      if (oldtenant)
+        my_free(oldtenant);
+      oldtenant = NULL;
+      return 0;
+    } else if (1 == rewrite) {
+      // connect username@tenant[/password[@[//]host[:port]]]
+      // connect username[/password[@[//]host[:port]]]
+      int i = 1;
+      tmp = get_arg_string(buff, GET);
+      if (tmp && *tmp) {
+        my_free(current_user);
+        current_user = my_strdup(tmp, MYF(MY_WME));
+        tmp = get_arg_by_index(buff, i++);
+        if (tmp && *tmp) {
+          int ilen = strlen(tmp);
+          char szbuf[128] = { 0 };
+          memset(szbuf, 0, sizeof(szbuf));
+          if (*tmp == '\"' && *(tmp + ilen-1) == '\"' && ilen > 2) {
+            memcpy(szbuf, tmp + 1, ilen - 2);
+          } else {
+            memcpy(szbuf, tmp, ilen);
+          }
+          my_free(opt_password);
+          opt_password = my_strdup(szbuf, MYF(MY_WME));
+          tmp = get_arg_by_index(buff, i++);
+          if (tmp && *tmp) {
+            my_free(current_host);
+            current_host = my_strdup(tmp, MYF(MY_WME));
+            my_free(current_host_success);
+            current_host_success = my_strdup(tmp, MYF(MY_WME));
+
+            tmp = get_arg_by_index(buff, i++);
+            if (tmp && *tmp) {
+              errno = 0;
+              char *endchar;
+              ulonglong port;
+              port = strtoull(tmp, &endchar, 10);
+              if (errno == ERANGE) {
+                my_getopt_error_reporter(ERROR_LEVEL, "Incorrect unsigned integer value: '%s'", tmp);
+                if (oldtenant)
+                  my_free(oldtenant);
+                oldtenant = NULL;
+                return 1;
+              } else {
+                opt_mysql_port = (uint)port;
+                current_port_success = (int)port;
+              }
+            }
+          }
+        } else {
+          tee_fprintf(stdout, "Enter password:");
+          passwd = get_password();
+          my_free(opt_password);
+          opt_password = my_strdup(passwd.c_str(), MYF(MY_WME));
+        }
+        split_fullname(current_user, &newuser, &newtenant);
+        if (newuser && !newtenant && oldtenant) {
+          snprintf(buff, sizeof(buff), "%s%s", newuser, oldtenant);
+          my_free(current_user);
+          current_user = my_strdup(buff, MYF(MY_WME));
+        }
+      } else {
+        /* Quick re-connect */
+        opt_rehash = 0;                            /* purecov: tested */
+      }
+    } else {
+      // connect db host
+      if (last_session_mode) {
+        //oracle mode
+        tmp = get_arg_string(buff, GET);
+        if (tmp && *tmp) {
+          my_free(current_user);
+          current_user = my_strdup(tmp, MYF(MY_WME));
+          split_fullname(current_user, &newuser, &newtenant);
+          if (newuser && !newtenant && oldtenant) {
+            snprintf(buff, sizeof(buff), "%s%s", newuser, oldtenant);
+            my_free(current_user);
+            current_user = my_strdup(buff, MYF(MY_WME));
+          }
+          
+          tee_fprintf(stdout, "Enter password:");
+          passwd = get_password();
+          my_free(opt_password);
+          opt_password = my_strdup(passwd.c_str(), MYF(MY_WME));
+        } else {
+          opt_rehash = 0;                            /* purecov: tested */
+        }
+      } else {
+        tmp = get_arg_string(buff, GET);
+        if (tmp && *tmp) {
+          my_free(current_db);
+          current_db = my_strdup(tmp, MYF(MY_WME));
+          tmp = get_arg_string(buff, GET_NEXT);
+          if (tmp && *tmp) {
+            my_free(current_host);
+            current_host = my_strdup(tmp, MYF(MY_WME));
+            my_free(current_host_success);
+            current_host_success = my_strdup(tmp, MYF(MY_WME));
+          }
+        } else {
+          /* Quick re-connect */
+          opt_rehash = 0;                            /* purecov: tested */
+        }
+      }
+    }
+    buffer->length(0);				// command used
+    opt_mysql_port = current_port_success;
+    error = sql_connect(current_host_success, NULL, current_user, opt_password, 100);
+    if (connected && !mysql.oracle_mode) {
+      sprintf(buff, "use %s", current_db);
+      if (mysql_query(&mysql, buff)) {
+        put_error(&mysql);
+      }
+    }
+    if (!connected) {
+      my_free(current_user);
+      my_free(current_host_success);
+      current_user = my_strdup(saveuser.c_str(), MYF(MY_WME));
+      current_host_success = my_strdup(savehost.c_str(), MYF(MY_WME));
+      current_port_success = opt_mysql_port = saveport;
+    }
+  } else {
+    opt_rehash= 0;
+    error= 0;
+    /*
+      Go back to the server the standby is on rather than to the host
+      list: sql_real_connect() takes the standby as the new session
+    */
+    if (standby_alive())
+    {
+      uint save_port= opt_mysql_port;
+      opt_mysql_port= current_port_success;
+      error= sql_real_connect(current_host_success, current_db, current_user,
+                              opt_password, 1);
+      opt_mysql_port= save_port;
+    }
+    if (!connected)
+      error = sql_connect(current_host, current_db, current_user, opt_password, 0);
+  }
+
+  if (oldtenant)
+    my_free(oldtenant);
+  if (newuser)
+    my_free(newuser);
+  if (newtenant)
+    my_free(newtenant);
+  oldtenant = NULL;
+  newuser = NULL;
+  newtenant = NULL;
+
+  opt_rehash= save_rehash;
+  if (connected)
+  {
+    full_username = 0;
+    part_username = 0;
+
+    get_current_db();
+
+    sprintf(buff,"Connection id:    %lu",mysql_thread_id(&mysql));
+    put_info(buff,INFO_INFO);
+    sprintf(buff,"Current database: %.128s\n", current_db ? current_db : "*** NONE ***");
+    put_info(buff,INFO_INFO);
+
+    //relink success
+    start_login_sql(&mysql, &glob_buffer, get_login_sql_path());
+  }
+  return error;
+}
+
+/*
+  Parallel execution of scripts (--parallel and psource).
+
+  Statements are dealt to worker connections by the table they change, so
+  the statements on one table keep their order on one connection. Session
+  statements like SET and USE run on every connection. Any other
+  statement, and everything inside a transaction, waits until the workers
+  are idle and runs on the main connection. While a connection holds
+  LOCK TABLES, everything up to UNLOCK TABLES goes to that connection.
+
+  Temporary tables, and the rows of global temporary tables, exist only
+  in the session that made them, so they are created on the main
+  connection and the names are remembered: the statements on them stay
+  there too. So do the statements on a table the script gives a foreign
+  key, which the main connection runs only once the workers are done
+  with the tables it refers to. Only the hash of a name is kept, so
+  another table with the same hash runs on the main connection as well,
+  which is just slower.
+*/
+
+#define PARALLEL_QUEUE_SIZE (16L*1024*1024)   /* Bytes queued per worker */
+
+enum enum_parallel_class
+{
+  PARALLEL_MAIN,                /* Wait for the workers, run on main */
+  PARALLEL_TABLE,               /* Run on the worker of the table */
+  PARALLEL_SESSION,             /* Run on all connections */
+  PARALLEL_BEGIN,               /* Start a transaction on main */
+  PARALLEL_END,                 /* COMMIT or ROLLBACK */
+  PARALLEL_LOCK,                /* LOCK TABLES on the worker of the table */
+  PARALLEL_UNLOCK,
+  PARALLEL_MAIN_TABLE           /* Run on main, and keep the table there */
+};
+
+typedef struct st_parallel_stmt
+{
+  struct st_parallel_stmt *next;
+  char *query;
+  size_t length;
+  ulong line;                   /* Line the statement started on */
+  char *file_name;              /* Script it was read from, or NULL */
+  bool select_db;               /* query is a database name to USE */
+  bool quiet;                   /* The main connection reports errors */
+  bool abort_on_error;
+  uint error;
+  char sqlstate[SQLSTATE_LENGTH + 1];
+  char message[MYSQL_ERRMSG_SIZE];
+} PARALLEL_STMT;
+
+typedef struct st_parallel_worker
+{
+  MYSQL mysql;
+  pthread_t thread;
+  PARALLEL_STMT *first, **last;
+  size_t queued;                /* Bytes of queries in the queue */
+  bool busy;                    /* Running a statement taken off the queue */
+} PARALLEL_WORKER;
+
+static PARALLEL_WORKER *parallel_workers= NULL;
+static uint parallel_count;
+static PARALLEL_STMT *parallel_errors, **parallel_errors_last;
+static bool parallel_stop, parallel_failed, parallel_in_transaction;
+static int parallel_lock_worker;        /* Worker in LOCK TABLES, or -1 */
+static DYNAMIC_ARRAY parallel_main_tables; /* Hashes of tables on main */
+static pthread_mutex_t parallel_mutex;
+static pthread_cond_t parallel_work, parallel_idle;
+
+
+static void parallel_run(MYSQL *con, PARALLEL_STMT *stmt)
+{
+  int next;
+
+  if (stmt->select_db ? mysql_select_db(con, stmt->query) :
+      mysql_real_query(con, stmt->query, (ulong) stmt->length))
+    goto err;
+  if (stmt->select_db)
+    return;
+  do
+  {
+    MYSQL_RES *result;
+    if ((result= mysql_store_result(con)))
+      mysql_free_result(result);
+    else if (mysql_field_count(con))
+      goto err;
+  } while (!(next= mysql_next_result(con)));
+  if (next < 0)
+    return;
+
+err:
+  stmt->error= mysql_errno(con);
+  strmake(stmt->sqlstate, mysql_sqlstate(con), SQLSTATE_LENGTH);
+  strmake(stmt->message, mysql_error(con), sizeof(stmt->message) - 1);
+}
+
+
+pthread_handler_t parallel_worker(void *arg)
+{
+  PARALLEL_WORKER *w= (PARALLEL_WORKER*) arg;
+
+  mysql_thread_init();
+  pthread_mutex_lock(&parallel_mutex);
+  for (;;)
+  {
+    PARALLEL_STMT *stmt;
+    bool skip;
+
+    while (!w->first && !parallel_stop)
+      pthread_cond_wait(&parallel_work, &parallel_mutex);
+    if (!(stmt= w->first))
+      break;
+    if (!(w->first= stmt->next))
+      w->last= &w->first;
+    w->busy= 1;
+    skip= parallel_failed;
+    pthread_mutex_unlock(&parallel_mutex);
+
+    if (!skip)
+      parallel_run(&w->mysql, stmt);
+
+    pthread_mutex_lock(&parallel_mutex);
+    w->queued-= stmt->length;
+    w->busy= 0;
+    if (stmt->error && !stmt->quiet)
+    {
+      if (stmt->abort_on_error)
+        parallel_failed= 1;
+      stmt->next= NULL;
+      *parallel_errors_last= stmt;
+      parallel_errors_last= &stmt->next;
+    }
+    else
+      my_free(stmt);
+    pthread_cond_broadcast(&parallel_idle);
+  }
+  pthread_mutex_unlock(&parallel_mutex);
+
+  /* Do what mysql_end() does for the main connection */
+  if (is_exitcommit_oracle && w->mysql.oracle_mode && !parallel_failed)
+    mysql_commit(&w->mysql);
+  mysql_thread_end();
+  return 0;
+}
+
+
+/**
+  Report the errors of the statements run by the workers, with the lines
+  they were read from.
+
+  @return the most severe put_info() result
+*/
+
+static int parallel_report()
+{
+  PARALLEL_STMT *stmt, *next;
+  ulong save_line= status.query_start_line;
+  char *save_file_name= status.file_name;
+  int error= 0;
+
+  pthread_mutex_lock(&parallel_mutex);
+  stmt= parallel_errors;
+  parallel_errors= NULL;
+  parallel_errors_last= &parallel_errors;
+  pthread_mutex_unlock(&parallel_mutex);
+
+  for (; stmt; stmt= next)
+  {
+    int res;
+    next= stmt->next;
+    status.query_start_line= stmt->line;
+    status.file_name= stmt->file_name;
+    res= put_info(stmt->message, INFO_ERROR, stmt->error, stmt->sqlstate,
+                  mysql.oracle_mode);
+    set_if_bigger(error, res);
+    my_free(stmt);
+  }
+  status.query_start_line= save_line;
+  status.file_name= save_file_name;
+  return error;
+}
+
+
+/**
+  Add a statement to the queue of a worker, waiting for room in the queue
+  if it is full.
+*/
+
+static int parallel_queue(uint worker, const char *query, size_t length,
+                          bool select_db, bool quiet)
+{
+  PARALLEL_WORKER *w= &parallel_workers[worker];
+  size_t file_name_length= status.file_name ? strlen(status.file_name) + 1 : 0;
+  PARALLEL_STMT *stmt;
+
+  if (!(stmt= (PARALLEL_STMT*) my_malloc(sizeof(*stmt) + length + 1 +
+                                         file_name_length, MYF(MY_WME))))
+    return put_info("Out of memory", INFO_ERROR);
+  bzero((char*) stmt, sizeof(*stmt));
+  stmt->query= (char*) (stmt + 1);
+  memcpy(stmt->query, query, length);
+  stmt->query[length]= 0;
+  stmt->length= length;
+  stmt->line= status.query_start_line;
+  if (file_name_length)
+    stmt->file_name= (char*) memcpy(stmt->query + length + 1,
+                                    status.file_name, file_name_length);
+  stmt->select_db= select_db;
+  stmt->quiet= quiet;
+  stmt->abort_on_error= !ignore_errors;
+
+  pthread_mutex_lock(&parallel_mutex);
+  while (w->queued && w->queued + length > PARALLEL_QUEUE_SIZE &&
+         !parallel_failed)
+    pthread_cond_wait(&parallel_idle, &parallel_mutex);
+  *w->last= stmt;
+  w->last= &stmt->next;
+  w->queued+= length;
+  pthread_cond_broadcast(&parallel_work);
+  pthread_mutex_unlock(&parallel_mutex);
+  return 0;
+}
+
+
+static int parallel_queue_all(const char *query, size_t length,
+                              bool select_db)
+{
+  for (uint i= 0; i < parallel_count; i++)
+  {
+    if (parallel_queue(i, query, length, select_db, 1))
+      return 1;
+  }
+  return 0;
+}
+
+
+static void parallel_wait_idle()
+{
+  pthread_mutex_lock(&parallel_mutex);
+  for (uint i= 0; i < parallel_count; i++)
+  {
+    while (parallel_workers[i].first || parallel_workers[i].busy)
+      pthread_cond_wait(&parallel_idle, &parallel_mutex);
+  }
+  pthread_mutex_unlock(&parallel_mutex);
+}
+
+
+/*
+  Skip white space and comments, and the markers of executable comments
+  like the ones mysqldump writes around SET statements.
+*/
+
+static const char *parallel_skip(const char *pos, const char *end)
+{
+  while (pos < end)
+  {
+    if (my_isspace(charset_info, *pos))
+      pos++;
+    else if (pos + 1 < end && pos[0] == '/' && pos[1] == '*')
+    {
+      if (pos + 2 < end && (pos[2] == '!' || pos[2] == 'M'))
+      {
+        /* Executable comment, skip the marker and the version */
+        pos+= pos[2] == 'M' && pos + 3 < end && pos[3] == '!' ? 4 : 3;
+        while (pos < end && my_isdigit(charset_info, *pos))
+          pos++;
+        continue;
+      }
+      for (pos+= 2; pos + 1 < end && !(pos[0] == '*' && pos[1] == '/'); pos++)
+        ;
+      pos+= 2;
+    }
+    else if (pos + 1 < end && pos[0] == '*' && pos[1] == '/')
+      pos+= 2;                                  // End of executable comment
+    else if ((pos + 1 < end && pos[0] == '-' && pos[1] == '-') ||
+             (*pos == '#' && !last_session_mode))
+    {
+      while (pos < end && *pos != '\n')
+        pos++;
+    }
+    else
+      break;
+  }
+  return MY_MIN(pos, end);
+}
+
+
+static bool parallel_is_ident_char(char c)
+{
+  return my_isalnum(charset_info, c) || c == '_' || c == '$' || c == '#' ||
+         (uchar) c >= 0x80;
+}
+
+
+/**
+  Read the word at *pos, skipping it and the space after it.
+
+  @return length of the word, 0 if there is none
+*/
+
+static size_t parallel_word(const char **pos, const char *end,
+                            const char **word)
+{
+  const char *p= *pos;
+
+  *word= p;
+  while (p < end && parallel_is_ident_char(*p))
+    p++;
+  if (p == *word)
+    return 0;
+  *pos= parallel_skip(p, end);
+  return (size_t) (p - *word);
+}
+
+
+/**
+  Check if the next word is name, and skip it if it is.
+*/
+
+static bool parallel_next_is(const char **pos, const char *end,
+                             const char *name)
+{
+  const char *p= *pos, *word;
+  size_t length= parallel_word(&p, end, &word);
+
+  if (length != strlen(name) || strncasecmp(word, name, length))
+    return 0;
+  *pos= p;
+  return 1;
+}
+
+
+/**
+  Read a table name, which may be quoted and qualified with a database
+  name, and hash the name of the table. The database name is left out of
+  the hash, as the statements may name the table with and without it.
+
+  @return 0 if there is no table name at *pos
+*/
+
+static bool parallel_table(const char **pos, const char *end, uint *hash)
+{
+  const char *p= *pos;
+
+  for (;;)
+  {
+    *hash= 0;
+    if (p < end && (*p == '`' || *p == '"'))
+    {
+      char quote= *p++;
+      for (; p < end; p++)
+      {
+        if (*p == quote && (++p == end || *p != quote))
+          break;
+        *hash= *hash * 31 + my_toupper(&my_charset_latin1, (uchar) *p);
+      }
+    }
+    else
+    {
+      const char *start= p;
+      for (; p < end && parallel_is_ident_char(*p); p++)
+        *hash= *hash * 31 + my_toupper(&my_charset_latin1, (uchar) *p);
+      if (p == start)
+        return 0;
+    }
+    if (p >= end || *p != '.')
+      break;
+    p++;
+  }
+  *pos= parallel_skip(p, end);
+  return 1;
+}
+
+
+/**
+  Check if the rest of a statement has one of the words, outside of quoted
+  strings and identifiers.
+*/
+
+static bool parallel_has_word(const char *pos, const char *end,
+                              const char **words)
+{
+  while (pos < end)
+  {
+    if (*pos == '\'' || *pos == '"' || *pos == '`')
+    {
+      char quote= *pos++;
+      for (; pos < end && *pos != quote; pos++)
+      {
+        if (*pos == '\\' && quote != '`' && !last_session_mode)
+          pos++;
+      }
+      pos++;
+    }
+    else if (parallel_is_ident_char(*pos))
+    {
+      const char *word= pos;
+      while (pos < end && parallel_is_ident_char(*pos))
+        pos++;
+      for (const char **name= words; *name; name++)
+      {
+        if ((size_t) (pos - word) == strlen(*name) &&
+            !strncasecmp(word, *name, pos - word))
+          return 1;
+      }
+    }
+    else
+      pos++;
+  }
+  return 0;
+}
+
+
+/**
+  Find out where a statement may run, and which table it changes.
+
+  Only the head of the statement is looked at, except for DDL, INSERT,
+  UPDATE and DELETE, which are checked for references to other tables.
+*/
+
+static enum_parallel_class parallel_classify(const char *query, size_t length,
+                                             uint *hash)
+{
+  /* Words that bring other tables into a statement */
+  static const char *ddl_other_tables[]=
+  {"SELECT", "REFERENCES", "LIKE", "RENAME", "EXCHANGE", NullS};
+  static const char *dml_other_tables[]= {"SELECT", NullS};
+  static const char *foreign_key[]= {"REFERENCES", NullS};
+  const char *end= query + length, *pos= parallel_skip(query, end);
+  const char *word;
+  size_t word_length= parallel_word(&pos, end, &word);
+  char first[16];
+
+  if (!word_length || word_length >= sizeof(first))
+    return PARALLEL_MAIN;
+  strmake(first, word, word_length);
+
+  if (!my_strcasecmp(&my_charset_latin1, first, "SET"))
+    return parallel_next_is(&pos, end, "TRANSACTION") ? PARALLEL_MAIN :
+           PARALLEL_SESSION;
+  if (!my_strcasecmp(&my_charset_latin1, first, "USE"))
+    return PARALLEL_SESSION;
+  if (!my_strcasecmp(&my_charset_latin1, first, "ALTER"))
+  {
+    if (parallel_next_is(&pos, end, "SESSION"))
+      return PARALLEL_SESSION;
+    parallel_next_is(&pos, end, "IGNORE");
+    if (!parallel_next_is(&pos, end, "TABLE") ||
+        !parallel_table(&pos, end, hash))
+      return PARALLEL_MAIN;
+    if (parallel_has_word(pos, end, foreign_key))
+      return PARALLEL_MAIN_TABLE;
+    return parallel_has_word(pos, end, ddl_other_tables) ? PARALLEL_MAIN :
+           PARALLEL_TABLE;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "CREATE"))
+  {
+    if (parallel_next_is(&pos, end, "OR"))
+      parallel_next_is(&pos, end, "REPLACE");
+    if (parallel_next_is(&pos, end, "UNIQUE") ||
+        parallel_next_is(&pos, end, "FULLTEXT") ||
+        parallel_next_is(&pos, end, "SPATIAL") ||
+        parallel_next_is(&pos, end, "BITMAP"))
+    {
+      if (!parallel_next_is(&pos, end, "INDEX"))
+        return PARALLEL_MAIN;
+    }
+    else if (!parallel_next_is(&pos, end, "INDEX"))
+    {
+      bool temporary;
+      parallel_next_is(&pos, end, "GLOBAL");
+      temporary= parallel_next_is(&pos, end, "TEMPORARY");
+      if (!parallel_next_is(&pos, end, "TABLE"))
+        return PARALLEL_MAIN;
+      if (parallel_next_is(&pos, end, "IF"))
+      {
+        parallel_next_is(&pos, end, "NOT");
+        parallel_next_is(&pos, end, "EXISTS");
+      }
+      if (!parallel_table(&pos, end, hash))
+        return PARALLEL_MAIN;
+      if (temporary || parallel_has_word(pos, end, foreign_key))
+        return PARALLEL_MAIN_TABLE;
+      return parallel_has_word(pos, end, ddl_other_tables) ? PARALLEL_MAIN :
+             PARALLEL_TABLE;
+    }
+    /* CREATE INDEX name [USING type] ON table */
+    if (!parallel_table(&pos, end, hash))
+      return PARALLEL_MAIN;
+    if (parallel_next_is(&pos, end, "USING"))
+      parallel_word(&pos, end, &word);
+    if (parallel_next_is(&pos, end, "ON") && parallel_table(&pos, end, hash))
+      return PARALLEL_TABLE;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "DROP"))
+  {
+    if (parallel_next_is(&pos, end, "TEMPORARY"))
+      return PARALLEL_MAIN;
+    if (parallel_next_is(&pos, end, "TABLE"))
+    {
+      if (parallel_next_is(&pos, end, "IF"))
+        parallel_next_is(&pos, end, "EXISTS");
+      if (!parallel_table(&pos, end, hash) || (pos < end && *pos == ','))
+        return PARALLEL_MAIN;
+      return PARALLEL_TABLE;
+    }
+    if (parallel_next_is(&pos, end, "INDEX") &&
+        parallel_table(&pos, end, hash) &&
+        parallel_next_is(&pos, end, "ON") && parallel_table(&pos, end, hash))
+      return PARALLEL_TABLE;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "TRUNCATE"))
+  {
+    parallel_next_is(&pos, end, "TABLE");
+    return parallel_table(&pos, end, hash) ? PARALLEL_TABLE : PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "INSERT") ||
+      !my_strcasecmp(&my_charset_latin1, first, "REPLACE"))
+  {
+    while (parallel_next_is(&pos, end, "LOW_PRIORITY") ||
+           parallel_next_is(&pos, end, "DELAYED") ||
+           parallel_next_is(&pos, end, "HIGH_PRIORITY") ||
+           parallel_next_is(&pos, end, "IGNORE"))
+      ;
+    parallel_next_is(&pos, end, "INTO");
+    if (!parallel_table(&pos, end, hash))
+      return PARALLEL_MAIN;
+    if (parallel_next_is(&pos, end, "PARTITION"))
+    {
+      const char *p= (const char*) memchr(pos, ')', end - pos);
+      if (!p)
+        return PARALLEL_MAIN;
+      pos= parallel_skip(p + 1, end);
+    }
+    if (pos < end && *pos == '(')
+    {
+      /* Column list, unless it is a query */
+      const char *p= parallel_skip(pos + 1, end);
+      if (parallel_next_is(&p, end, "SELECT") ||
+          parallel_next_is(&p, end, "WITH") ||
+          !(p= (const char*) memchr(pos, ')', end - pos)))
+        return PARALLEL_MAIN;
+      pos= parallel_skip(p + 1, end);
+    }
+    if (parallel_next_is(&pos, end, "VALUES") ||
+        parallel_next_is(&pos, end, "VALUE") ||
+        parallel_next_is(&pos, end, "SET"))
+      return parallel_has_word(pos, end, dml_other_tables) ? PARALLEL_MAIN :
+             PARALLEL_TABLE;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "UPDATE"))
+  {
+    parallel_next_is(&pos, end, "LOW_PRIORITY");
+    parallel_next_is(&pos, end, "IGNORE");
+    if (!parallel_table(&pos, end, hash))
+      return PARALLEL_MAIN;
+    if (!parallel_next_is(&pos, end, "SET"))
+    {
+      /* An alias, a join or a list of tables */
+      if (!parallel_word(&pos, end, &word) ||
+          !parallel_next_is(&pos, end, "SET"))
+        return PARALLEL_MAIN;
+    }
+    return parallel_has_word(pos, end, dml_other_tables) ? PARALLEL_MAIN :
+           PARALLEL_TABLE;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "DELETE"))
+  {
+    while (parallel_next_is(&pos, end, "LOW_PRIORITY") ||
+           parallel_next_is(&pos, end, "QUICK") ||
+           parallel_next_is(&pos, end, "IGNORE"))
+      ;
+    if (!parallel_next_is(&pos, end, "FROM") ||
+        !parallel_table(&pos, end, hash))
+      return PARALLEL_MAIN;
+    if (pos < end && !parallel_next_is(&pos, end, "WHERE") &&
+        !parallel_next_is(&pos, end, "ORDER") &&
+        !parallel_next_is(&pos, end, "LIMIT"))
+      return PARALLEL_MAIN;
+    return parallel_has_word(pos, end, dml_other_tables) ? PARALLEL_MAIN :
+           PARALLEL_TABLE;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "LOAD"))
+  {
+    char quote;
+    if (!parallel_next_is(&pos, end, "DATA"))
+      return PARALLEL_MAIN;
+    parallel_next_is(&pos, end, "LOW_PRIORITY");
+    parallel_next_is(&pos, end, "CONCURRENT");
+    parallel_next_is(&pos, end, "LOCAL");
+    if (!parallel_next_is(&pos, end, "INFILE") || pos == end ||
+        (*pos != '\'' && *pos != '"'))
+      return PARALLEL_MAIN;
+    for (quote= *pos++; pos < end && *pos != quote; pos++)
+    {
+      if (*pos == '\\')
+        pos++;
+    }
+    pos= parallel_skip(pos + 1, end);
+    parallel_next_is(&pos, end, "REPLACE");
+    parallel_next_is(&pos, end, "IGNORE");
+    if (parallel_next_is(&pos, end, "INTO") &&
+        parallel_next_is(&pos, end, "TABLE") &&
+        parallel_table(&pos, end, hash))
+      return PARALLEL_TABLE;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "LOCK") && !last_session_mode)
+  {
+    if ((parallel_next_is(&pos, end, "TABLES") ||
+         parallel_next_is(&pos, end, "TABLE")) &&
+        parallel_table(&pos, end, hash))
+      return PARALLEL_LOCK;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "UNLOCK"))
+    return PARALLEL_UNLOCK;
+  if (!my_strcasecmp(&my_charset_latin1, first, "BEGIN"))
+  {
+    /* In Oracle mode, and with anything else after it, it is a block */
+    parallel_next_is(&pos, end, "WORK");
+    return pos == end && !last_session_mode ? PARALLEL_BEGIN : PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "START"))
+    return parallel_next_is(&pos, end, "TRANSACTION") ? PARALLEL_BEGIN :
+           PARALLEL_MAIN;
+  if (!my_strcasecmp(&my_charset_latin1, first, "XA"))
+  {
+    if (parallel_next_is(&pos, end, "START") ||
+        parallel_next_is(&pos, end, "BEGIN"))
+      return PARALLEL_BEGIN;
+    if (parallel_next_is(&pos, end, "COMMIT") ||
+        parallel_next_is(&pos, end, "ROLLBACK"))
+      return PARALLEL_END;
+    return PARALLEL_MAIN;
+  }
+  if (!my_strcasecmp(&my_charset_latin1, first, "COMMIT") ||
+      !my_strcasecmp(&my_charset_latin1, first, "ROLLBACK"))
+    return PARALLEL_END;
+  return PARALLEL_MAIN;
+}
+
+
+static bool parallel_is_main_table(uint hash)
+{
+  for (uint i= 0; i < parallel_main_tables.elements; i++)
+    if (*dynamic_element(&parallel_main_tables, i, uint*) == hash)
+      return 1;
+  return 0;
+}
+
+
+/**
+  Hand a statement that com_go() is about to run over to the workers, if
+  it may run there.
+
+  @param buffer  the statement
+  @param error   set to the result of reporting the errors of the workers
+
+  @retval 1  the statement was queued or must not run, return *error
+  @retval 0  run the statement on the main connection, as always when
+             there are no workers
+*/
+
+static bool parallel_dispatch(String *buffer, int *error)
+{
+  uint hash= 0;
+  enum_parallel_class type;
+  bool queued= 1;
+  int report;
+
+  *error= 0;
+  if (!parallel_workers)
+    return 0;
+  type= parallel_classify(buffer->ptr(), buffer->length(), &hash);
+  if (type == PARALLEL_MAIN_TABLE)
+  {
+    if (!parallel_is_main_table(hash))
+      (void) insert_dynamic(&parallel_main_tables, (uchar*) &hash);
+  }
+  else if ((type == PARALLEL_TABLE || type == PARALLEL_LOCK) &&
+           parallel_is_main_table(hash))
+    type= PARALLEL_MAIN_TABLE;
+  if (parallel_in_transaction)
+  {
+    if (type == PARALLEL_END)
+      parallel_in_transaction= 0;
+    queued= 0;
+  }
+  else if (parallel_lock_worker >= 0 && type != PARALLEL_SESSION &&
+           type != PARALLEL_MAIN_TABLE)
+  {
+    *error= parallel_queue(parallel_lock_worker, buffer->ptr(),
+                           buffer->length(), 0, 0);
+    if (type == PARALLEL_UNLOCK)
+      parallel_lock_worker= -1;
+  }
+  else
+  {
+    switch (type) {
+    case PARALLEL_TABLE:
+      *error= parallel_queue(hash % parallel_count, buffer->ptr(),
+                             buffer->length(), 0, 0);
+      break;
+    case PARALLEL_LOCK:
+      parallel_lock_worker= hash % parallel_count;
+      *error= parallel_queue(parallel_lock_worker, buffer->ptr(),
+                             buffer->length(), 0, 0);
+      break;
+    case PARALLEL_SESSION:
+    case PARALLEL_END:
+      /* Outside of a transaction, COMMIT ends the work of every session */
+      *error= parallel_queue_all(buffer->ptr(), buffer->length(), 0);
+      queued= 0;
+      break;
+    case PARALLEL_BEGIN:
+      parallel_in_transaction= 1;
+      /* fall through */
+    default:
+      parallel_wait_idle();
+      queued= 0;
+      break;
+    }
+  }
+  report= parallel_report();
+  set_if_bigger(*error, report);
+  return queued || *error > 0;
+}
+
+
+/**
+  Make the workers use the database that the use command selected on the
+  main connection.
+*/
+
+static void parallel_select_db(const char *db)
+{
+  if (parallel_workers)
+    parallel_queue_all(db, strlen(db), 1);
+}
+
+
+static int parallel_connect(MYSQL *con)
+{
+  String socket5_proxy;
+  int error= 0;
+
+  mysql_init(con);
+  set_connect_options(con, socket5_proxy);
+  if (!do_connect(con, current_host_success, current_port_success,
+                  current_user, opt_password, current_db,
+                  connect_flag | CLIENT_MULTI_STATEMENTS))
+  {
+    error= put_error(con);
+    mysql_close(con);
+  }
+  return error;
+}
+
+
+/**
+  Open the connections and start the workers.
+
+  @return 0 on success, else the result of reporting the error. Nothing
+          is started then, and the statements run on the main connection.
+*/
+
+static int parallel_begin(uint connections)
+{
+  uint i;
+  int error= 0;
+
+  if (!connected && reconnect())
+    return opt_reconnect ? -1 : 1;
+  if (!(parallel_workers= (PARALLEL_WORKER*)
+        my_malloc(sizeof(PARALLEL_WORKER) * connections,
+                  MYF(MY_WME | MY_ZEROFILL))))
+    return put_info("Out of memory", INFO_ERROR);
+  pthread_mutex_init(&parallel_mutex, NULL);
+  pthread_cond_init(&parallel_work, NULL);
+  pthread_cond_init(&parallel_idle, NULL);
+  parallel_errors= NULL;
+  parallel_errors_last= &parallel_errors;
+  parallel_stop= parallel_failed= parallel_in_transaction= 0;
+  parallel_lock_worker= -1;
+  my_init_dynamic_array(&parallel_main_tables, sizeof(uint), 16, 16, MYF(0));
+
+  for (i= 0; i < connections; i++)
+  {
+    PARALLEL_WORKER *w= &parallel_workers[i];
+    w->last= &w->first;
+    if ((error= parallel_connect(&w->mysql)))
+      break;
+    if (pthread_create(&w->thread, NULL, parallel_worker, (void*) w))
+    {
+      mysql_close(&w->mysql);
+      error= put_info("Can't create thread for --parallel", INFO_ERROR);
+      break;
+    }
+  }
+  parallel_count= i;
+  if (error)
+  {
+    parallel_failed= 1;                         // Don't commit anything
+    parallel_end();
+  }
+  return error;
+}
+
+
+/**
+  Let the workers finish their queues, close the connections and report
+  the errors.
+*/
+
+static int parallel_end()
+{
+  int error;
+
+  if (!parallel_workers)
+    return 0;
+  pthread_mutex_lock(&parallel_mutex);
+  parallel_stop= 1;
+  parallel_failed|= aborted;
+  pthread_cond_broadcast(&parallel_work);
+  pthread_mutex_unlock(&parallel_mutex);
+  for (uint i= 0; i < parallel_count; i++)
+  {
+    pthread_join(parallel_workers[i].thread, NULL);
+    mysql_close(&parallel_workers[i].mysql);
+  }
+  error= parallel_report();
+  pthread_mutex_destroy(&parallel_mutex);
+  pthread_cond_destroy(&parallel_work);
+  pthread_cond_destroy(&parallel_idle);
+  delete_dynamic(&parallel_main_tables);
+  my_free(parallel_workers);
+  parallel_workers= NULL;
+  return error;
+}
+
+
+/*
+  Packing of statements (--pack-statements).
+
+  In batch mode, consecutive INSERT, REPLACE, UPDATE and DELETE statements
+  are collected and sent as one multi-statement query of up to
+  max_allowed_packet bytes, instead of one round trip each. Anything else
+  that may talk to the server sends the collected statements first.
+*/
+
+/**
+  Run the packed statements from first on, in one query.
+
+  @param failed  set to the statement that failed, if one did
+
+  @return 0 if all statements succeeded
+*/
+
+static bool pack_run(uint first, uint *failed)
+{
+  PACKED_STATEMENT *stmt= dynamic_element(&pack_statements, first,
+                                          PACKED_STATEMENT*);
+  uint i= first;
+  int next;
+
+  if (mysql_real_query(&mysql, pack_buffer.ptr() + stmt->offset,
+                       (ulong) (pack_buffer.length() - stmt->offset)))
+    goto err;
+  do
+  {
+    MYSQL_RES *result;
+    if ((result= mysql_store_result(&mysql)))
+      mysql_free_result(result);
+    else if (mysql_field_count(&mysql))
+      goto err;
+    if (verbose > 1)
+    {
+      char buff[80];
+      snprintf(buff, sizeof(buff), "Query OK, %ld %s affected",
+               (long) mysql_affected_rows(&mysql),
+               (long) mysql_affected_rows(&mysql) == 1 ? "row" : "rows");
+      put_info(buff, INFO_RESULT);
+      if (mysql_info(&mysql))
+        put_info(mysql_info(&mysql), INFO_RESULT);
+    }
+    i++;
+  } while (!(next= mysql_next_result(&mysql)));
+  if (next < 0)
+    return 0;
+
+err:
+  *failed= i;
+  return 1;
+}
+
+
+/**
+  Send the packed statements to the server. After a failed statement the
+  server skips the rest of the query, so with --force they are sent again.
+  The rows collected by --batch-inserts are sent too, as only one of the
+  two holds statements at any time.
+
+  @return the result of reporting the first error, 0 if there was none
+*/
+
+static int pack_flush()
+{
+  uint first= 0, failed;
+  int error= 0;
+
+  if (batch_rows.elements)
+    return batch_flush();
+  if (!pack_statements.elements)
+    return 0;
+  while (first < pack_statements.elements && pack_run(first, &failed))
+  {
+    PACKED_STATEMENT *stmt= dynamic_element(&pack_statements, failed,
+                                            PACKED_STATEMENT*);
+    size_t end= stmt->offset +
+                statement_delimiter_offset(pack_buffer.ptr() + stmt->offset,
+                                           pack_buffer.length() -
+                                           stmt->offset);
+    ulong save_line= status.query_start_line;
+    int res;
+
+    status.query_start_line= stmt->line;
+    res= put_error(&mysql);
+    status.query_start_line= save_line;
+    if (ob_error_top_str)
+    {
+      last_execute_buffer.length(0);
+      last_execute_buffer.append(pack_buffer.ptr() + stmt->offset,
+                                 end - stmt->offset);
+      print_error_sqlstr(&last_execute_buffer, ob_error_top_str);
+    }
+    if (!error)
+      error= res;
+    if (res > 0 || mysql_errno(&mysql) == CR_SERVER_GONE_ERROR ||
+        mysql_errno(&mysql) == CR_SERVER_LOST)
+      break;
+    first= failed + 1;
+  }
+  pack_buffer.length(0);
+  pack_statements.elements= 0;
+  return error;
+}
+
+
+/**
+  Add a statement that com_go() is about to run to the packed statements,
+  if it may be packed. Otherwise send the packed statements first.
+
+  @retval 1  the statement was packed or must not run, return *error
+  @retval 0  run the statement now
+*/
+
+static bool pack_statement(String *buffer, int *error)
+{
+  static const char *names[]= {"INSERT", "REPLACE", "UPDATE", "DELETE", NullS};
+  PACKED_STATEMENT stmt;
+  const char *word;
+  size_t length;
+  const char **name;
+
+  *error= 0;
+  if (!opt_pack_statements || !status.batch || mysql.oracle_mode ||
+      show_warnings || parallel_workers ||
+      !(word= statement_first_word(*buffer, &length)) ||
+      buffer->length() + PACKED_STATEMENT_END_LENGTH > opt_max_allowed_packet)
+    return (*error= pack_flush()) > 0;
+  for (name= names; *name; name++)
+  {
+    if (length == strlen(*name) && !strncasecmp(word, *name, length))
+      break;
+  }
+  if (!*name)
+    return (*error= pack_flush()) > 0;
+
+  if (pack_statements.elements &&
+      (pack_file_name != status.file_name ||
+       pack_buffer.length() + buffer->length() + PACKED_STATEMENT_END_LENGTH >
+       opt_max_allowed_packet) &&
+      (*error= pack_flush()) > 0)
+    return 1;
+  if (!pack_statements.buffer &&
+      my_init_dynamic_array(&pack_statements, sizeof(PACKED_STATEMENT),
+                            1024, 1024, MYF(0)))
+    return 0;
+  stmt.offset= pack_buffer.length();
+  stmt.line= status.query_start_line;
+  if (pack_buffer.append(*buffer) ||
+      pack_buffer.append(PACKED_STATEMENT_END, PACKED_STATEMENT_END_LENGTH) ||
+      insert_dynamic(&pack_statements, &stmt))
+  {
+    /* Out of memory, run it alone after the others */
+    pack_buffer.length(stmt.offset);
+    return (*error= pack_flush()) > 0;
+  }
+  pack_file_name= status.file_name;
+  return 1;
+}
+
+
+/*
+  Batching of INSERT statements (--batch-inserts).
+
+  In batch mode, consecutive statements of the form
+
+    INSERT [IGNORE] [INTO] t [(columns)] VALUES (row)
+
+  with the same text up to the row are sent as one statement with all the
+  rows, instead of one round trip each. The row is kept as written, so
+  the values go to the server exactly as they would have alone.
+
+  Only rows of literals are joined: a function like LAST_INSERT_ID() or
+  NOW(), a variable or a column name could see the other rows. The last
+  row of a batch is sent alone, so that LAST_INSERT_ID() afterwards is
+  the id of that row when it made one, as without batching. When the
+  last row does not make an id but others do, the id is that of the first
+  row of the batch that made one, where alone it would be the last.
+*/
+
+/**
+  Check whether a statement is a single row INSERT or REPLACE that may be
+  joined with others, and find where its row starts.
+
+  The part before the row must hold no strings or comments, so that
+  VALUES can't be mistaken, and the row must end the statement.
+
+  @return the offset of the opening parenthesis of the row, 0 if none
+*/
+
+static size_t batch_row_start(const char *query, size_t length)
+{
+  const char *pos= query, *end= query + length, *row;
+  int depth= 0;
+
+  while (end > pos && my_isspace(charset_info, end[-1]))
+    end--;
+  for (;;)
+  {
+    if (pos == end || *pos == '\'' || *pos == '"' || *pos == '#' ||
+        (*pos == '-' && pos + 1 < end && pos[1] == '-') ||
+        (*pos == '/' && pos + 1 < end && pos[1] == '*'))
+      return 0;
+    if (*pos == '`')
+    {
+      for (pos++; pos < end && *pos != '`'; pos++)
+        ;
+      if (pos++ == end)
+        return 0;
+      continue;
+    }
+    if ((pos == query || my_isspace(charset_info, pos[-1]) || pos[-1] == ')') &&
+        end - pos > 6 && !strncasecmp(pos, "VALUES", 6) &&
+        (my_isspace(charset_info, pos[6]) || pos[6] == '('))
+      break;
+    pos++;
+  }
+  for (pos+= 6; pos < end && my_isspace(charset_info, *pos); pos++)
+    ;
+  if (pos == end || *pos != '(')
+    return 0;
+
+  for (row= pos; pos < end; pos++)
+  {
+    char quote;
+    switch (*pos) {
+    case '(':
+      depth++;
+      break;
+    case ')':
+      if (!--depth)
+        return pos + 1 == end ? (size_t) (row - query) : 0;
+      break;
+    case '\'':
+    case '"':
+    case '`':
+      for (quote= *pos++; pos < end && *pos != quote; pos++)
+      {
+        if (*pos == '\\' && quote != '`' && pos + 1 < end)
+          pos++;
+      }
+      if (pos == end)
+        return 0;
+      break;
+    case '#':
+      return 0;
+    case '-':
+    case '/':
+      if (pos + 1 < end && pos[1] == (*pos == '-' ? '-' : '*'))
+        return 0;
+      break;
     }
-    if (!connected) {
-      my_free(current_user);
-      my_free(current_host_success);
-      current_user = my_strdup(saveuser.c_str(), MYF(MY_WME));
-      current_host_success = my_strdup(savehost.c_str(), MYF(MY_WME));
-      current_port_success = opt_mysql_port = saveport;
+  }
+  return 0;
+}
+
+
+/* True if a row of a batch of literal rows may be joined to it */
+
+static bool batch_row_is_literals(String *buffer, size_t row_start)
+{
+  size_t end= buffer->length();
+  while (end > row_start && my_isspace(charset_info, (*buffer)[end - 1]))
+    end--;
+  return statement_row_is_literals(buffer->ptr() + row_start,
+                                   end - row_start);
+}
+
+
+/* End in batch_buffer of the row at index i */
+
+static size_t batch_row_end(uint i)
+{
+  return i + 1 < batch_rows.elements ?
+         dynamic_element(&batch_rows, i + 1, BATCHED_ROW*)->offset - 1 :
+         batch_buffer.length();
+}
+
+
+/**
+  Run the row at index i of the batch alone.
+
+  @return 0 on success
+*/
+
+static bool batch_run_row(uint i, String *query)
+{
+  BATCHED_ROW *row= dynamic_element(&batch_rows, i, BATCHED_ROW*);
+  MYSQL_RES *result;
+
+  query->length(0);
+  if (query->append(batch_buffer.ptr(), batch_head_length) ||
+      query->append(batch_buffer.ptr() + row->offset,
+                    batch_row_end(i) - row->offset))
+    return 1;
+  if (mysql_real_query(&mysql, query->ptr(), (ulong) query->length()))
+    return 1;
+  if ((result= mysql_store_result(&mysql)))
+    mysql_free_result(result);
+  return mysql_errno(&mysql) != 0;
+}
+
+
+/**
+  Check that the table of the batch is transactional, so that a failed
+  INSERT of several rows left none of them behind.
+
+  @return 0 if it is not, or if that is not known
+*/
+
+static bool batch_table_is_transactional()
+{
+  const char *pos= batch_buffer.ptr();
+  const char *end= pos + batch_head_length;
+  const char *word, *names[2]= {NULL, NULL};
+  size_t length, lengths[2]= {0, 0};
+  char query[512 + 4 * NAME_LEN], *to;
+  MYSQL_RES *result;
+  MYSQL_ROW row;
+  bool transactional= 0;
+  uint count= 0;
+
+  parallel_word(&pos, end, &word);               /* INSERT or REPLACE */
+  while (parallel_next_is(&pos, end, "LOW_PRIORITY") ||
+         parallel_next_is(&pos, end, "DELAYED") ||
+         parallel_next_is(&pos, end, "HIGH_PRIORITY") ||
+         parallel_next_is(&pos, end, "IGNORE"))
+    ;
+  parallel_next_is(&pos, end, "INTO");
+  /* [db.]table, each name maybe in `` */
+  while (count < 2 && pos < end)
+  {
+    if (*pos == '`')
+    {
+      const char *close= (const char*) memchr(pos + 1, '`', end - pos - 1);
+      if (!close)
+        return 0;
+      word= pos + 1;
+      length= (size_t) (close - word);
+      pos= close + 1;
     }
-  } else {
-    opt_rehash= 0;
-    error = sql_connect(current_host, current_db, current_user, opt_password, 0);
+    else
+    {
+      for (word= pos; pos < end && parallel_is_ident_char(*pos); pos++)
+        ;
+      length= (size_t) (pos - word);
+    }
+    if (!length || length > NAME_LEN)
+      return 0;
+    names[count]= word;
+    lengths[count++]= length;
+    if (pos == end || *pos != '.')
+      break;
+    pos++;
   }
+  if (!count)
+    return 0;
 
-  if (oldtenant)
-    my_free(oldtenant);
-  if (newuser)
-    my_free(newuser);
-  if (newtenant)
-    my_free(newtenant);
-  oldtenant = NULL;
-  newuser = NULL;
-  newtenant = NULL;
+  to= strmov(query, "SELECT e.TRANSACTIONS FROM information_schema.TABLES t "
+                    "JOIN information_schema.ENGINES e ON e.ENGINE = t.ENGINE "
+                    "WHERE t.TABLE_SCHEMA = ");
+  if (count == 2)
+  {
+    *to++= '\'';
+    to+= mysql_real_escape_string(&mysql, to, names[0], (ulong) lengths[0]);
+    *to++= '\'';
+  }
+  else
+    to= strmov(to, "DATABASE()");
+  to= strmov(to, " AND t.TABLE_NAME = '");
+  to+= mysql_real_escape_string(&mysql, to, names[count - 1],
+                                (ulong) lengths[count - 1]);
+  to= strmov(to, "'");
+  if (mysql_real_query(&mysql, query, (ulong) (to - query)) ||
+      !(result= mysql_store_result(&mysql)))
+    return 0;
+  if ((row= mysql_fetch_row(result)) && row[0])
+    transactional= !my_strcasecmp(&my_charset_latin1, row[0], "YES");
+  mysql_free_result(result);
+  return transactional;
+}
 
-  opt_rehash= save_rehash;
-  if (connected)
+
+/*
+  batch_table_is_transactional() for the head of the batch, asked once
+  for a run of statements on the same table.
+*/
+
+static bool batch_head_is_transactional()
+{
+  const char *db= current_db ? current_db : "";
+
+  if (batch_checked_head.length() != batch_head_length ||
+      memcmp(batch_checked_head.ptr(), batch_buffer.ptr(),
+             batch_head_length) ||
+      strcmp(batch_checked_db, db))
   {
-    full_username = 0;
-    part_username = 0;
+    batch_checked_transactional= batch_table_is_transactional();
+    batch_checked_head.length(0);
+    if (batch_checked_head.append(batch_buffer.ptr(), batch_head_length))
+      batch_checked_head.length(0);
+    strmake_buf(batch_checked_db, db);
+  }
+  return batch_checked_transactional;
+}
 
-    get_current_db();
 
-    sprintf(buff,"Connection id:    %lu",mysql_thread_id(&mysql));
-    put_info(buff,INFO_INFO);
-    sprintf(buff,"Current database: %.128s\n", current_db ? current_db : "*** NONE ***");
-    put_info(buff,INFO_INFO);
+/**
+  Report the error of running rows of the batch against the line the
+  first of them was read from.
+*/
 
-    //relink success
-    start_login_sql(&mysql, &glob_buffer, get_login_sql_path());
+static int batch_report(uint i, uint error, const char *sqlstate,
+                        const char *message)
+{
+  BATCHED_ROW *row= dynamic_element(&batch_rows, i, BATCHED_ROW*);
+  ulong save_line= status.query_start_line;
+  int res;
+
+  status.query_start_line= row->line;
+  res= put_info(message, INFO_ERROR, error, sqlstate, mysql.oracle_mode);
+  status.query_start_line= save_line;
+  if (ob_error_top_str)
+  {
+    last_execute_buffer.length(0);
+    last_execute_buffer.append(batch_buffer.ptr(), batch_head_length);
+    last_execute_buffer.append(batch_buffer.ptr() + row->offset,
+                               batch_row_end(i) - row->offset);
+    print_error_sqlstr(&last_execute_buffer, ob_error_top_str);
+  }
+  return res;
+}
+
+
+static void batch_put_ok()
+{
+  if (verbose > 1)
+  {
+    char buff[80];
+    snprintf(buff, sizeof(buff), "Query OK, %ld %s affected",
+             (long) mysql_affected_rows(&mysql),
+             (long) mysql_affected_rows(&mysql) == 1 ? "row" : "rows");
+    put_info(buff, INFO_RESULT);
+    if (mysql_info(&mysql))
+      put_info(mysql_info(&mysql), INFO_RESULT);
+  }
+}
+
+
+static bool batch_lost()
+{
+  return mysql_errno(&mysql) == CR_SERVER_GONE_ERROR ||
+         mysql_errno(&mysql) == CR_SERVER_LOST;
+}
+
+
+/**
+  Send the collected rows to the server, all but the last as one
+  statement and the last alone. If the joined rows fail, they are sent
+  one by one, and each error is reported against the line its row was
+  read from, as if the statements had not been joined. That is why
+  batch_insert() only collects rows of transactional tables, where the
+  failed statement left none of its rows behind.
+
+  @return the result of reporting the first error, 0 if there was none
+*/
+
+static int batch_flush()
+{
+  String query;
+  uint count= batch_rows.elements;
+  int error= 0, res;
+
+  if (!count)
+    return 0;
+  if (count > 1)
+  {
+    BATCHED_ROW *last= dynamic_element(&batch_rows, count - 1, BATCHED_ROW*);
+
+    if (!mysql_real_query(&mysql, batch_buffer.ptr(),
+                          (ulong) (last->offset - 1)))
+      batch_put_ok();
+    else if (batch_lost())
+    {
+      /* Nothing is known of the rows when the connection went away */
+      error= batch_report(0, mysql_errno(&mysql), mysql_sqlstate(&mysql),
+                          mysql_error(&mysql));
+      goto end;
+    }
+    else
+    {
+      for (uint i= 0; i + 1 < count && error <= 0; i++)
+      {
+        if (!batch_run_row(i, &query))
+          continue;
+        res= batch_report(i, mysql_errno(&mysql), mysql_sqlstate(&mysql),
+                          mysql_error(&mysql));
+        if (!error)
+          error= res;
+        if (batch_lost())
+          goto end;
+      }
+      if (error > 0)
+        goto end;
+    }
+  }
+
+  if (!batch_run_row(count - 1, &query))
+    batch_put_ok();
+  else
+  {
+    res= batch_report(count - 1, mysql_errno(&mysql), mysql_sqlstate(&mysql),
+                      mysql_error(&mysql));
+    if (!error)
+      error= res;
   }
+
+end:
+  batch_buffer.length(0);
+  batch_rows.elements= 0;
   return error;
 }
 
-static int com_source(String *buffer __attribute__((unused)),
-                      char *line)
+
+/**
+  Add a statement that com_go() is about to run to the batch, if it is a
+  single row INSERT with the same head as the rows collected so far.
+  Otherwise send the batch first.
+
+  @retval 1  the row was added or the batch failed, return *error
+  @retval 0  run the statement now
+*/
+
+static bool batch_insert(String *buffer, int *error)
+{
+  BATCHED_ROW row;
+  const char *word;
+  size_t length, row_start;
+
+  *error= 0;
+  if (!opt_batch_inserts || !status.batch || mysql.oracle_mode ||
+      show_warnings || parallel_workers ||
+      !(word= statement_first_word(*buffer, &length)) ||
+      !((length == 6 && !strncasecmp(word, "INSERT", 6)) ||
+        (length == 7 && !strncasecmp(word, "REPLACE", 7))) ||
+      !(row_start= batch_row_start(buffer->ptr(), buffer->length())) ||
+      !batch_row_is_literals(buffer, row_start))
+    return (*error= batch_flush()) > 0;
+
+  if (batch_rows.elements &&
+      (batch_file_name != status.file_name ||
+       batch_rows.elements >= opt_batch_inserts ||
+       row_start != batch_head_length ||
+       memcmp(buffer->ptr(), batch_buffer.ptr(), row_start) ||
+       batch_buffer.length() + buffer->length() - row_start + 1 >
+       opt_max_allowed_packet) &&
+      (*error= batch_flush()) > 0)
+    return 1;
+  if (!batch_rows.elements)
+  {
+    /* Statements packed before the batch go first */
+    if ((*error= pack_flush()) > 0)
+      return 1;
+    if (!batch_rows.buffer &&
+        my_init_dynamic_array(&batch_rows, sizeof(BATCHED_ROW), 1024, 1024,
+                              MYF(0)))
+      return 0;
+    if (batch_buffer.append(buffer->ptr(), row_start))
+      return 0;
+    batch_head_length= row_start;
+    /* The rows of a failed batch must be sent again, see batch_flush() */
+    if (!batch_head_is_transactional())
+    {
+      batch_buffer.length(0);
+      return 0;
+    }
+  }
+  else if (batch_buffer.append(','))
+    return (*error= batch_flush()) > 0;
+  row.offset= batch_buffer.length();
+  row.line= status.query_start_line;
+  while (buffer->length() > row_start &&
+         my_isspace(charset_info, (*buffer)[buffer->length() - 1]))
+    buffer->length(buffer->length() - 1);
+  if (batch_buffer.append(buffer->ptr() + row_start,
+                          buffer->length() - row_start) ||
+      insert_dynamic(&batch_rows, &row))
+  {
+    /* Out of memory, run it alone after the others */
+    batch_buffer.length(row.offset - (batch_rows.elements ? 1 : 0));
+    return (*error= batch_flush()) > 0;
+  }
+  batch_file_name= status.file_name;
+  return 1;
+}
+
+
+/**
+  Run the statements of a script, on the given number of connections if
+  it is more than one.
+*/
+
+static int source_file(char *param, uint connections)
 {
-  char source_name[FN_REFLEN], *end, *param;
+  char source_name[FN_REFLEN], *end;
   LINE_BUFFER *line_buff;
   int error;
   STATUS old_status;
   FILE *sql_file;
   my_bool save_ignore_errors;
+  bool parallel= connections > 1 && !parallel_workers;
 
-  /* Skip space from file name */
-  while (my_isspace(charset_info,*line))
-    line++;
-  if (!(param = strchr(line, ' ')))		// Skip command name
-    return put_info("Usage: \\. <filename> | source <filename>", 
-		    INFO_ERROR, 0);
-  while (my_isspace(charset_info,*param))
-    param++;
   end=strmake_buf(source_name, param);
   while (end > source_name && (my_isspace(charset_info,end[-1]) || 
                                my_iscntrl(charset_info,end[-1])))
@@ -5842,7 +9311,12 @@ static int com_source(String *buffer __attribute__((unused)),
   glob_buffer.length(0);			// Empty command buffer
   ignore_errors= !batch_abort_on_error;
   in_com_source= 1;
-  error= read_and_execute(false);
+  if (!parallel || (error= parallel_begin(connections)) <= 0)
+  {
+    error= read_and_execute(false);
+    if (parallel && parallel_end() > 0)
+      error= 1;
+  }
   ignore_errors= save_ignore_errors;
   status=old_status;				// Continue as before
   in_com_source= aborted= 0;
@@ -5858,6 +9332,49 @@ static int com_source(String *buffer __attribute__((unused)),
 }
 
 
+static int com_source(String *buffer __attribute__((unused)),
+                      char *line)
+{
+  char *param;
+
+  /* Skip space from file name */
+  while (my_isspace(charset_info,*line))
+    line++;
+  if (!(param = strchr(line, ' ')))		// Skip command name
+    return put_info("Usage: \\. <filename> | source <filename>", 
+		    INFO_ERROR, 0);
+  while (my_isspace(charset_info,*param))
+    param++;
+  return source_file(param, 0);
+}
+
+
+static int com_parallel_source(String *buffer __attribute__((unused)),
+                               char *line)
+{
+  char *param, *end;
+  uint connections= opt_parallel;
+
+  while (my_isspace(charset_info,*line))
+    line++;
+  if (!(param = strchr(line, ' ')))		// Skip command name
+    return put_info("Usage: psource [connections] <filename>",
+		    INFO_ERROR, 0);
+  while (my_isspace(charset_info,*param))
+    param++;
+  /* An optional number of connections before the file name */
+  for (end= param; my_isdigit(charset_info, *end); end++)
+    ;
+  if (end > param && my_isspace(charset_info, *end))
+  {
+    connections= atoi(param);
+    for (param= end; my_isspace(charset_info, *param); param++)
+      ;
+  }
+  return source_file(param, connections);
+}
+
+
 	/* ARGSUSED */
 static int
 com_delimiter(String *buffer __attribute__((unused)), char *line)
@@ -5962,9 +9479,10 @@ com_use(String *buffer __attribute__((unused)), char *line)
     }
     my_free(current_db);
     current_db=my_strdup(tmp,MYF(MY_WME));
+    parallel_select_db(current_db);
 #ifdef HAVE_READLINE
     if (select_db > 1)
-      build_completion_hash(opt_rehash, 1);
+      build_completion_hash(opt_rehash, 1, 1);
 #endif
   }
 
@@ -6369,82 +9887,309 @@ static void parse_multi_host(char *host, std::map<char*, int>* mhost)
       if (port > 0) {
         (*mhost)[myhost] = port;
       }
-      myhost = NULL;
-      myport = NULL;
+      myhost = NULL;
+      myport = NULL;
+    }
+    p++;
+  }
+}
+
+/* Milliseconds between the starts of the connects of a race */
+#define CONNECT_RACE_STAGGER 200
+/* Milliseconds a failed host stays on the blacklist of ObClientLbConfig */
+#define CONNECT_BLACKLIST_DURATION 60000
+
+
+/* Set --socket5-proxy on con. socket5_proxy must be kept until it connects */
+
+static void set_socket5_options(MYSQL *con, String &socket5_proxy)
+{
+  if (ob_socket5_proxy_str && *ob_socket5_proxy_str) {
+    char *socket5_host = NULL;
+    char *socket5_user = NULL;
+    char *socket5_pwd = NULL;
+    int socket5_port = 0;
+    socket5_proxy.append(ob_socket5_proxy_str);
+    parse_socket5_proxy(socket5_proxy.c_ptr_safe(), &socket5_host, &socket5_port, &socket5_user, &socket5_pwd);
+    if (socket5_host && socket5_port > 0) {
+      ob_set_socket5_proxy(con, 0, socket5_host, socket5_port, socket5_user, socket5_pwd);
+    }
+  }
+}
+
+
+/*
+  A --connect-race. Each racer logs in to one host of the list with
+  ob_mysql_real_connect() in a thread of its own, with the ObClientLbConfig
+  of the connect, so that a host that fails goes to its blacklist as in a
+  connect to the whole list. A login can't be stopped half way: racers
+  that lose close their session when they are done, and the last thread
+  to leave the race frees it.
+*/
+
+typedef struct st_connect_racer
+{
+  struct st_connect_race *race;
+  MYSQL mysql;
+  ObClientLbAddress address;
+} CONNECT_RACER;
+
+typedef struct st_connect_race
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint users;                                 /* Caller and running racers */
+  uint finished;
+  bool over;                                  /* The caller has left */
+  int winner;
+  ObClientLbConfig config;
+  char *user, *password, *database;
+  ulong flags;
+  CONNECT_RACER *racers;
+} CONNECT_RACE;
+
+
+static void connect_race_leave(CONNECT_RACE *race)
+{
+  bool last= !--race->users;
+  pthread_mutex_unlock(&race->lock);
+  if (last)
+  {
+    pthread_cond_destroy(&race->cond);
+    pthread_mutex_destroy(&race->lock);
+    my_free(race);
+  }
+}
+
+
+pthread_handler_t connect_racer_thread(void *arg)
+{
+  CONNECT_RACER *racer= (CONNECT_RACER*) arg;
+  CONNECT_RACE *race= racer->race;
+  ObClientLbAddressList list;
+  ObClientLbAddress address;
+  String socket5_proxy;
+  bool success;
+
+  mysql_thread_init();
+  bzero(&list, sizeof(list));
+  bzero(&address, sizeof(address));
+  list.address_list= &racer->address;
+  list.address_list_count= 1;
+  set_socket5_options(&racer->mysql, socket5_proxy);
+  success= ob_mysql_real_connect(&racer->mysql, NULL, &list, &race->config,
+                                 race->user, race->password, race->database,
+                                 NULL, race->flags, &address) != NULL;
+  pthread_mutex_lock(&race->lock);
+  race->finished++;
+  if (success && !race->over && race->winner < 0)
+    race->winner= (int) (racer - race->racers);
+  else
+    mysql_close(&racer->mysql);
+  pthread_cond_signal(&race->cond);
+  connect_race_leave(race);
+  mysql_thread_end();
+  return 0;
+}
+
+
+/**
+  Race the logins to the hosts of a list, and move the session of the
+  first to succeed into con.
+
+  At most opt_connect_race logins are in flight, a new one is started
+  every CONNECT_RACE_STAGGER ms or as soon as one fails. The race gives
+  up after connect_timeout, or 10 seconds without it, and the caller then
+  connects to the list one host after the other.
+
+  @return 1 if con is connected, and *address is the host it is on
+*/
+
+static bool connect_race(MYSQL *con, ObClientLbAddressList *list,
+                         ObClientLbConfig *config, const char *user,
+                         const char *password, const char *database,
+                         ulong flags, ObClientLbAddress *address)
+{
+  uint count= (uint) list->address_list_count, next= 0, finished= 0;
+  ulonglong now= my_interval_timer(), deadline, next_start= now;
+  CONNECT_RACE *race;
+  bool won;
+
+  if (count < 2 ||
+      !my_multi_malloc(MYF(MY_WME | MY_ZEROFILL),
+                       &race, sizeof(*race),
+                       &race->racers, count * sizeof(CONNECT_RACER),
+                       &race->user, strlen(user ? user : "") + 1,
+                       &race->password, strlen(password ? password : "") + 1,
+                       &race->database, strlen(database ? database : "") + 1,
+                       NullS))
+    return 0;
+  strmov(race->user, user ? user : "");
+  strmov(race->password, password ? password : "");
+  strmov(race->database, database ? database : "");
+  race->config= *config;
+  race->flags= flags;
+  race->winner= -1;
+  race->users= 1;
+  for (uint i= 0; i < count; i++)
+  {
+    race->racers[i].race= race;
+    race->racers[i].address= list->address_list[i];
+  }
+  pthread_mutex_init(&race->lock, NULL);
+  pthread_cond_init(&race->cond, NULL);
+  deadline= now + (opt_connect_timeout ? opt_connect_timeout : 10) *
+                  1000000000ULL;
+
+  pthread_mutex_lock(&race->lock);
+  while (race->winner < 0 && now < deadline)
+  {
+    uint running= next - race->finished;
+    ulonglong wake= deadline;
+    struct timespec abstime;
+
+    if (race->finished > finished)
+    {
+      finished= race->finished;
+      next_start= now;                          /* One failed, start another */
+    }
+    if (next < count && running < opt_connect_race &&
+        (now >= next_start || !running))
+    {
+      CONNECT_RACER *racer= &race->racers[next++];
+      pthread_t thread;
+
+      mysql_init(&racer->mysql);
+      race->users++;
+      if (pthread_create(&thread, NULL, connect_racer_thread, (void*) racer))
+      {
+        race->users--;
+        race->finished++;
+        mysql_close(&racer->mysql);
+      }
+      else
+        pthread_detach(thread);
+      next_start= now + CONNECT_RACE_STAGGER * 1000000ULL;
+      continue;
     }
-    p++;
+    if (!running)
+      break;                                    /* All hosts failed */
+    if (next < count && running < opt_connect_race)
+      set_if_smaller(wake, next_start);
+    set_timespec_nsec(abstime, wake - now);
+    pthread_cond_timedwait(&race->cond, &race->lock, &abstime);
+    now= my_interval_timer();
   }
-}
 
-static int sql_real_connect(char *host,char *database,char *user,char *password, uint silent)
-{
-  String socket5_proxy;
-  if (connected)
+  race->over= 1;
+  if ((won= race->winner >= 0))
   {
-    connected= 0;
-    mysql_close(&mysql);
+    CONNECT_RACER *winner= &race->racers[race->winner];
+    session_move(con, &winner->mysql);
+    *address= winner->address;
   }
-  mysql_init(&mysql);
+  connect_race_leave(race);
+  return won;
+}
 
-  if (ob_socket5_proxy_str && *ob_socket5_proxy_str) {
-    char *socket5_host = NULL;
-    char *socket5_user = NULL;
-    char *socket5_pwd = NULL;
-    int socket5_port = 0;
-    socket5_proxy.append(ob_socket5_proxy_str);
-    parse_socket5_proxy(socket5_proxy.c_ptr_safe(), &socket5_host, &socket5_port, &socket5_user, &socket5_pwd);
-    if (socket5_host && socket5_port > 0) {
-      ob_set_socket5_proxy(&mysql, 0, socket5_host, socket5_port, socket5_user, socket5_pwd);
-    }
+
+/*
+  Set the options that sql_real_connect() uses for a new connection,
+  before do_connect() is called. socket5_proxy must be kept until the
+  connection is made.
+*/
+
+/*
+  Resolve default_charset to the name the connector is given. This
+  changes default_charset, so only the main thread may call it.
+*/
+
+static const char *connect_charset_name()
+{
+  if (!strcmp(default_charset,MYSQL_AUTODETECT_CHARSET_NAME))
+    default_charset= (char *)my_default_csname();
+  if (strncasecmp(default_charset, "GB18030-2022", 12) == 0) {
+    default_charset = (char*)"GB18030";
+  }
+  if (strncasecmp(default_charset, "BIG5-HKSCS", 10) == 0 || 
+    strncasecmp(default_charset, "BIG5HKSCS", 9) == 0) {
+    default_charset = (char*)"big5";
   }
+  return default_charset;
+}
+
+
+/*
+  Set the options of a new connection. Other threads must pass the
+  charset, which the main thread got from connect_charset_name().
+*/
+
+static void set_connect_options(MYSQL *con, String &socket5_proxy,
+                                const char *charset)
+{
+  set_socket5_options(con, socket5_proxy);
 
   if (opt_init_command)
-    mysql_options(&mysql, MYSQL_INIT_COMMAND, opt_init_command);
+    mysql_options(con, MYSQL_INIT_COMMAND, opt_init_command);
   if (opt_connect_timeout)
   {
     uint timeout=opt_connect_timeout;
-    mysql_options(&mysql,MYSQL_OPT_CONNECT_TIMEOUT,
+    mysql_options(con,MYSQL_OPT_CONNECT_TIMEOUT,
 		  (char*) &timeout);
   }
   if (opt_compress)
-    mysql_options(&mysql,MYSQL_OPT_COMPRESS,NullS);
+    mysql_options(con,MYSQL_OPT_COMPRESS,NullS);
   if (using_opt_local_infile)
-    mysql_options(&mysql,MYSQL_OPT_LOCAL_INFILE, (char*) &opt_local_infile);
+    mysql_options(con,MYSQL_OPT_LOCAL_INFILE, (char*) &opt_local_infile);
   if (safe_updates)
   {
     char init_command[100];
-    sprintf(init_command,
-	    "SET SQL_SAFE_UPDATES=1,SQL_SELECT_LIMIT=%lu,MAX_JOIN_SIZE=%lu",
-	    select_limit,max_join_size);
-    mysql_options(&mysql, MYSQL_INIT_COMMAND, init_command);
-  }
-  if (!strcmp(default_charset,MYSQL_AUTODETECT_CHARSET_NAME))
-    default_charset= (char *)my_default_csname();
-  if (strncasecmp(default_charset, "GB18030-2022", 12) == 0) {
-    default_charset = (char*)"GB18030";
-  }
-  if (strncasecmp(default_charset, "BIG5-HKSCS", 10) == 0 || 
-    strncasecmp(default_charset, "BIG5HKSCS", 9) == 0) {
-    default_charset = (char*)"big5";
+    mysql_options(con, MYSQL_INIT_COMMAND,
+                  safe_updates_command(init_command, sizeof(init_command)));
   }
-  mysql_options(&mysql, MYSQL_SET_CHARSET_NAME, default_charset);
+  mysql_options(con, MYSQL_SET_CHARSET_NAME,
+                charset ? charset : connect_charset_name());
 
   my_bool can_handle_expired= opt_connect_expired_password || !status.batch;
-  mysql_options(&mysql, MYSQL_OPT_CAN_HANDLE_EXPIRED_PASSWORDS, &can_handle_expired);
+  mysql_options(con, MYSQL_OPT_CAN_HANDLE_EXPIRED_PASSWORDS, &can_handle_expired);
+}
 
-  if (!do_connect(&mysql, host, user, password, database,
-                  connect_flag | CLIENT_MULTI_STATEMENTS))
+static int sql_real_connect(char *host,char *database,char *user,char *password, uint silent)
+{
+  String socket5_proxy;
+  if (connected)
+  {
+    connected= 0;
+    session_cache_put(&mysql);
+  }
+  if (!session_cache_get(&mysql, host, user, password, database) &&
+      !standby_take(&mysql, host, user, password, database))
   {
-    if (!silent ||
-      (mysql_errno(&mysql) != CR_CONN_HOST_ERROR &&
-        mysql_errno(&mysql) != CR_CONNECTION_ERROR))
+    mysql_init(&mysql);
+    set_connect_options(&mysql, socket5_proxy);
+
+    if (!do_connect(&mysql, host, opt_mysql_port, user, password, database,
+                    connect_flag | CLIENT_MULTI_STATEMENTS))
     {
-      (void) put_error(&mysql);
-      (void) fflush(stdout);
-      return ignore_errors ? -1 : 1;		// Abort
+      if (!silent ||
+        (mysql_errno(&mysql) != CR_CONN_HOST_ERROR &&
+          mysql_errno(&mysql) != CR_CONNECTION_ERROR))
+      {
+        (void) put_error(&mysql);
+        (void) fflush(stdout);
+        return ignore_errors ? -1 : 1;		// Abort
+      }
+      return -1;					// Retryable
     }
-    return -1;					// Retryable
   }
+  if (opt_session_cache)
+  {
+    session_key_make(session_key, host, opt_mysql_port, user, database);
+    my_free(session_password);
+    session_password= my_strdup(password ? password : "", MYF(MY_WME));
+  }
+  current_host_success = my_strdup(host?host:"", MYF(MY_WME));
+  current_port_success = opt_mysql_port;
 
   charset_info= get_charset_by_name(mysql.charset->name, MYF(0));
 
@@ -6466,8 +10211,9 @@ static int sql_real_connect(char *host,char *database,char *user,char *password,
   }
 #endif
 #ifdef HAVE_READLINE
-  build_completion_hash(opt_rehash, 1);
+  build_completion_hash(opt_rehash, 1, 1);
 #endif
+  standby_open();
   return 0;
 }
 static int sql_real_connect_multi(const char* tns_name, ObClientLbAddressList *list, char *database, char *user, char *password, uint silent)
@@ -6482,26 +10228,15 @@ static int sql_real_connect_multi(const char* tns_name, ObClientLbAddressList *l
 
   if (connected) {
     connected = 0;
-    mysql_close(&mysql);
-  }
-  mysql_init(&mysql);
-
-  if (ob_socket5_proxy_str && *ob_socket5_proxy_str) {
-    char *socket5_host = NULL;
-    char *socket5_user = NULL;
-    char *socket5_pwd = NULL;
-    int socket5_port = 0;
-    socket5_proxy.append(ob_socket5_proxy_str);
-    parse_socket5_proxy(socket5_proxy.c_ptr_safe(), &socket5_host, &socket5_port, &socket5_user, &socket5_pwd);
-    if (socket5_host && socket5_port > 0) {
-      ob_set_socket5_proxy(&mysql, 0, socket5_host, socket5_port, socket5_user, socket5_pwd);
-    }
+    session_cache_put(&mysql);
   }
+  /* Sessions of a load balanced list are not cached */
+  session_key[0] = 0;
 
   config.black_remove_strategy = 2001;
   config.black_remove_timeout = 0;
   config.black_append_strategy = 3002;
-  config.black_append_duration = 60000;
+  config.black_append_duration = CONNECT_BLACKLIST_DURATION;
   config.black_append_retrytimes = 1;
   config.retry_all_downs = 0;
 
@@ -6549,13 +10284,21 @@ static int sql_real_connect_multi(const char* tns_name, ObClientLbAddressList *l
     config.mysql_ob_proxy_user = ob_proxy_user_str;
 
 
-  if (NULL != ob_mysql_real_connect(&mysql, tns_name, list, &config,
-    user, password, database, NULL, connect_flag | CLIENT_MULTI_STATEMENTS, &address)) {
-    success = 1;
+  /* The hosts of a tnsnames.ora entry are only known to the connector */
+  if (!tns_name && opt_connect_race > 1)
+    success = connect_race(&mysql, list, &config, user, password, database,
+                           connect_flag | CLIENT_MULTI_STATEMENTS, &address);
+  else
+    success = 0;
+  if (!success) {
+    mysql_init(&mysql);
+    set_socket5_options(&mysql, socket5_proxy);
+    success = NULL != ob_mysql_real_connect(&mysql, tns_name, list, &config,
+      user, password, database, NULL, connect_flag | CLIENT_MULTI_STATEMENTS, &address);
+  }
+  if (success) {
     current_host_success = my_strdup(address.host, MYF(MY_WME));
     current_port_success = address.port;
-  } else {
-    success = 0;
   }
 
   if (!success) {
@@ -6583,8 +10326,9 @@ static int sql_real_connect_multi(const char* tns_name, ObClientLbAddressList *l
   }
 #endif
 #ifdef HAVE_READLINE
-  build_completion_hash(opt_rehash, 1);
+  build_completion_hash(opt_rehash, 1, 1);
 #endif
+  standby_open();
   return 0;
 }
 
@@ -6890,6 +10634,7 @@ put_info(const char *str, INFO_TYPE info_type, uint error, const char *sqlstate,
   /*When 2>&1 is redirected in non-interactive mode, 
   fflush is forced to prevent stderr and stdout from being in the wrong order*/
   if (info_type == INFO_ERROR){
+    tee_flush();
     fflush(stdout);
   }
   
@@ -6997,10 +10742,63 @@ static void remove_cntrl(String &buffer)
 }
 
 
+/*
+  Output written to the pager while a result is being printed is collected
+  in tee_buffer and passed to the pager and the tee file in large blocks,
+  instead of one putc() per byte and stream. The buffer is attached to
+  PAGER by init_pager() and flushed by end_pager(); writes to any other
+  stream flush it first so that the output order is kept.
+*/
+
+static void tee_flush()
+{
+  if (tee_buffer_used)
+  {
+    (void) fwrite(tee_buffer, 1, tee_buffer_used, tee_buffer_file);
+    if (opt_outfile)
+      (void) fwrite(tee_buffer, 1, tee_buffer_used, OUTFILE);
+    tee_buffer_used= 0;
+  }
+}
+
+
+static void tee_write(const char *s, size_t length, FILE *file)
+{
+  if (file == tee_buffer_file && length <= TEE_BUFFER_SIZE / 2)
+  {
+    if (tee_buffer_used + length > TEE_BUFFER_SIZE)
+      tee_flush();
+    memcpy(tee_buffer + tee_buffer_used, s, length);
+    tee_buffer_used+= length;
+    return;
+  }
+  tee_flush();
+  (void) fwrite(s, 1, length, file);
+  if (opt_outfile)
+    (void) fwrite(s, 1, length, OUTFILE);
+}
+
+
+/* Write count copies of c, used for the padding of table cells */
+
+static void tee_fill(char c, size_t count, FILE *file)
+{
+  char buff[128];
+  memset(buff, c, MY_MIN(count, sizeof(buff)));
+  while (count)
+  {
+    size_t length= MY_MIN(count, sizeof(buff));
+    tee_write(buff, length, file);
+    count-= length;
+  }
+}
+
+
 void tee_fprintf(FILE *file, const char *fmt, ...)
 {
   va_list args;
 
+  tee_flush();
   va_start(args, fmt);
   (void) vfprintf(file, fmt, args);
   va_end(args);
@@ -7016,33 +10814,26 @@ void tee_fprintf(FILE *file, const char *fmt, ...)
 
 void tee_fputs(const char *s, FILE *file)
 {
-  fputs(s, file);
-  if (opt_outfile)
-    fputs(s, OUTFILE);
+  tee_write(s, strlen(s), file);
 }
 
 
 void tee_puts(const char *s, FILE *file)
 {
-  fputs(s, file);
-  fputc('\n', file);
-  if (opt_outfile)
-  {
-    fputs(s, OUTFILE);
-    fputc('\n', OUTFILE);
-  }
+  tee_write(s, strlen(s), file);
+  tee_write("\n", 1, file);
 }
 
 void tee_putc(int c, FILE *file)
 {
-  putc(c, file);
-  if (opt_outfile)
-    putc(c, OUTFILE);
+  char ch= (char) c;
+  tee_write(&ch, 1, file);
 }
 
 void tee_outfile(const char *s) {
   if (opt_outfile)
   {
+    tee_flush();
     fputs(s, OUTFILE);
   }
 }
@@ -7094,6 +10885,191 @@ static void end_timer(ulonglong start_time, char *buff)
   strmov(strend(buff),")");
 }
 
+
+/*
+  Statement profile.
+
+  com_go() notes when a statement starts, when it has been sent, when the
+  first answer arrives, when the last row has been read and when printing
+  ends. profile_record() adds the phases in between to histograms of the
+  session, which cost a few timer reads and increments per statement.
+*/
+
+static const char *profile_phase_names[PROFILE_PHASES]=
+{"send", "server", "transfer", "render", "total"};
+
+
+static uint profile_bucket(ulonglong value)
+{
+  uint shift= 0;
+
+  if (value < PROFILE_SUB_BUCKETS)
+    return (uint) value;
+  for (ulonglong v= value >> 5; v; v>>= 1)
+    shift++;
+  return shift * PROFILE_SUB_BUCKETS + (uint) (value >> shift);
+}
+
+
+/* The smallest value of a bucket */
+
+static ulonglong profile_bucket_value(uint bucket)
+{
+  uint shift= bucket < 2 * PROFILE_SUB_BUCKETS ? 0 :
+              bucket / PROFILE_SUB_BUCKETS - 1;
+  return (ulonglong) (bucket - shift * PROFILE_SUB_BUCKETS) << shift;
+}
+
+
+/* The value below which the fraction p of the values lie, at most max */
+
+static ulonglong profile_percentile(PROFILE_HISTOGRAM *hist, double p)
+{
+  ulonglong rank= (ulonglong) ceil(p * hist->count), seen= 0;
+
+  for (uint i= 0; i < PROFILE_BUCKETS; i++)
+  {
+    if ((seen+= hist->buckets[i]) >= rank && seen)
+      return MY_MIN(profile_bucket_value(i + 1) - 1, hist->max);
+  }
+  return hist->max;
+}
+
+
+static void profile_record()
+{
+  struct st_statement_profile *prof= &statement_profile;
+  ulonglong done= microsecond_interval_timer();
+  ulonglong marks[PROFILE_PHASES + 1];
+
+  /* Each mark is at least the previous one, as some are not always set */
+  marks[0]= prof->start;
+  marks[1]= MY_MAX(prof->sent, marks[0]);
+  marks[2]= MY_MAX(prof->first, marks[1]);
+  marks[3]= MY_MAX(prof->last_row, marks[2]);
+  marks[4]= MY_MAX(done, marks[3]);
+  for (uint i= 0; i < PROFILE_PHASES; i++)
+  {
+    PROFILE_HISTOGRAM *hist= &prof->phases[i];
+    ulonglong value= i == PROFILE_TOTAL ? marks[4] - marks[0] :
+                                          marks[i + 1] - marks[i];
+    prof->last[i]= value;
+    hist->count++;
+    hist->sum+= value;
+    set_if_bigger(hist->max, value);
+    hist->buckets[profile_bucket(value)]++;
+  }
+  prof->last_row= 0;
+}
+
+
+static void profile_nice_time(ulonglong usec, char *buff)
+{
+  if (usec < 1000)
+    sprintf(buff, "%llu us", usec);
+  else if (usec < 1000 * 1000)
+    sprintf(buff, "%.2f ms", usec / 1000.0);
+  else
+    nice_time(usec / 1000000.0, buff, 1);
+}
+
+
+static int
+com_profile(String *buffer __attribute__((unused)), char *line)
+{
+  struct st_statement_profile *prof= &statement_profile;
+  char buff[256], arg[256], *param;
+
+  strmake_buf(arg, line);
+  param= get_arg(arg, GET);
+  if (param && *param)
+  {
+    if (strcasecmp(param, "reset"))
+      return put_info("Usage: \\f [reset] | profile [reset]", INFO_ERROR, 0);
+    bzero((char*) prof->phases, sizeof(prof->phases));
+    put_info("Statement profile reset.", INFO_INFO);
+    return 0;
+  }
+  if (!prof->phases[PROFILE_TOTAL].count)
+  {
+    put_info("No statement has been timed yet.", INFO_INFO);
+    return 0;
+  }
+
+  tee_fprintf(stdout, "Last statement:\n");
+  for (uint i= 0; i < PROFILE_PHASES; i++)
+  {
+    profile_nice_time(prof->last[i], buff);
+    tee_fprintf(stdout, "  %-10s %s\n", profile_phase_names[i], buff);
+  }
+  tee_fprintf(stdout, "\n%llu statements:\n",
+              prof->phases[PROFILE_TOTAL].count);
+  tee_fprintf(stdout, "  %-10s %12s %12s %12s %12s %12s\n",
+              "phase", "avg", "p50", "p90", "p99", "max");
+  for (uint i= 0; i < PROFILE_PHASES; i++)
+  {
+    PROFILE_HISTOGRAM *hist= &prof->phases[i];
+    ulonglong values[5];
+    values[0]= hist->sum / hist->count;
+    values[1]= profile_percentile(hist, 0.5);
+    values[2]= profile_percentile(hist, 0.9);
+    values[3]= profile_percentile(hist, 0.99);
+    values[4]= hist->max;
+    tee_fprintf(stdout, "  %-10s", profile_phase_names[i]);
+    for (uint j= 0; j < array_elements(values); j++)
+    {
+      profile_nice_time(values[j], buff);
+      tee_fprintf(stdout, " %12s", buff);
+    }
+    tee_fprintf(stdout, "\n");
+  }
+  tee_fprintf(stdout, "\n");
+  return 0;
+}
+
+
+/**
+  Write the histograms to --profile-file, in microseconds. A bucket is
+  written as its smallest value and its count, and empty buckets are
+  left out.
+*/
+
+static void profile_write()
+{
+  struct st_statement_profile *prof= &statement_profile;
+  FILE *file;
+
+  if (!opt_profile_file)
+    return;
+  if (!(file= my_fopen(opt_profile_file, O_WRONLY | O_TRUNC | O_CREAT,
+                       MYF(MY_WME))))
+    return;
+  fprintf(file, "{\"version\": 1, \"unit\": \"us\", \"statements\": %llu, "
+          "\"phases\": {", prof->phases[PROFILE_TOTAL].count);
+  for (uint i= 0; i < PROFILE_PHASES; i++)
+  {
+    PROFILE_HISTOGRAM *hist= &prof->phases[i];
+    const char *sep= "";
+    fprintf(file, "%s\n  \"%s\": {\"count\": %llu, \"sum\": %llu, "
+            "\"max\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, "
+            "\"buckets\": [", i ? "," : "", profile_phase_names[i],
+            hist->count, hist->sum, hist->max,
+            profile_percentile(hist, 0.5), profile_percentile(hist, 0.9),
+            profile_percentile(hist, 0.99));
+    for (uint j= 0; j < PROFILE_BUCKETS; j++)
+    {
+      if (!hist->buckets[j])
+        continue;
+      fprintf(file, "%s[%llu, %llu]", sep, profile_bucket_value(j),
+              hist->buckets[j]);
+      sep= ", ";
+    }
+    fprintf(file, "]}");
+  }
+  fprintf(file, "\n}}\n");
+  my_fclose(file, MYF(MY_WME));
+}
+
 static void get_tenant_clust_name(const char *username, char* tenant, int tenant_len, char* clust, int clust_len)
 {
   int i = 0, j = 0;
@@ -7440,12 +11416,21 @@ static char* get_trim_comment_sql(const char* str, int len)
     ret = p;
   return ret;
 }
+/*
+  The pattern is anchored and only reads the head of the statement, so
+  it is given the length: regexec() would else take strlen() of all of
+  a PL block collected so far, once for every blank line of it.
+*/
 static my_bool is_oracle_pl_escape_sql(const char *str, int len)
 {
   my_bool ret = 0;
   char *p = get_trim_comment_sql(str, len);
-  if (p && 0 == (regexec(&pl_escape_sql_re, p, 0, 0, 0))) {
-    ret = 1;
+  regmatch_t whole;
+  if (p && statement_kind_is_pl(get_statement_kind(p, len - (p - str)))) {
+    whole.rm_so = 0;
+    whole.rm_eo = (regoff_t) (len - (p - str));
+    if (0 == regexec(&pl_escape_sql_re, p, 1, &whole, REG_STARTEND))
+      ret = 1;
   }
   return ret;
 }
@@ -7756,32 +11741,83 @@ static int set_param_oracle(const char *str, int len) {
   return rst;
 }
 
-static void get_end_str(char define, String *endstr1, String *endstr2, String *endstr3){
-  char *p = (char*)"~!@#$%^&*()+`=-{}|[]:\";'<>?,./\t\r\n\\ ";
-  endstr1->length(0);
-  endstr2->length(0);
-  endstr3->length(0);
-  while (*p!='\0'){
-    endstr1->append_char(*p);
+/*
+  Classes of the characters after a define character: any of them ends
+  a variable name, and the ones that are not the define character are
+  separators, some of them white space.
+*/
+#define DEFINE_END        1
+#define DEFINE_SEPARATOR  2
+#define DEFINE_NOTE       4
+
+static uchar define_end_class[256];
+static char define_end_class_char= 0;
+
+static void init_define_end_class(char define){
+  const char *p = "~!@#$%^&*()+`=-{}|[]:\";'<>?,./\t\r\n\\ ";
+  if (define_end_class_char == define)
+    return;
+  bzero(define_end_class, sizeof(define_end_class));
+  for (; *p != '\0'; p++) {
+    uchar c = (uchar) *p;
+    define_end_class[c] = DEFINE_END;
     if (*p != define) {
-      endstr2->append_char(*p);
-      if (!my_isspace(charset_info, *p)) {
-        endstr3->append_char(*p);
-      }
+      define_end_class[c] |= DEFINE_SEPARATOR;
+      if (!my_isspace(charset_info, *p))
+        define_end_class[c] |= DEFINE_NOTE;
     }
-    p++;
   }
+  define_end_class_char = define;
+}
+
+static uchar *get_define_var_key(const uchar *record, size_t *length,
+                                 my_bool not_used __attribute__((unused)))
+{
+  DEFINE_VAR *var = (DEFINE_VAR*) record;
+  *length = var->name_length;
+  return (uchar*) var->name;
+}
+
+static DEFINE_VAR *find_define_var(const char *name, size_t length)
+{
+  return (DEFINE_VAR*) my_hash_search(&global_define_hash,
+                                      (const uchar*) name, length);
+}
+
+/* Add a variable, or replace the value of the one with the same name */
+static void set_define_var(const char *name, size_t name_length,
+                           const char *value, size_t value_length)
+{
+  DEFINE_VAR *var, *old;
+  if (my_hash_init_opt(&global_define_hash, &my_charset_latin1, 16, 0, 0,
+                       get_define_var_key, my_free, MYF(0)))
+    return;
+  if (!(var = (DEFINE_VAR*) my_malloc(sizeof(DEFINE_VAR) + name_length +
+                                      value_length + 2, MYF(MY_WME))))
+    return;
+  old = find_define_var(name, name_length);
+  var->name = (char*) (var + 1);
+  var->name_length = name_length;
+  var->value = var->name + name_length + 1;
+  var->value_length = value_length;
+  /* The name keeps the case it was first defined with */
+  memcpy(var->name, old ? old->name : name, name_length);
+  var->name[name_length] = '\0';
+  memcpy(var->value, value, value_length);
+  var->value[value_length] = '\0';
+  if (old)
+    my_hash_delete(&global_define_hash, (uchar*) old);
+  if (my_hash_insert(&global_define_hash, (uchar*) var))
+    my_free(var);
 }
+
 static void get_input_str(String *varkey, String *varval, int defcount){
   char buf[MAX_DEFINE_SIZE] = { 0 };
-  std::map<void*, void*>::iterator iter;
-  //find from map_global
+  DEFINE_VAR *var;
   varval->length(0);
-  for(iter = global_define_map.begin(); iter != global_define_map.end(); iter++){
-    if (strlen((char*)(iter->first)) == varkey->length() && 0 == strncasecmp((char*)iter->first, varkey->c_ptr_safe(), varkey->length())) {
-      varval->append((char*)iter->second, strlen((char*)iter->second));
-      return;
-    }
+  if ((var = find_define_var(varkey->ptr(), varkey->length()))) {
+    varval->append(var->value, var->value_length);
+    return;
   }
 
   tee_fprintf(stdout, "Please input %s val:  ", varkey->c_ptr_safe());
@@ -7792,76 +11828,44 @@ static void get_input_str(String *varkey, String *varval, int defcount){
   tee_outfile(buf);
   tee_outfile("\n");
   varval->append(buf);
-  if (defcount>1){
-    void *key = my_malloc(strlen(varkey->c_ptr_safe())+1, MYF(MY_WME));
-    void *val = my_malloc(strlen(varval->c_ptr_safe())+1, MYF(MY_WME));
-    if (key != NULL && val != NULL){
-      strcpy((char*)key, varkey->c_ptr_safe());
-      strcpy((char*)val, varval->c_ptr_safe());
-      global_define_map[key] = val;
-    } else {
-      my_free(key); my_free(val);
-    }
-  }
+  if (defcount>1)
+    set_define_var(varkey->ptr(), varkey->length(),
+                   varval->ptr(), varval->length());
 }
 static void set_key_value(const char *strkey, const char *strval) {
-  std::map<void*, void*>::iterator iter;
   if (strkey && strval) {
-    int vallen = strlen(strval);
-    int keylen = strlen(strkey);
-    if (keylen > 0 && vallen > 0) {
-      //find key
-      for (iter = global_define_map.begin(); iter != global_define_map.end(); iter++) {
-        if (strlen((char*)(iter->first)) == keylen && 0 == strncasecmp((char*)iter->first, strkey, keylen)) {
-          void *val = my_malloc(vallen + 1, MYF(MY_WME));
-          if (val) {
-            strcpy((char*)val, strval);
-            my_free(iter->second);
-            iter->second = val;
-          }
-          return;
-        }
-      }
-
-      // not exist global_define_map
-      {
-        void *key = my_malloc(keylen + 1, MYF(MY_WME));
-        void *val = my_malloc(vallen + 1, MYF(MY_WME));
-        if (key != NULL && val != NULL) {
-          strcpy((char*)key, strkey);
-          strcpy((char*)val, strval);
-          global_define_map[key] = val;
-        } else {
-          my_free(key); my_free(val);
-        }
-      }
-    }
+    size_t vallen = strlen(strval);
+    size_t keylen = strlen(strkey);
+    if (keylen > 0 && vallen > 0)
+      set_define_var(strkey, keylen, strval, vallen);
   }
 }
 static void display_key_value() {
   char buf[MAX_DEFINE_SIZE] = { 0 };
-  std::map<void*, void*>::iterator iter;
-  for (iter = global_define_map.begin(); iter != global_define_map.end(); iter++) {
-    snprintf(buf, MAX_DEFINE_SIZE, "DEFINE %s     = %s", (char*)(iter->first), (char*)(iter->second));
+  for (ulong i = 0; i < global_define_hash.records; i++) {
+    DEFINE_VAR *var = (DEFINE_VAR*) my_hash_element(&global_define_hash, i);
+    snprintf(buf, MAX_DEFINE_SIZE, "DEFINE %s     = %s", var->name, var->value);
     put_info(buf, INFO_INFO);
   }
 }
 static void free_global_define_map(){
-  std::map<void*, void*>::iterator iter;
-  for (iter = global_define_map.begin(); iter != global_define_map.end(); iter++) {
-    my_free(iter->first);
-    my_free(iter->second);
-  }
-  global_define_map.clear();
+  my_hash_free(&global_define_hash);
 }
 static my_bool scan_define_oracle(String *buffer, int display){
   int line_idx = 1, def_count = 0;
-  char *p = buffer->c_ptr_safe();
+  char *p;
   my_bool is_scan = 0;
   my_bool in_string = 0;
-  String endstr1, endstr2, endstr3, old_line, new_line, var_key, var_value;
+  String old_line, new_line, var_key, var_value;
   String newbuffer;
-  get_end_str(define_char_oracle, &endstr1, &endstr2, &endstr3);
+
+  /* Most statements have no define character and are left as they are */
+  if (!memchr(buffer->ptr(), define_char_oracle, buffer->length()))
+    return 0;
+
+  p = buffer->c_ptr_safe();
+  init_define_end_class(define_char_oracle);
+  newbuffer.alloc(buffer->length() + 1);
   
   //check define char to end
   while (*p != '\0'){
@@ -7874,7 +11878,7 @@ static my_bool scan_define_oracle(String *buffer, int display){
       my_bool have_space = 0;
       char *start = NULL; //var address
       char *ptmp = p;
-      while(*p != '\0' && (my_isspace(charset_info, *p) || NULL != strchr(endstr1.c_ptr_safe(), *p) || *p==define_char_oracle)){
+      while(*p != '\0' && (my_isspace(charset_info, *p) || (define_end_class[(uchar) *p] & DEFINE_END) || *p==define_char_oracle)){
         if (*p == define_char_oracle) {  //second define
           if (have_space == 1) {
             def_count = 0;
@@ -7885,11 +11889,11 @@ static my_bool scan_define_oracle(String *buffer, int display){
           }
           have_space = 0;
           def_count++;
-        } else if (NULL != strchr(endstr2.c_ptr_safe(), *p)) {
+        } else if (define_end_class[(uchar) *p] & DEFINE_SEPARATOR) {
           my_bool have_note = 0;
           have_space = 1;
-          while (*p != '\0' && NULL != strchr(endstr2.c_ptr_safe(), *p)) {
-            if (NULL != strchr(endstr3.c_ptr_safe(), *p)) {
+          while (*p != '\0' && (define_end_class[(uchar) *p] & DEFINE_SEPARATOR)) {
+            if (define_end_class[(uchar) *p] & DEFINE_NOTE) {
               have_note = 1;
             }
             p++;
@@ -7935,8 +11939,7 @@ static my_bool scan_define_oracle(String *buffer, int display){
 
       start = p;
       while(*p!='\0' && def_count != 0){
-        char* p1 = strchr(endstr1.c_ptr_safe(), *p); //define end
-        if (p1 != NULL)
+        if (define_end_class[(uchar) *p] & DEFINE_END) //define end
           break;
         old_line.append_char(*p++);
       }
@@ -7985,8 +11988,7 @@ static my_bool scan_define_oracle(String *buffer, int display){
       p++;
   }
 
-  buffer->length(0);
-  buffer->append(newbuffer);
+  buffer->swap(newbuffer);
   return 1;
 }
 
@@ -8268,8 +12270,87 @@ static int handle_oracle_sql(MYSQL *mysql, String *buffer) {
   return ret;
 }
 
+/*
+  Write the output lines fetched by call_dbms_get_lines(), NUL bytes
+  printed as spaces like in call_dbms_get_line()
+*/
+static void put_dbms_lines(char *lines, ulong length, my_bool add_newline) {
+  char *nul;
+  for (char *p = lines; (nul = (char*)memchr(p, 0, lines + length - p)); p = nul + 1)
+    *nul = ' ';
+  tee_write(lines, length, stdout);
+  if (add_newline)
+    tee_write("\n", 1, stdout);
+}
+
+/*
+  Fetch DBMS_OUTPUT with one round trip per batch of lines instead of
+  one per line. The batch grows while the buffer has more lines, so a
+  block that prints a few lines costs one small call.
+
+  Returns 1 if the server can't run the batch call, for the caller to
+  fall back to GET_LINE.
+*/
+static my_bool call_dbms_get_lines(MYSQL *mysql, uint error){
+  FILE *save_buffer_file = tee_buffer_file;
+  uint inner_error = 0;
+
+  if (NULL == dbms_lines_stmt) {
+    if (!(dbms_lines_stmt = mysql_stmt_init(mysql)) ||
+        mysql_stmt_prepare(dbms_lines_stmt, dbms_get_lines, strlen(dbms_get_lines)) ||
+        mysql_stmt_bind_param(dbms_lines_stmt, dbms_lines_params)) {
+      if (dbms_lines_stmt) {
+        mysql_stmt_close(dbms_lines_stmt);
+        dbms_lines_stmt = NULL;
+      }
+      dbms_lines_unsupported = 1;
+      return 1;
+    }
+  }
+
+  /* Collect the lines in the tee buffer and write them in large blocks */
+  tee_flush();
+  tee_buffer_file = stdout;
+  dbms_lines_max = DBMS_LINES_MIN;
+  do {
+    if (mysql_stmt_execute(dbms_lines_stmt) ||
+        mysql_stmt_store_result(dbms_lines_stmt) ||
+        mysql_stmt_bind_result(dbms_lines_stmt, dbms_lines_bind) ||
+        mysql_stmt_fetch(dbms_lines_stmt)) {
+      if (!dbms_lines_checked) {
+        /* Nothing was taken off the buffer, let GET_LINE do it */
+        mysql_stmt_close(dbms_lines_stmt);
+        dbms_lines_stmt = NULL;
+        dbms_lines_unsupported = 1;
+        tee_buffer_file = save_buffer_file;
+        return 1;
+      }
+      inner_error = put_stmt_error(mysql, dbms_lines_stmt);
+      break;
+    }
+    dbms_lines_checked = 1;
+    if (!error) {
+      if (!dbms_lines_bind[0].is_null_value)
+        put_dbms_lines(dbms_lines_buffer[0], dbms_lines_bind[0].length_value, 0);
+      if (!dbms_lines_bind[1].is_null_value)
+        put_dbms_lines(dbms_lines_buffer[1], dbms_lines_bind[1].length_value, 1);
+    }
+    mysql_stmt_free_result(dbms_lines_stmt);
+    if (mysql_stmt_more_results(dbms_lines_stmt)) { // for ob3.2.3.3 skip ok package
+      mysql_stmt_next_result(dbms_lines_stmt);
+    }
+    if (dbms_lines_count == dbms_lines_max && dbms_lines_max < DBMS_LINES_MAX)
+      dbms_lines_max *= 2;
+  } while (!inner_error && dbms_lines_status == 0);
+  tee_flush();
+  tee_buffer_file = save_buffer_file;
+  return 0;
+}
+
 static void call_dbms_get_line(MYSQL *mysql, uint error){
   uint inner_error = 0;
+  if (!dbms_lines_unsupported && !call_dbms_get_lines(mysql, error))
+    return;
   do {
     if (NULL == dbms_stmt && !(dbms_stmt = mysql_stmt_init(mysql))) {
       inner_error = put_error(mysql);
@@ -8361,7 +12442,7 @@ static bool execute_cmd(String &buffer) {
   String tmpbuf;
   tmpbuf.append(buffer);
   if (NULL != (com = find_command(tmpbuf.c_ptr()))) {
-    if ((*com->func)(&buffer, com->cmdstr) > 0)
+    if (pack_flush() > 0 || (*com->func)(&buffer, com->cmdstr) > 0)
       return 1;                       // Quit 
   } else {
     if (com_go(&buffer, 0) > 0)             // < 0 is not fatal
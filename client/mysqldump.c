@@ -51,6 +51,8 @@
 #include <stdarg.h>
 
 #include "client_priv.h"
+#include "row_encoder.h"
+#include "compressed_output.h"
 #include "mysql.h"
 #include "mysql_version.h"
 #include "mysqld_error.h"
@@ -166,12 +168,64 @@ static int   first_error=0;
   SHOW ALL SLAVES STATUS.
 */
 static uint multi_source= 0;
-static DYNAMIC_STRING extended_row;
+static DYNAMIC_STRING row_block;
 static DYNAMIC_STRING dynamic_where;
 static MYSQL_RES *get_table_name_result= NULL;
 static MEM_ROOT glob_root;
 static MYSQL_RES *routine_res, *routine_list_res;
 
+/*
+  --parallel: the data of a table, read by a worker connection into a
+  temporary file and copied to the dump in the original table order.
+*/
+typedef struct st_dump_job
+{
+  char *db, *table;
+  char *result_table;                   /* quoted, for messages */
+  char *quoted_table;                   /* quoted, for LOCK TABLES & co. */
+  char *query;                          /* SELECT reading the rows */
+  char *insert_pat;                     /* INSERT statement head */
+  uint num_fields;
+  uint seq;                             /* position in the dump */
+  uint chunk, chunks;                   /* key range; 0 chunks: all rows */
+  ulonglong size;                       /* data_length, read largest first */
+  my_bool triggers;                     /* dump triggers after the data */
+  my_bool done;
+  int error;
+  FILE *file;
+  char file_name[FN_REFLEN];
+  char message[512];                    /* error, printed by the main thread */
+} DUMP_JOB;
+
+typedef struct st_dump_worker
+{
+  MYSQL mysql;
+  pthread_t thread;
+  DYNAMIC_STRING row;                   /* INSERT statements being built */
+  DUMP_JOB *job;                        /* running job, for KILL QUERY */
+  char db[NAME_LEN + 1];                /* current database */
+} DUMP_WORKER;
+
+#define MAX_CHUNKS 4096                 /* per table */
+#define CHUNK_SAMPLES 16                /* sampled keys per chunk */
+#define ROW_BLOCK_SIZE (1024*1024)      /* INSERT statements written at once */
+static uint opt_parallel= 0;
+static ulonglong opt_chunk_rows= 0, opt_chunk_bytes= 0;
+static char *opt_compress_output= 0;
+static uint opt_compress_threads= 4;
+static COMPRESS_OPTIONS compress_opts;
+static char sql_file_ext[8]= ".sql";
+static DUMP_WORKER *dump_workers= 0;
+static uint dump_worker_count= 0;        /* connected */
+static uint dump_worker_threads= 0;      /* started */
+static DYNAMIC_ARRAY dump_jobs;         /* DUMP_JOB*, in dump order */
+static MEM_ROOT dump_job_root;
+static DUMP_JOB **dump_order, *queued_job;
+static uint dump_next, dump_count;
+static my_bool dump_stop;
+static pthread_mutex_t dump_mutex;
+static pthread_cond_t dump_work, dump_done;
+
 
 #include <sslopt-vars.h>
 FILE *md_result_file= 0;
@@ -268,6 +322,21 @@ static struct my_option my_long_options[] =
   {"character-sets-dir", OPT_CHARSETS_DIR,
    "Directory for character set files.", (char **)&charsets_dir,
    (char **)&charsets_dir, 0, GET_STR, REQUIRED_ARG, 0, 0, 0, 0, 0, 0},
+  {"chunk-bytes", OPT_CHUNK_BYTES,
+   "With --parallel, split the data of tables larger than this into ranges "
+   "of the primary key, dumped as separate chunks. The number of chunks "
+   "comes from the estimated row count and average row length.",
+   &opt_chunk_bytes, &opt_chunk_bytes, 0, GET_ULL, REQUIRED_ARG,
+   0, 0, ULONGLONG_MAX, 0, 1024, 0},
+  {"chunk-rows", OPT_CHUNK_ROWS,
+   "With --parallel, split the data of tables with more rows than this into "
+   "ranges of the primary key, dumped as separate chunks. An integer key "
+   "is split evenly between its minimum and maximum; for other keys the "
+   "boundaries come from a sample of the keys, so chunk sizes are only "
+   "about equal. Each chunk locks the table, disables keys and commits on "
+   "its own, so chunks can be restored in any order.",
+   &opt_chunk_rows, &opt_chunk_rows, 0, GET_ULL, REQUIRED_ARG,
+   0, 0, ULONGLONG_MAX, 0, 1, 0},
   {"comments", 'i', "Write additional information.",
    &opt_comments, &opt_comments, 0, GET_BOOL, NO_ARG,
    1, 0, 0, 0, 0, 0},
@@ -295,6 +364,17 @@ static struct my_option my_long_options[] =
   {"compress", 'C', "Use compression in server/client protocol.",
    &opt_compress, &opt_compress, 0, GET_BOOL, NO_ARG, 0, 0, 0,
    0, 0, 0},
+  {"compress-output", OPT_COMPRESS_OUTPUT,
+   "Compress the dump, or with --tab the .sql files, with gzip or zstd, "
+   "optionally followed by :level, e.g. zstd:6. The output is cut into "
+   "frames compressed independently, each starting with its sizes, so "
+   "that they can be decompressed in parallel.",
+   &opt_compress_output, &opt_compress_output, 0, GET_STR, REQUIRED_ARG,
+   0, 0, 0, 0, 0, 0},
+  {"compress-threads", OPT_COMPRESS_THREADS,
+   "Number of threads compressing for --compress-output.",
+   &opt_compress_threads, &opt_compress_threads, 0, GET_UINT, REQUIRED_ARG,
+   4, 1, 256, 0, 1, 0},
   {"create-options", 'a',
    "Include all MariaDB specific create options.",
    &create_options, &create_options, 0, GET_BOOL, NO_ARG, 1,
@@ -486,6 +566,14 @@ static struct my_option my_long_options[] =
   {"order-by-primary", OPT_ORDER_BY_PRIMARY,
    "Sorts each table's rows by primary key, or first unique key, if such a key exists.  Useful when dumping a MyISAM table to be loaded into an InnoDB table, but will make the dump itself take considerably longer.",
    &opt_order_by_primary, &opt_order_by_primary, 0, GET_BOOL, NO_ARG, 0, 0, 0, 0, 0, 0},
+  {"parallel", OPT_PARALLEL,
+   "Read table data through this many additional connections sharing the "
+   "snapshot of --single-transaction, largest tables first. All table "
+   "definitions of a database are written before its data, which follows "
+   "in the usual table order together with the triggers. Not supported "
+   "by OceanBase, where FLUSH TABLES WITH READ LOCK does not stop commits "
+   "and the connections could not be given the same snapshot. 0 disables.",
+   &opt_parallel, &opt_parallel, 0, GET_UINT, REQUIRED_ARG, 0, 0, 256, 0, 1, 0},
   {"password", 'p',
    "Password to use when connecting to server. If password is not given it's solicited on the tty.",
    0, 0, 0, GET_STR, OPT_ARG, 0, 0, 0, 0, 0, 0},
@@ -610,7 +698,8 @@ static int dump_all_stats();
 static int dump_all_timezones();
 static char *quote_name(const char *name, char *buff, my_bool force);
 char check_if_ignore_table(const char *table_name, char *table_type);
-static char *primary_key_fields(const char *table_name);
+static char *primary_key_fields(const char *table_name,
+                                my_bool primary_only);
 static my_bool get_view_structure(char *table, char* db);
 static my_bool dump_all_views_in_db(char *database);
 static int dump_all_tablespaces();
@@ -618,6 +707,9 @@ static int dump_tablespaces_for_tables(char *db, char **table_names, int tables)
 static int dump_tablespaces_for_databases(char** databases);
 static int dump_tablespaces(char* ts_where);
 static void print_comment(FILE *, my_bool, const char *, ...);
+static int start_transaction(MYSQL *mysql_con);
+static int run_init_sql(MYSQL *mysql_con);
+static void dump_workers_end(my_bool abort);
 
 /*
   Print the supplied message if in verbose mode
@@ -1183,6 +1275,18 @@ static int get_options(int *argc, char ***argv)
   }
   if (opt_single_transaction || opt_lock_all_tables)
     lock_tables= 0;
+  if (opt_parallel && (!opt_single_transaction || path || opt_xml))
+  {
+    fprintf(stderr, "%s: --parallel needs --single-transaction and can't be "
+            "used with --tab or --xml.\n", my_progname_short);
+    return(EX_USAGE);
+  }
+  if ((opt_chunk_rows || opt_chunk_bytes) && !opt_parallel)
+  {
+    fprintf(stderr, "%s: --chunk-rows and --chunk-bytes need --parallel.\n",
+            my_progname_short);
+    return(EX_USAGE);
+  }
   if (enclosed && opt_enclosed)
   {
     fprintf(stderr, "%s: You can't use ..enclosed.. and ..optionally-enclosed.. at the same time.\n", my_progname_short);
@@ -1211,6 +1315,26 @@ static int get_options(int *argc, char ***argv)
     short_usage(stderr);
     return EX_USAGE;
   }
+  if (opt_compress_output)
+  {
+    const char *error;
+    if ((error= compress_options_parse(&compress_opts, opt_compress_output)))
+    {
+      fprintf(stderr, "%s: --compress-output=%s: %s.\n", my_progname_short,
+              opt_compress_output, error);
+      return(EX_USAGE);
+    }
+    compress_opts.threads= opt_compress_threads;
+    strxmov(sql_file_ext, ".sql", compress_extension(&compress_opts), NullS);
+    if (compress_threads_start(&compress_opts) ||
+        !(md_result_file= compressed_output_open(md_result_file,
+                                                 md_result_file != stdout)))
+    {
+      fprintf(stderr, "%s: Couldn't start the compressed output.\n",
+              my_progname_short);
+      return(EX_EOM);
+    }
+  }
   if (tty_password)
     opt_password=get_tty_password(NullS);
   return(0);
@@ -1759,22 +1883,45 @@ static char *cover_definer_clause(const char *stmt_str,
   RETURN VALUES
     0        Failed to open file
     > 0      Handle of the open file
+
+  NOTE
+    With --compress-output the file is named .sql.gz or .sql.zst, and
+    the handle is the compressed stream, to be closed by close_sql_file().
 */
 static FILE* open_sql_file_for_table(const char* table, int flags)
 {
-  FILE* res;
+  FILE* res, *stream;
   char filename[FN_REFLEN], tmp_path[FN_REFLEN];
   convert_dirname(tmp_path,path,NullS);
-  res= my_fopen(fn_format(filename, table, tmp_path, ".sql", 4),
+  if (compress_opts.method != COMPRESS_NONE)
+    flags|= FILE_BINARY;
+  res= my_fopen(fn_format(filename, table, tmp_path, sql_file_ext, 4),
                 flags, MYF(MY_WME));
+  if (res && compress_opts.method != COMPRESS_NONE)
+  {
+    if (!(stream= compressed_output_open(res, TRUE)))
+      my_fclose(res, MYF(0));
+    res= stream;
+  }
   return res;
 }
 
 
+static int close_sql_file(FILE *file, myf flags)
+{
+  if (compress_opts.method != COMPRESS_NONE)
+    return compressed_output_close(file);
+  return my_fclose(file, flags);
+}
+
+
 static void free_resources()
 {
+  /* Don't exit under running workers, nor leave their files behind */
+  dump_workers_end(TRUE);
   if (md_result_file && md_result_file != stdout)
-    my_fclose(md_result_file, MYF(0));
+    close_sql_file(md_result_file, MYF(0));
+  compress_threads_end();
   if (get_table_name_result)
     mysql_free_result(get_table_name_result);
   if (routine_res)
@@ -1796,7 +1943,7 @@ static void free_resources()
     my_hash_free(&ignore_table);
   if (my_hash_inited(&ignore_data))
     my_hash_free(&ignore_data);
-  dynstr_free(&extended_row);
+  dynstr_free(&row_block);
   dynstr_free(&dynamic_where);
   dynstr_free(&insert_pat);
   dynstr_free(&select_field_names);
@@ -1822,33 +1969,33 @@ static void maybe_exit(int error)
 
 
 /*
-  db_connect -- connects to the host and selects DB.
+  Open a connection with the settings and session state that every
+  connection of the dump uses.
 */
 
-static int connect_to_db(char *host, char *user,char *passwd)
+static int connect_session(MYSQL *con, char *host, char *user, char *passwd)
 {
   char buff[20+FN_REFLEN];
   my_bool reconnect;
-  DBUG_ENTER("connect_to_db");
+  DBUG_ENTER("connect_session");
 
-  verbose_msg("-- Connecting to %s...\n", host ? host : "localhost");
-  mysql_init(&mysql_connection);
+  mysql_init(con);
   if (opt_compress)
-    mysql_options(&mysql_connection,MYSQL_OPT_COMPRESS,NullS);
+    mysql_options(con,MYSQL_OPT_COMPRESS,NullS);
 #ifdef HAVE_OPENSSL
   if (opt_use_ssl)
   {
-    mysql_ssl_set(&mysql_connection, opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
+    mysql_ssl_set(con, opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
                   opt_ssl_capath, opt_ssl_cipher);
-    mysql_options(&mysql_connection, MYSQL_OPT_SSL_CRL, opt_ssl_crl);
-    mysql_options(&mysql_connection, MYSQL_OPT_SSL_CRLPATH, opt_ssl_crlpath);
-    mysql_options(&mysql_connection, MARIADB_OPT_TLS_VERSION, opt_tls_version);
+    mysql_options(con, MYSQL_OPT_SSL_CRL, opt_ssl_crl);
+    mysql_options(con, MYSQL_OPT_SSL_CRLPATH, opt_ssl_crlpath);
+    mysql_options(con, MARIADB_OPT_TLS_VERSION, opt_tls_version);
   }
-  mysql_options(&mysql_connection,MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
+  mysql_options(con,MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
                 (char*)&opt_ssl_verify_server_cert);
 #endif
   if (opt_protocol)
-    mysql_options(&mysql_connection,MYSQL_OPT_PROTOCOL,(char*)&opt_protocol);
+    mysql_options(con,MYSQL_OPT_PROTOCOL,(char*)&opt_protocol);
 
   if (strncasecmp(default_charset, "GB18030-2022", 12) == 0) {
     default_charset = (char*)"GB18030";
@@ -1857,42 +2004,32 @@ static int connect_to_db(char *host, char *user,char *passwd)
     strncasecmp(default_charset, "BIG5HKSCS", 9) == 0) {
     default_charset = (char*)"big5";
   }
-  mysql_options(&mysql_connection, MYSQL_SET_CHARSET_NAME, default_charset);
+  mysql_options(con, MYSQL_SET_CHARSET_NAME, default_charset);
 
   if (opt_plugin_dir && *opt_plugin_dir)
-    mysql_options(&mysql_connection, MYSQL_PLUGIN_DIR, opt_plugin_dir);
+    mysql_options(con, MYSQL_PLUGIN_DIR, opt_plugin_dir);
 
   if (opt_default_auth && *opt_default_auth)
-    mysql_options(&mysql_connection, MYSQL_DEFAULT_AUTH, opt_default_auth);
+    mysql_options(con, MYSQL_DEFAULT_AUTH, opt_default_auth);
 
-  mysql_options(&mysql_connection, MYSQL_OPT_CONNECT_ATTR_RESET, 0);
-  mysql_options4(&mysql_connection, MYSQL_OPT_CONNECT_ATTR_ADD,
+  mysql_options(con, MYSQL_OPT_CONNECT_ATTR_RESET, 0);
+  mysql_options4(con, MYSQL_OPT_CONNECT_ATTR_ADD,
                  "program_name", "mysqldump");
-  mysql= &mysql_connection;          /* So we can mysql_close() it properly */
-  if (!mysql_real_connect(&mysql_connection,host,user,passwd,
+  if (!mysql_real_connect(con,host,user,passwd,
                           NULL,opt_mysql_port,opt_mysql_unix_port, 0))
   {
-    DB_error(&mysql_connection, "when trying to connect");
+    DB_error(con, "when trying to connect");
     DBUG_RETURN(1);
   }
-  if ((mysql_get_server_version(&mysql_connection) < 40100) ||
-      (opt_compatible_mode & 3))
-  {
-    /* Don't dump SET NAMES with a pre-4.1 server (bug#7997).  */
-    opt_set_charset= 0;
-
-    /* Don't switch charsets for 4.1 and earlier.  (bug#34192). */
-    server_supports_switching_charsets= FALSE;
-  } 
   /*
     As we're going to set SQL_MODE, it would be lost on reconnect, so we
     cannot reconnect.
   */
   reconnect= 0;
-  mysql_options(&mysql_connection, MYSQL_OPT_RECONNECT, &reconnect);
+  mysql_options(con, MYSQL_OPT_RECONNECT, &reconnect);
   my_snprintf(buff, sizeof(buff), "/*!40100 SET @@SQL_MODE='%s' */",
               compatible_mode_normal_str);
-  if (mysql_query_with_error_report(mysql, 0, buff))
+  if (mysql_query_with_error_report(con, 0, buff))
     DBUG_RETURN(1);
   /*
     set time_zone to UTC to allow dumping date types between servers with
@@ -1901,10 +2038,35 @@ static int connect_to_db(char *host, char *user,char *passwd)
   if (opt_tz_utc)
   {
     my_snprintf(buff, sizeof(buff), "/*!40103 SET TIME_ZONE='+00:00' */");
-    if (mysql_query_with_error_report(mysql, 0, buff))
+    if (mysql_query_with_error_report(con, 0, buff))
       DBUG_RETURN(1);
   }
   DBUG_RETURN(0);
+} /* connect_session */
+
+
+/*
+  db_connect -- connects to the host and selects DB.
+*/
+
+static int connect_to_db(char *host, char *user,char *passwd)
+{
+  DBUG_ENTER("connect_to_db");
+
+  verbose_msg("-- Connecting to %s...\n", host ? host : "localhost");
+  mysql= &mysql_connection;          /* So we can mysql_close() it properly */
+  if (connect_session(&mysql_connection, host, user, passwd))
+    DBUG_RETURN(1);
+  if ((mysql_get_server_version(&mysql_connection) < 40100) ||
+      (opt_compatible_mode & 3))
+  {
+    /* Don't dump SET NAMES with a pre-4.1 server (bug#7997).  */
+    opt_set_charset= 0;
+
+    /* Don't switch charsets for 4.1 and earlier.  (bug#34192). */
+    server_supports_switching_charsets= FALSE;
+  } 
+  DBUG_RETURN(0);
 } /* connect_to_db */
 
 
@@ -2058,6 +2220,9 @@ static char *quote_for_equal(const char *name, char *buff)
 
   @description
     Quote '<' '>' '&' '\"' chars and print a string to the xml_file.
+    Write errors are left to the caller to check, as this, like
+    print_xml_tag(), print_xml_null_tag() and print_blob_as_hex(), also
+    writes the rows of the --parallel workers.
 */
 
 static void print_quoted_xml(FILE *xml_file, const char *str, size_t len,
@@ -2093,7 +2258,6 @@ static void print_quoted_xml(FILE *xml_file, const char *str, size_t len,
       break;
     }
   }
-  check_io(xml_file);
 }
 
 
@@ -2157,7 +2321,6 @@ static void print_xml_tag(FILE * xml_file, const char* sbeg,
 
   fputc('>', xml_file);
   fputs(line_end, xml_file);
-  check_io(xml_file);
 }
 
 
@@ -2191,7 +2354,6 @@ static void print_xml_null_tag(FILE * xml_file, const char* sbeg,
   print_quoted_xml(xml_file, sval, strlen(sval), 0);
   fputs("\" xsi:nil=\"true\" />", xml_file);
   fputs(line_end, xml_file);
-  check_io(xml_file);
 }
 
 
@@ -2616,10 +2778,15 @@ static uint dump_events_for_db(char *db)
 static void print_blob_as_hex(FILE *output_file, const char *str, ulong len)
 {
     /* sakaik got the idea to to provide blob's in hex notation. */
-    const char *ptr= str, *end= ptr + len;
-    for (; ptr < end ; ptr++)
-      fprintf(output_file, "%02X", *((uchar *)ptr));
-    check_io(output_file);
+    char buff[4096];
+    const uchar *ptr= (const uchar*) str, *end= ptr + len;
+    while (ptr < end)
+    {
+      size_t length= MY_MIN((size_t) (end - ptr), sizeof(buff) / 2);
+      fwrite(buff, 1, (size_t) (bin2hex(buff, ptr, length) - buff),
+             output_file);
+      ptr+= length;
+    }
 }
 
 /*
@@ -2989,7 +3156,7 @@ static uint get_table_structure(const char *table, const char *db, char *table_t
   opt_quoted_table= quote_name(table, table_buff2, 0);
 
   if (opt_order_by_primary)
-    order_by= primary_key_fields(result_table);
+    order_by= primary_key_fields(result_table, FALSE);
 
   if (!opt_xml && !mysql_query_with_error_report(mysql, 0, query_buff))
   {
@@ -3088,7 +3255,7 @@ static uint get_table_structure(const char *table, const char *db, char *table_t
           my_free(scv_buff);
 
           if (path)
-            my_fclose(sql_file, MYF(MY_WME));
+            close_sql_file(sql_file, MYF(MY_WME));
           DBUG_RETURN(0);
         }
         else
@@ -3168,7 +3335,7 @@ static uint get_table_structure(const char *table, const char *db, char *table_t
         mysql_free_result(result);
 
         if (path)
-          my_fclose(sql_file, MYF(MY_WME));
+          close_sql_file(sql_file, MYF(MY_WME));
 
         seen_views= 1;
         DBUG_RETURN(0);
@@ -3204,7 +3371,7 @@ static uint get_table_structure(const char *table, const char *db, char *table_t
     if (mysql_query_with_error_report(mysql, &result, query_buff))
     {
       if (path)
-        my_fclose(sql_file, MYF(MY_WME));
+        close_sql_file(sql_file, MYF(MY_WME));
       DBUG_RETURN(0);
     }
 
@@ -3386,7 +3553,7 @@ static uint get_table_structure(const char *table, const char *db, char *table_t
         fprintf(stderr, "%s: Can't get keys for table %s (%s)\n",
                 my_progname_short, result_table, mysql_error(mysql));
         if (path)
-          my_fclose(sql_file, MYF(MY_WME));
+          close_sql_file(sql_file, MYF(MY_WME));
         DBUG_RETURN(0);
       }
 
@@ -3505,7 +3672,7 @@ continue_xml:
   {
     fputs("\n", sql_file);
     write_footer(sql_file);
-    my_fclose(sql_file, MYF(MY_WME));
+    close_sql_file(sql_file, MYF(MY_WME));
   }
   DBUG_RETURN((uint) num_fields);
 } /* get_table_structure */
@@ -3720,8 +3887,11 @@ static int dump_triggers_for_table(char *table_name, char *db_name)
     goto skip;
 
   if (opt_xml)
+  {
     print_xml_tag(sql_file, "\t", "\n", "triggers", "name=",
                   table_name, NullS);
+    check_io(sql_file);
+  }
 
   while ((row= mysql_fetch_row(show_triggers_rs)))
   {
@@ -3771,7 +3941,7 @@ skip:
 
 done:
   if (path)
-    my_fclose(sql_file, MYF(0));
+    close_sql_file(sql_file, MYF(0));
 
   DBUG_RETURN(ret);
 }
@@ -3866,513 +4036,1285 @@ static char *alloc_query_str(size_t size)
 */
 
 
-static void dump_table(const char *table, const char *db, const uchar *hash_key, size_t len)
-{
-  char ignore_flag;
-  char buf[200], table_buff[NAME_LEN+3];
-  DYNAMIC_STRING query_string;
-  char table_type[NAME_LEN];
-  char *result_table, table_buff2[NAME_LEN*2+3], *opt_quoted_table;
-  int error= 0;
-  ulong         rownr, row_break;
-  uint num_fields;
-  size_t total_length, init_length;
-
-  MYSQL_RES     *res;
-  MYSQL_FIELD   *field;
-  MYSQL_ROW     row;
-  DBUG_ENTER("dump_table");
+/*
+  63 is my_charset_bin. If charsetnr is not 63,
+  we have not a BLOB but a TEXT column.
+  we'll dump in hex only BLOB columns.
+*/
 
-  /*
-    Check does table has a sequence structure and if has apply different sql queries
-  */
-  if (check_if_ignore_table(table, table_type) & IGNORE_SEQUENCE_TABLE)
-  {
-    get_sequence_structure(table, db);
-    DBUG_VOID_RETURN;
-  }
-  /*
-    Make sure you get the create table info before the following check for
-    --no-data flag below. Otherwise, the create table info won't be printed.
-  */
-  num_fields= get_table_structure(table, db, table_type, &ignore_flag);
+static my_bool is_hex_blob(const MYSQL_FIELD *field)
+{
+  return (opt_hex_blob && field->charsetnr == 63 &&
+          (field->type == MYSQL_TYPE_BIT ||
+           field->type == MYSQL_TYPE_STRING ||
+           field->type == MYSQL_TYPE_VAR_STRING ||
+           field->type == MYSQL_TYPE_OB_NVARCHAR2 ||
+           field->type == MYSQL_TYPE_OB_NCHAR ||
+           field->type == MYSQL_TYPE_VARCHAR ||
+           field->type == MYSQL_TYPE_BLOB ||
+           field->type == MYSQL_TYPE_LONG_BLOB ||
+           field->type == MYSQL_TYPE_MEDIUM_BLOB ||
+           field->type == MYSQL_TYPE_TINY_BLOB ||
+           field->type == MYSQL_TYPE_GEOMETRY));
+}
 
-  /*
-    The "table" could be a view.  If so, we don't do anything here.
-  */
-  if (strcmp(table_type, "VIEW") == 0)
-    DBUG_VOID_RETURN;
 
-  /* Check --no-data flag */
-  if (opt_no_data || (hash_key && ignore_table_data(hash_key, len)))
-  {
-    verbose_msg("-- Skipping dump data for table '%s', --no-data was used\n",
-                table);
-    DBUG_VOID_RETURN;
-  }
+static size_t escape_for_insert(void *con, char *to, const char *from,
+                                size_t length)
+{
+  return mysql_real_escape_string((MYSQL*) con, to, from, (ulong) length);
+}
 
-  DBUG_PRINT("info",
-             ("ignore_flag: %x  num_fields: %d", (int) ignore_flag,
-              num_fields));
-  /*
-    If the table type is a merge table or any type that has to be
-     _completely_ ignored and no data dumped
-  */
-  if (ignore_flag & IGNORE_DATA)
-  {
-    verbose_msg("-- Warning: Skipping data for table '%s' because " \
-                "it's of type %s\n", table, table_type);
-    DBUG_VOID_RETURN;
-  }
-  /* Check that there are any fields in the table */
-  if (num_fields == 0)
-  {
-    verbose_msg("-- Skipping dump data for table '%s', it has no fields\n",
-                table);
-    DBUG_VOID_RETURN;
-  }
 
-  /*
-     Check --skip-events flag: it is not enough to skip creation of events
-     discarding SHOW CREATE EVENT statements generation. The myslq.event
-     table data should be skipped too.
-  */
-  if (!opt_events && !my_strcasecmp(&my_charset_latin1, db, "mysql") &&
-      !my_strcasecmp(&my_charset_latin1, table, "event"))
-  {
-    verbose_msg("-- Skipping data table mysql.event, --skip-events was used\n");
-    DBUG_VOID_RETURN;
-  }
+/*
+  The functions that write the rows of a table run in the --parallel
+  workers, so they don't die() on errors but leave the message in the
+  job and return an EX_ code.
+*/
 
-  result_table= quote_name(table,table_buff, 1);
-  opt_quoted_table= quote_name(table, table_buff2, 0);
+static int dump_job_failed(DUMP_JOB *job, int error)
+{
+  if (error == EX_EOM)
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Couldn't allocate memory\n", my_progname_short);
+  else
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Got errno %d on write\n", my_progname_short, errno);
+  return error;
+}
 
-  verbose_msg("-- Sending SELECT query...\n");
 
-  init_dynamic_string_checked(&query_string, "", 1024, 1024);
+static int write_block(FILE *out, DYNAMIC_STRING *block)
+{
+  fwrite(block->str, 1, block->length, out);
+  block->length= 0;
+  return ferror(out) ? EX_EOF : 0;
+}
 
-  if (path)
-  {
-    char filename[FN_REFLEN], tmp_path[FN_REFLEN];
 
-    /*
-      Convert the path to native os format
-      and resolve to the full filepath.
-    */
-    convert_dirname(tmp_path,path,NullS);    
-    my_load_path(tmp_path, tmp_path, NULL);
-    fn_format(filename, table, tmp_path, ".txt", MYF(MY_UNPACK_FILENAME));
+/*
+  Write the rows of a result as INSERT statements.
 
-    /* Must delete the file that 'INTO OUTFILE' will write to */
-    my_delete(filename, MYF(0));
+  DESCRIPTION
+    The statements are built in block, which is written out in pieces of
+    about ROW_BLOCK_SIZE bytes. For an extended INSERT a row is encoded
+    behind a ',' before knowing if it still fits in the statement; when
+    it does not, which happens once per statement, the row is moved to
+    make room for the head of the next one.
 
-    /* convert to a unix path name to stick into the query */
-    to_unix_path(filename);
+  RETURN
+    0 or an EX_ exit code; the number of rows is left in *rows
+*/
 
-    /* now build the query string */
+static int dump_rows_sql(MYSQL *con, MYSQL_RES *res, DUMP_JOB *job,
+                         DYNAMIC_STRING *block, ulong *rows)
+{
+  FILE *out= job->file;
+  ROW_ENCODER enc;
+  MYSQL_FIELD *fields= mysql_fetch_fields(res);
+  MYSQL_ROW row;
+  ulong rownr= 0;
+  my_bool row_break= 0;
+  size_t total_length= 0, insert_length= strlen(job->insert_pat);
+  size_t init_length= insert_length + 4;
+  int error= 0;
+  uint i;
 
-    dynstr_append_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ ");
-    dynstr_append_checked(&query_string, select_field_names.str);
-    dynstr_append_checked(&query_string, " INTO OUTFILE '");
-    dynstr_append_checked(&query_string, filename);
-    dynstr_append_checked(&query_string, "'");
+  *rows= 0;
+  if (row_encoder_init(&enc, mysql_num_fields(res), extended_insert,
+                       escape_for_insert, con))
+    return dump_job_failed(job, EX_EOM);
+  for (i= 0; i < enc.columns; i++)
+    row_encoder_column(&enc, i, fields + i, is_hex_blob(fields + i));
+  block->length= 0;
 
-    dynstr_append_checked(&query_string, " /*!50138 CHARACTER SET ");
-    dynstr_append_checked(&query_string, default_charset == mysql_universal_client_charset ?
-                                         my_charset_bin.name : /* backward compatibility */
-                                         default_charset);
-    dynstr_append_checked(&query_string, " */");
+  while ((row= mysql_fetch_row(res)))
+  {
+    ulong *lengths= mysql_fetch_lengths(res);
+    size_t mark= block->length, row_start, row_length;
+    rownr++;
 
-    if (fields_terminated || enclosed || opt_enclosed || escaped)
-      dynstr_append_checked(&query_string, " FIELDS");
-    
-    add_load_option(&query_string, " TERMINATED BY ", fields_terminated);
-    add_load_option(&query_string, " ENCLOSED BY ", enclosed);
-    add_load_option(&query_string, " OPTIONALLY ENCLOSED BY ", opt_enclosed);
-    add_load_option(&query_string, " ESCAPED BY ", escaped);
-    add_load_option(&query_string, " LINES TERMINATED BY ", lines_terminated);
+    // For large tables
+    if (0 == rownr % 100000) {
+      fprintf(stderr, "%lu rows dumpped for %s\n",
+        rownr, job->result_table);
+    }
 
-    dynstr_append_checked(&query_string, " FROM ");
-    dynstr_append_checked(&query_string, result_table);
+    if (extended_insert && row_break ?
+        dynstr_append_mem(block, ",", 1) :          /* Always row break */
+        dynstr_append_mem(block, job->insert_pat, insert_length))
+      goto oom;
+    row_start= block->length;
+    if (row_encode(&enc, block, row, lengths))
+      goto oom;
 
-    if (where)
+    row_length= 2 + block->length - row_start;
+    if (!extended_insert)
     {
-      dynstr_append_checked(&query_string, " WHERE ");
-      dynstr_append_checked(&query_string, where);
+      if (dynstr_append_mem(block, ");\n", 3))
+        goto oom;
     }
-
-    if (order_by)
+    else if (!row_break)
     {
-      dynstr_append_checked(&query_string, " ORDER BY ");
-      dynstr_append_checked(&query_string, order_by);
-      my_free(order_by);
-      order_by= 0;
+      row_break= 1;                             /* This is first row */
+      total_length= row_length + init_length;
     }
-
-    if (mysql_real_query(mysql, query_string.str, (ulong)query_string.length))
+    else if (total_length + row_length < opt_net_buffer_length)
+      total_length+= row_length;
+    else
     {
-      dynstr_free(&query_string);
-      DB_error(mysql, "when executing 'SELECT INTO OUTFILE'");
-      DBUG_VOID_RETURN;
+      /* Replace the ',' with the end of the statement and a new head */
+      size_t shift= insert_length + 1;
+      if (dynstr_realloc(block, shift))
+        goto oom;
+      memmove(block->str + row_start + shift, block->str + row_start,
+              block->length - row_start + 1);
+      memcpy(block->str + mark, ";\n", 2);
+      memcpy(block->str + mark + 2, job->insert_pat, insert_length);
+      block->length+= shift;
+      total_length= row_length + init_length;
+    }
+    if (block->length >= ROW_BLOCK_SIZE && write_block(out, block))
+    {
+      error= dump_job_failed(job, EX_EOF);
+      goto end;
     }
   }
-  else
-  {
-    print_comment(md_result_file, 0,
-                  "\n--\n-- Dumping data for table %s\n--\n",
-                  fix_for_comment(result_table));
-    
-    dynstr_append_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ ");
-    dynstr_append_checked(&query_string, select_field_names.str);
-    dynstr_append_checked(&query_string, " FROM ");
-    dynstr_append_checked(&query_string, result_table);
+  if (extended_insert && row_break &&
+      dynstr_append_mem(block, ";\n", 2))       /* If not empty table */
+    goto oom;
+  if (write_block(out, block))
+    error= dump_job_failed(job, EX_EOF);
+  goto end;
+
+oom:
+  error= dump_job_failed(job, EX_EOM);
+end:
+  row_encoder_free(&enc);
+  *rows= rownr;
+  return error;
+}
 
-    if (where)
-    {
-      print_comment(md_result_file, 0, "-- WHERE:  %s\n", fix_for_comment(where));
 
-      dynstr_append_checked(&query_string, " WHERE ");
-      dynstr_append_checked(&query_string, where);
-    }
-    if (order_by)
-    {
-      print_comment(md_result_file, 0, "-- ORDER BY:  %s\n", fix_for_comment(order_by));
+/*
+  Write the rows of a result as XML.
 
-      dynstr_append_checked(&query_string, " ORDER BY ");
-      dynstr_append_checked(&query_string, order_by);
-      my_free(order_by);
-      order_by= 0;
+  RETURN
+    0 or an EX_ exit code; the number of rows is left in *rows
+*/
+
+static int dump_rows_xml(MYSQL_RES *res, DUMP_JOB *job, ulong *rows)
+{
+  FILE *out= job->file;
+  MYSQL_FIELD *field;
+  MYSQL_ROW row;
+  ulong rownr= 0;
+
+  *rows= 0;
+  while ((row= mysql_fetch_row(res)))
+  {
+    uint i;
+    ulong *lengths= mysql_fetch_lengths(res);
+    *rows= ++rownr;
+
+    // For large tables
+    if (0 == rownr % 100000) {
+      fprintf(stderr, "%lu rows dumpped for %s\n",
+        rownr, job->result_table);
     }
 
-    if (!opt_xml && !opt_compact)
+    mysql_field_seek(res,0);
+    fputs("\t<row>\n", out);
+
+    for (i= 0; i < mysql_num_fields(res); i++)
     {
-      fputs("\n", md_result_file);
-      check_io(md_result_file);
+      ulong length= lengths[i];
+
+      if (!(field= mysql_fetch_field(res)))
+      {
+        my_snprintf(job->message, sizeof(job->message),
+                    "%s: Not enough fields from table %s! Aborting.\n",
+                    my_progname_short, job->result_table);
+        return EX_CONSCHECK;
+      }
+
+      if (row[i])
+      {
+        if (!(field->flags & NUM_FLAG))
+        {
+          if (is_hex_blob(field) && length)
+          {
+            /* Define xsi:type="xs:hexBinary" for hex encoded data */
+            print_xml_tag(out, "\t\t", "", "field", "name=",
+                          field->name, "xsi:type=", "xs:hexBinary", NullS);
+            print_blob_as_hex(out, row[i], length);
+          }
+          else
+          {
+            print_xml_tag(out, "\t\t", "", "field", "name=", 
+                          field->name, NullS);
+            print_quoted_xml(out, row[i], length, 0);
+          }
+          fputs("</field>\n", out);
+        }
+        else
+        {
+          /* change any strings ("inf", "-inf", "nan") into NULL */
+          char *ptr= row[i];
+          print_xml_tag(out, "\t\t", "", "field", "name=",
+                  field->name, NullS);
+          fputs(!my_isalpha(charset_info, *ptr) ? ptr: "NULL",
+                out);
+          fputs("</field>\n", out);
+        }
+      }
+      else
+        print_xml_null_tag(out, "\t\t", "field name=",
+                           field->name, "\n");
     }
-    if (mysql_query_with_error_report(mysql, 0, query_string.str))
+
+    fputs("\t</row>\n", out);
+    if (ferror(out))
+      return dump_job_failed(job, EX_EOF);
+  }
+  return 0;
+}
+
+
+/*
+  Write the rows of a table to job->file.
+
+  SYNOPSIS
+    dump_table_data()
+    con       connection to read the rows through
+    job       the table, the query and the output file
+    block     buffer for the INSERT statements
+
+  DESCRIPTION
+    With --parallel this runs in a worker thread, so it does not exit on
+    errors: the message is left in job->message for the caller to print.
+
+  RETURN
+    0 or an EX_ exit code
+*/
+
+static int dump_table_data(MYSQL *con, DUMP_JOB *job, DYNAMIC_STRING *block)
+{
+  FILE *out= job->file;
+  ulong rownr;
+  MYSQL_RES *res;
+  int error;
+  DBUG_ENTER("dump_table_data");
+
+  if (mysql_real_query(con, job->query, (ulong) strlen(job->query)) ||
+      !(res= quick ? mysql_use_result(con) : mysql_store_result(con)))
+  {
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Got error: %d: \"%s\" when retrieving data from server\n",
+                my_progname_short, mysql_errno(con), mysql_error(con));
+    DBUG_RETURN(EX_MYSQLERR);
+  }
+
+  verbose_msg("-- Retrieving rows...\n");
+  if (mysql_num_fields(res) != job->num_fields)
+  {
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Error in field count for table: %s !  Aborting.\n",
+                my_progname_short, job->result_table);
+    mysql_free_result(res);
+    DBUG_RETURN(EX_CONSCHECK);
+  }
+
+  if (opt_lock)
+    fprintf(out,"LOCK TABLES %s WRITE;\n", job->quoted_table);
+  /* Moved disable keys to after lock per bug 15977 */
+  if (opt_disable_keys)
+    fprintf(out, "/*!40000 ALTER TABLE %s DISABLE KEYS */;\n",
+	      job->quoted_table);
+
+  if (opt_xml)
+    print_xml_tag(out, "\t", "\n", "table_data", "name=", job->table,
+            NullS);
+  if (opt_autocommit)
+    fprintf(out, "set autocommit=0;\n");
+  if (ferror(out))
+  {
+    mysql_free_result(res);
+    DBUG_RETURN(dump_job_failed(job, EX_EOF));
+  }
+
+  error= opt_xml ? dump_rows_xml(res, job, &rownr) :
+                   dump_rows_sql(con, res, job, block, &rownr);
+  if (error)
+  {
+    mysql_free_result(res);
+    DBUG_RETURN(error);
+  }
+  if (opt_xml)
+    fputs("\t</table_data>\n", out);
+  if (mysql_errno(con))
+  {
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Error %d: %s when dumping table %s at row: %ld\n",
+                my_progname_short,
+                mysql_errno(con),
+                mysql_error(con),
+                job->result_table,
+                rownr);
+    mysql_free_result(res);
+    DBUG_RETURN(EX_CONSCHECK);
+  }
+
+  /* Moved enable keys to before unlock per bug 15977 */
+  if (opt_disable_keys)
+    fprintf(out,"/*!40000 ALTER TABLE %s ENABLE KEYS */;\n",
+            job->quoted_table);
+  if (opt_lock)
+    fputs("UNLOCK TABLES;\n", out);
+  if (opt_autocommit)
+    fprintf(out, "commit;\n");
+  mysql_free_result(res);
+  if (fflush(out) || ferror(out))
+    DBUG_RETURN(dump_job_failed(job, EX_EOF));
+  DBUG_RETURN(0);
+} /* dump_table_data */
+
+
+/*
+  --parallel: the main thread writes the table definitions and queues the
+  data of each table as a DUMP_JOB. At the end of a database the jobs are
+  handed to the workers, largest table first, and their output files are
+  copied to the dump in the original order, followed by the triggers.
+*/
+
+static uchar *get_job_key(DUMP_JOB *job, size_t *length,
+                          my_bool not_used __attribute__((unused)))
+{
+  *length= strlen(job->table);
+  return (uchar*) job->table;
+}
+
+
+static int dump_job_cmp(const void *a, const void *b)
+{
+  const DUMP_JOB *x= *(const DUMP_JOB**) a, *y= *(const DUMP_JOB**) b;
+  if (x->size != y->size)
+    return x->size < y->size ? 1 : -1;
+  return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+
+/*
+  Create the job for the data of a table, with an open output file for the
+  comments that precede the rows.
+*/
+
+static DUMP_JOB *dump_job_new(const char *db, const char *table,
+                              const char *result_table,
+                              const char *quoted_table)
+{
+  DUMP_JOB *job;
+  File fd;
+
+  if (!(job= (DUMP_JOB*) alloc_root(&dump_job_root, sizeof(DUMP_JOB))))
+    die(EX_EOM, "alloc_root failure.");
+  bzero((char*) job, sizeof(*job));
+  if (!(job->db= strdup_root(&dump_job_root, db)) ||
+      !(job->table= strdup_root(&dump_job_root, table)) ||
+      !(job->result_table= strdup_root(&dump_job_root, result_table)) ||
+      !(job->quoted_table= strdup_root(&dump_job_root, quoted_table)))
+    die(EX_EOM, "alloc_root failure.");
+
+  if ((fd= create_temp_file(job->file_name, NullS, "md", 0, MYF(MY_WME))) < 0)
+  {
+    maybe_die(EX_EOF, "Can't create a temporary file for table %s",
+              result_table);
+    return NULL;
+  }
+  if (!(job->file= my_fdopen(fd, job->file_name, O_WRONLY, MYF(MY_WME))))
+  {
+    my_close(fd, MYF(0));
+    my_delete(job->file_name, MYF(0));
+    maybe_die(EX_EOF, "Can't open %s", job->file_name);
+    return NULL;
+  }
+  job->seq= dump_jobs.elements;
+  if (insert_dynamic(&dump_jobs, (uchar*) &job))
+    die(EX_EOM, "Couldn't allocate memory");
+  return job;
+}
+
+
+/*
+  Complete a job with its query and close its file: the file is reopened
+  by the worker, so that only running jobs hold a descriptor.
+*/
+
+static void dump_job_queue(DUMP_JOB *job, const char *query, uint num_fields)
+{
+  if (!(job->query= strdup_root(&dump_job_root, query)) ||
+      !(job->insert_pat= strdup_root(&dump_job_root, insert_pat.str)))
+    die(EX_EOM, "alloc_root failure.");
+  job->num_fields= num_fields;
+  if (my_fclose(job->file, MYF(MY_WME)))
+    die(EX_EOF, "Got errno %d on write", my_errno);
+  job->file= NULL;
+  queued_job= job;
+}
+
+
+/*
+  Append the key of a row as a row constructor literal, for the range
+  predicates of the chunks.
+*/
+
+static void chunk_key_literal(DYNAMIC_STRING *str, MYSQL_RES *res,
+                              MYSQL_ROW row)
+{
+  ulong *lengths= mysql_fetch_lengths(res);
+  uint i;
+
+  dynstr_append_checked(str, "(");
+  for (i= 0; i < mysql_num_fields(res); i++)
+  {
+    MYSQL_FIELD *field= mysql_fetch_field_direct(res, i);
+
+    if (i)
+      dynstr_append_checked(str, ",");
+    if (!row[i])
+      dynstr_append_checked(str, "NULL");
+    else if (field->flags & NUM_FLAG)
+      dynstr_append_mem_checked(str, row[i], (uint) lengths[i]);
+    else if (field->charsetnr == 63 && lengths[i] &&
+             (field->type == MYSQL_TYPE_STRING ||
+              field->type == MYSQL_TYPE_VAR_STRING ||
+              field->type == MYSQL_TYPE_VARCHAR ||
+              field->type == MYSQL_TYPE_BLOB ||
+              field->type == MYSQL_TYPE_TINY_BLOB ||
+              field->type == MYSQL_TYPE_MEDIUM_BLOB ||
+              field->type == MYSQL_TYPE_LONG_BLOB))
     {
-      dynstr_free(&query_string);
-      DB_error(mysql, "when retrieving data from server");
-      goto err;
+      dynstr_realloc_checked(str, lengths[i] * 2 + 3);
+      dynstr_append_checked(str, "0x");
+      str->length+= mysql_hex_string(str->str + str->length, row[i],
+                                     lengths[i]);
+    }
+    else
+    {
+      dynstr_realloc_checked(str, lengths[i] * 2 + 3);
+      dynstr_append_checked(str, "'");
+      str->length+= mysql_real_escape_string(mysql, str->str + str->length,
+                                             row[i], lengths[i]);
+      str->str[str->length]= '\0';
+      dynstr_append_checked(str, "'");
+    }
+  }
+  dynstr_append_checked(str, ")");
+}
+
+
+/*
+  --chunk-rows, --chunk-bytes: queue the data of a large table as ranges of
+  its primary key, each read by a worker into a chunk of its own.
+
+  DESCRIPTION
+    The row count and average row length come from information_schema.
+    A single integer key is split evenly between its minimum and maximum.
+    For other keys about CHUNK_SAMPLES keys per chunk are sampled, with
+    the SAMPLE clause of OceanBase or else RAND(), and every
+    CHUNK_SAMPLES-th of them in key order starts a chunk. The sizes of
+    the chunks are then only about equal, but the key is not read in
+    full before the workers start.
+
+    Every chunk is labelled with its range and has the statements around
+    the rows of a whole table: LOCK TABLES, DISABLE KEYS and autocommit.
+    Chunks can so be restored in any order, and a failed one can be
+    dumped again with --where.
+
+  RETURN
+    0  the table is dumped as a whole
+    1  the chunks are queued
+*/
+
+static int dump_table_chunks(const char *db, const char *table,
+                             char *result_table, char *opt_quoted_table,
+                             uint num_fields)
+{
+  char buff[256 + FN_REFLEN], name_buff[FN_REFLEN];
+  ulonglong rows, avg_row_length, data_length, chunk_rows= ULONGLONG_MAX;
+  DYNAMIC_STRING query, bound;
+  DYNAMIC_ARRAY bounds;                 /* char*: first key of chunk 1.. */
+  MYSQL_RES *res;
+  MYSQL_ROW row;
+  MYSQL_FIELD *field;
+  char *key, **bound_list;
+  uint i, chunks;
+  DBUG_ENTER("dump_table_chunks");
+
+  my_snprintf(buff, sizeof(buff),
+              "SELECT table_rows, avg_row_length, data_length "
+              "FROM INFORMATION_SCHEMA.TABLES "
+              "WHERE table_schema = DATABASE() AND table_name = %s",
+              quote_for_equal(table, name_buff));
+  if (mysql_query(mysql, buff) || !(res= mysql_store_result(mysql)))
+  {
+    verbose_msg("-- Warning: Couldn't get the size of table %s (%s)\n",
+                result_table, mysql_error(mysql));
+    DBUG_RETURN(0);
+  }
+  row= mysql_fetch_row(res);
+  rows= row && row[0] ? strtoull(row[0], NULL, 10) : 0;
+  avg_row_length= row && row[1] ? strtoull(row[1], NULL, 10) : 0;
+  data_length= row && row[2] ? strtoull(row[2], NULL, 10) : 0;
+  mysql_free_result(res);
+
+  if (opt_chunk_rows)
+    chunk_rows= opt_chunk_rows;
+  if (opt_chunk_bytes && avg_row_length)
+    chunk_rows= MY_MIN(chunk_rows,
+                       MY_MAX(opt_chunk_bytes / avg_row_length, 1));
+  if (rows <= chunk_rows || !(key= primary_key_fields(result_table, TRUE)))
+    DBUG_RETURN(0);
+
+  init_dynamic_string_checked(&query, "", 256, 1024);
+  init_dynamic_string_checked(&bound, "", 256, 1024);
+  my_init_dynamic_array(&bounds, sizeof(char*), 64, 64, MYF(0));
+
+  /* The types of the key columns decide how to find the boundaries */
+  dynstr_append_checked(&query, "SELECT ");
+  dynstr_append_checked(&query, key);
+  dynstr_append_checked(&query, " FROM ");
+  dynstr_append_checked(&query, result_table);
+  dynstr_append_checked(&query, " LIMIT 0");
+  if (mysql_query(mysql, query.str) || !(res= mysql_store_result(mysql)))
+    goto end;
+  field= mysql_fetch_field_direct(res, 0);
+  if (mysql_num_fields(res) == 1 &&
+      (field->type == MYSQL_TYPE_TINY || field->type == MYSQL_TYPE_SHORT ||
+       field->type == MYSQL_TYPE_INT24 || field->type == MYSQL_TYPE_LONG ||
+       field->type == MYSQL_TYPE_LONGLONG))
+  {
+    my_bool is_unsigned= MY_TEST(field->flags & UNSIGNED_FLAG);
+    mysql_free_result(res);
+
+    dynstr_set_checked(&query, "SELECT MIN(");
+    dynstr_append_checked(&query, key);
+    dynstr_append_checked(&query, "), MAX(");
+    dynstr_append_checked(&query, key);
+    dynstr_append_checked(&query, ") FROM ");
+    dynstr_append_checked(&query, result_table);
+    if (mysql_query(mysql, query.str) || !(res= mysql_store_result(mysql)))
+      goto end;
+    if ((row= mysql_fetch_row(res)) && row[0] && row[1])
+    {
+      /* Unsigned arithmetic works for signed keys too */
+      ulonglong min= is_unsigned ? strtoull(row[0], NULL, 10) :
+                                   (ulonglong) strtoll(row[0], NULL, 10);
+      ulonglong max= is_unsigned ? strtoull(row[1], NULL, 10) :
+                                   (ulonglong) strtoll(row[1], NULL, 10);
+      ulonglong distance= max - min, offset= 0, step;
+
+      chunks= (uint) MY_MIN(rows / chunk_rows + 1, MAX_CHUNKS);
+      step= distance / chunks + 1;
+      while (distance - offset >= step)
+      {
+        char *value;
+        offset+= step;
+        if (is_unsigned)
+          my_snprintf(buff, sizeof(buff), "(%llu)", min + offset);
+        else
+          my_snprintf(buff, sizeof(buff), "(%lld)", (longlong) (min + offset));
+        if (!(value= strdup_root(&dump_job_root, buff)) ||
+            insert_dynamic(&bounds, (uchar*) &value))
+          die(EX_EOM, "Couldn't allocate memory");
+      }
+    }
+    mysql_free_result(res);
+  }
+  else
+  {
+    ulonglong samples, ppm, n;
+
+    mysql_free_result(res);
+    chunks= (uint) MY_MIN(rows / chunk_rows + 1, MAX_CHUNKS);
+    samples= (ulonglong) chunks * CHUNK_SAMPLES;
+    /* Parts per million of the rows to sample */
+    ppm= samples >= rows ? 1000000 : MY_MAX(samples * 1000000 / rows, 1);
+
+    dynstr_set_checked(&query, "SELECT ");
+    dynstr_append_checked(&query, key);
+    dynstr_append_checked(&query, " FROM ");
+    dynstr_append_checked(&query, result_table);
+    if (ppm < 1000000)
+    {
+      my_snprintf(buff, sizeof(buff), " SAMPLE (%llu.%06llu)",
+                  ppm / 10000, ppm % 10000 * 100);
+      dynstr_append_checked(&query, buff);
+    }
+    dynstr_append_checked(&query, " ORDER BY ");
+    dynstr_append_checked(&query, key);
+    if (mysql_query(mysql, query.str))
+    {
+      /* Not OceanBase: pick the rows with RAND(), in one scan all the same */
+      dynstr_set_checked(&query, "SELECT ");
+      dynstr_append_checked(&query, key);
+      dynstr_append_checked(&query, " FROM ");
+      dynstr_append_checked(&query, result_table);
+      my_snprintf(buff, sizeof(buff), " WHERE RAND() < %llu.%06llu",
+                  ppm / 1000000, ppm % 1000000);
+      dynstr_append_checked(&query, buff);
+      dynstr_append_checked(&query, " ORDER BY ");
+      dynstr_append_checked(&query, key);
+      if (mysql_query(mysql, query.str))
+        goto end;
+    }
+    if (!(res= mysql_store_result(mysql)))
+      goto end;
+    n= mysql_num_rows(res);
+    chunks= (uint) MY_MIN(chunks, n / CHUNK_SAMPLES + 1);
+    for (i= 1; i < chunks; i++)
+    {
+      char *value;
+
+      mysql_data_seek(res, n * i / chunks);
+      if (!(row= mysql_fetch_row(res)))
+        break;
+      dynstr_set_checked(&bound, "");
+      chunk_key_literal(&bound, res, row);
+      if (!(value= strdup_root(&dump_job_root, bound.str)) ||
+          insert_dynamic(&bounds, (uchar*) &value))
+        die(EX_EOM, "Couldn't allocate memory");
+    }
+    mysql_free_result(res);
+  }
+  if (!bounds.elements)
+    goto end;
+
+  bound_list= (char**) bounds.buffer;
+  chunks= bounds.elements + 1;
+  verbose_msg("-- Splitting table %s into %u chunks...\n",
+              result_table, chunks);
+  for (i= 0; i < chunks; i++)
+  {
+    DUMP_JOB *job;
+
+    /* The range of chunk i starts at bound i-1 and ends before bound i */
+    dynstr_set_checked(&bound, "");
+    if (i > 0)
+    {
+      dynstr_append_checked(&bound, "(");
+      dynstr_append_checked(&bound, key);
+      dynstr_append_checked(&bound, ") >= ");
+      dynstr_append_checked(&bound, bound_list[i - 1]);
+    }
+    if (i > 0 && i + 1 < chunks)
+      dynstr_append_checked(&bound, " AND ");
+    if (i + 1 < chunks)
+    {
+      dynstr_append_checked(&bound, "(");
+      dynstr_append_checked(&bound, key);
+      dynstr_append_checked(&bound, ") < ");
+      dynstr_append_checked(&bound, bound_list[i]);
+    }
+
+    if (!(job= dump_job_new(db, table, result_table, opt_quoted_table)))
+      break;
+    job->chunk= i;
+    job->chunks= chunks;
+    job->size= data_length / chunks;
+    if (i == 0)
+    {
+      print_comment(job->file, 0, "\n--\n-- Dumping data for table %s\n--\n",
+                    fix_for_comment(result_table));
+      if (where)
+        print_comment(job->file, 0, "-- WHERE:  %s\n", fix_for_comment(where));
+      if (order_by)
+        print_comment(job->file, 0, "-- ORDER BY:  %s\n",
+                      fix_for_comment(order_by));
     }
-    if (quick)
-      res=mysql_use_result(mysql);
+    print_comment(job->file, 0, "-- Chunk %u of %u: %s\n", i + 1, chunks,
+                  fix_for_comment(bound.str));
+    if (!opt_compact)
+    {
+      fputs("\n", job->file);
+      check_io(job->file);
+    }
+
+    dynstr_set_checked(&query, "SELECT /*!40001 SQL_NO_CACHE */ ");
+    dynstr_append_checked(&query, select_field_names.str);
+    dynstr_append_checked(&query, " FROM ");
+    dynstr_append_checked(&query, result_table);
+    dynstr_append_checked(&query, " WHERE ");
+    if (where)
+    {
+      dynstr_append_checked(&query, "(");
+      dynstr_append_checked(&query, where);
+      dynstr_append_checked(&query, ") AND ");
+    }
+    dynstr_append_checked(&query, bound.str);
+    if (order_by)
+    {
+      dynstr_append_checked(&query, " ORDER BY ");
+      dynstr_append_checked(&query, order_by);
+    }
+    dump_job_queue(job, query.str, num_fields);
+  }
+  my_free(key);
+  dynstr_free(&query);
+  dynstr_free(&bound);
+  delete_dynamic(&bounds);
+  DBUG_RETURN(1);
+
+end:
+  if (mysql_errno(mysql))
+    verbose_msg("-- Warning: Couldn't split table %s (%s)\n",
+                result_table, mysql_error(mysql));
+  my_free(key);
+  dynstr_free(&query);
+  dynstr_free(&bound);
+  delete_dynamic(&bounds);
+  DBUG_RETURN(0);
+}
+
+
+/* Delete the files of the jobs and forget the jobs. */
+
+static void dump_jobs_clear()
+{
+  uint i;
+  for (i= 0; i < dump_jobs.elements; i++)
+  {
+    DUMP_JOB *job= *dynamic_element(&dump_jobs, i, DUMP_JOB**);
+    if (job->file)
+      my_fclose(job->file, MYF(0));
+    if (job->file_name[0])
+      my_delete(job->file_name, MYF(0));
+  }
+  reset_dynamic(&dump_jobs);
+  free_root(&dump_job_root, MYF(MY_MARK_BLOCKS_FREE));
+  dump_order= NULL;
+  queued_job= NULL;
+}
+
+
+static int dump_job_run(DUMP_WORKER *worker, DUMP_JOB *job)
+{
+  int error;
+
+  if (strcmp(worker->db, job->db))
+  {
+    if (mysql_select_db(&worker->mysql, job->db))
+    {
+      my_snprintf(job->message, sizeof(job->message),
+                  "%s: Got error: %d: \"%s\" when selecting the database\n",
+                  my_progname_short, mysql_errno(&worker->mysql),
+                  mysql_error(&worker->mysql));
+      return EX_MYSQLERR;
+    }
+    strmake_buf(worker->db, job->db);
+  }
+  if (!(job->file= my_fopen(job->file_name, O_WRONLY | O_APPEND, MYF(0))))
+  {
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Can't open %s (errno: %d)\n",
+                my_progname_short, job->file_name, my_errno);
+    return EX_EOF;
+  }
+  error= dump_table_data(&worker->mysql, job, &worker->row);
+  if (my_fclose(job->file, MYF(0)) && !error)
+  {
+    my_snprintf(job->message, sizeof(job->message),
+                "%s: Got errno %d on write\n", my_progname_short, my_errno);
+    error= EX_EOF;
+  }
+  job->file= NULL;
+  return error;
+}
+
+
+pthread_handler_t dump_worker(void *arg)
+{
+  DUMP_WORKER *worker= (DUMP_WORKER*) arg;
+
+  mysql_thread_init();
+  pthread_mutex_lock(&dump_mutex);
+  for (;;)
+  {
+    DUMP_JOB *job;
+
+    while (dump_next == dump_count && !dump_stop)
+      pthread_cond_wait(&dump_work, &dump_mutex);
+    if (dump_next == dump_count)
+      break;
+    job= worker->job= dump_order[dump_next++];
+    pthread_mutex_unlock(&dump_mutex);
+
+    job->error= dump_job_run(worker, job);
+
+    pthread_mutex_lock(&dump_mutex);
+    job->done= 1;
+    worker->job= NULL;
+    pthread_cond_broadcast(&dump_done);
+  }
+  pthread_mutex_unlock(&dump_mutex);
+  mysql_thread_end();
+  return 0;
+}
+
+
+/*
+  Open the worker connections. This is done before the main connection
+  takes FLUSH TABLES WITH READ LOCK, so that the lock is not held while
+  the workers log in and run --init-sql.
+*/
+
+static int dump_workers_connect()
+{
+  uint i;
+  DBUG_ENTER("dump_workers_connect");
+
+  if (!(dump_workers= (DUMP_WORKER*) my_malloc(opt_parallel *
+                                                sizeof(DUMP_WORKER),
+                                                MYF(MY_WME | MY_ZEROFILL))))
+    DBUG_RETURN(1);
+  pthread_mutex_init(&dump_mutex, NULL);
+  pthread_cond_init(&dump_work, NULL);
+  pthread_cond_init(&dump_done, NULL);
+  my_init_dynamic_array(&dump_jobs, sizeof(DUMP_JOB*), 256, 256, MYF(0));
+  init_alloc_root(&dump_job_root, "dump_jobs", 65536, 0, MYF(0));
+  dump_next= dump_count= 0;
+  dump_stop= 0;
+
+  for (i= 0; i < opt_parallel; i++)
+  {
+    DUMP_WORKER *worker= dump_workers + i;
+
+    verbose_msg("-- Connecting worker %u...\n", i + 1);
+    if (connect_session(&worker->mysql, current_host, current_user,
+                        opt_password))
+    {
+      mysql_close(&worker->mysql);
+      DBUG_RETURN(1);
+    }
+    init_dynamic_string_checked(&worker->row, "", ROW_BLOCK_SIZE,
+                                ROW_BLOCK_SIZE);
+    dump_worker_count++;
+    if (opt_init_sql && run_init_sql(&worker->mysql))
+      DBUG_RETURN(1);
+  }
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Start the transactions of the workers and their threads, while the
+  caller holds FLUSH TABLES WITH READ LOCK, so that they all read the
+  snapshot of the main connection.
+*/
+
+static int dump_workers_start()
+{
+  uint i;
+  DBUG_ENTER("dump_workers_start");
+
+  for (i= 0; i < dump_worker_count; i++)
+  {
+    DUMP_WORKER *worker= dump_workers + i;
+
+    if (start_transaction(&worker->mysql))
+      DBUG_RETURN(1);
+  }
+  for (i= 0; i < dump_worker_count; i++)
+  {
+    DUMP_WORKER *worker= dump_workers + i;
+
+    if (pthread_create(&worker->thread, NULL, dump_worker, worker))
+    {
+      fprintf(stderr, "%s: Could not create thread\n", my_progname_short);
+      DBUG_RETURN(1);
+    }
+    dump_worker_threads++;
+  }
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Stop the workers. With abort, the jobs not started are dropped and the
+  running queries are killed instead of waited for.
+*/
+
+static void dump_workers_end(my_bool abort)
+{
+  uint i;
+
+  if (!dump_workers)
+    return;
+  pthread_mutex_lock(&dump_mutex);
+  if (abort)
+  {
+    dump_count= dump_next;
+    for (i= 0; i < dump_worker_threads; i++)
+    {
+      char buff[40];
+      if (!dump_workers[i].job || !mysql)
+        continue;
+      my_snprintf(buff, sizeof(buff), "KILL QUERY %lu",
+                  mysql_thread_id(&dump_workers[i].mysql));
+      (void) mysql_query(mysql, buff);
+    }
+  }
+  dump_stop= 1;
+  pthread_cond_broadcast(&dump_work);
+  pthread_mutex_unlock(&dump_mutex);
+
+  for (i= 0; i < dump_worker_threads; i++)
+    pthread_join(dump_workers[i].thread, NULL);
+  for (i= 0; i < dump_worker_count; i++)
+  {
+    mysql_close(&dump_workers[i].mysql);
+    dynstr_free(&dump_workers[i].row);
+  }
+  dump_jobs_clear();
+  delete_dynamic(&dump_jobs);
+  free_root(&dump_job_root, MYF(0));
+  pthread_cond_destroy(&dump_done);
+  pthread_cond_destroy(&dump_work);
+  pthread_mutex_destroy(&dump_mutex);
+  my_free(dump_workers);
+  dump_workers= 0;
+  dump_worker_count= dump_worker_threads= 0;
+}
+
+
+/* Copy the output of a job to the dump and delete its file. */
+
+static void dump_job_append(DUMP_JOB *job)
+{
+  char buff[IO_SIZE * 16];
+  size_t length;
+  FILE *file;
+
+  if (!(file= my_fopen(job->file_name, O_RDONLY | O_BINARY, MYF(MY_WME))))
+  {
+    maybe_die(EX_EOF, "Can't read the data of table %s", job->result_table);
+    return;
+  }
+  while ((length= fread(buff, 1, sizeof(buff), file)))
+    fwrite(buff, 1, length, md_result_file);
+  check_io(md_result_file);
+  my_fclose(file, MYF(0));
+  my_delete(job->file_name, MYF(0));
+  job->file_name[0]= 0;
+}
+
+
+/*
+  Dump the data queued for the current database through the workers, and
+  the triggers held back to follow it.
+*/
+
+static void dump_jobs_run()
+{
+  DUMP_JOB **jobs= (DUMP_JOB**) dump_jobs.buffer;
+  uint i, count= dump_jobs.elements;
+  MYSQL_RES *res;
+  MYSQL_ROW row;
+  HASH by_name;
+  DBUG_ENTER("dump_jobs_run");
+
+  if (!dump_workers || !count)
+    DBUG_VOID_RETURN;
+
+  /* Start with the largest tables, so that they don't finish last */
+  if (!my_hash_init(&by_name, charset_info, count, 0, 0,
+                    (my_hash_get_key) get_job_key, 0, 0))
+  {
+    for (i= 0; i < count; i++)
+      if (!jobs[i]->chunks)           /* chunks have their share already */
+        (void) my_hash_insert(&by_name, (uchar*) jobs[i]);
+    if (mysql_query(mysql, "SELECT table_name, data_length "
+                    "FROM INFORMATION_SCHEMA.TABLES "
+                    "WHERE table_schema = DATABASE()") ||
+        !(res= mysql_store_result(mysql)))
+      verbose_msg("-- Warning: Couldn't get the size of the tables (%s)\n",
+                  mysql_error(mysql));
     else
-      res=mysql_store_result(mysql);
-    if (!res)
     {
-      dynstr_free(&query_string);
-      DB_error(mysql, "when retrieving data from server");
-      goto err;
+      while ((row= mysql_fetch_row(res)))
+      {
+        DUMP_JOB *job;
+        if (row[0] && row[1] &&
+            (job= (DUMP_JOB*) my_hash_search(&by_name, (uchar*) row[0],
+                                              strlen(row[0]))))
+          job->size= strtoull(row[1], NULL, 10);
+      }
+      mysql_free_result(res);
+    }
+    my_hash_free(&by_name);
+  }
+  if (!(dump_order= (DUMP_JOB**) memdup_root(&dump_job_root, jobs,
+                                              count * sizeof(DUMP_JOB*))))
+    die(EX_EOM, "alloc_root failure.");
+  my_qsort(dump_order, count, sizeof(DUMP_JOB*), dump_job_cmp);
+
+  verbose_msg("-- Dumping the data of %u tables in parallel...\n", count);
+  pthread_mutex_lock(&dump_mutex);
+  dump_next= 0;
+  dump_count= count;
+  pthread_cond_broadcast(&dump_work);
+  pthread_mutex_unlock(&dump_mutex);
+
+  for (i= 0; i < count; i++)
+  {
+    DUMP_JOB *job= jobs[i];
+
+    pthread_mutex_lock(&dump_mutex);
+    while (!job->done)
+      pthread_cond_wait(&dump_done, &dump_mutex);
+    pthread_mutex_unlock(&dump_mutex);
+
+    dump_job_append(job);
+    if (job->error)
+    {
+      fputs(job->message, stderr);
+      fflush(stderr);
+      if (!ignore_errors)
+        dump_workers_end(TRUE);
+      maybe_exit(job->error);
+    }
+    if (job->triggers && dump_triggers_for_table(job->table, job->db))
+    {
+      if (!ignore_errors)
+        dump_workers_end(TRUE);
+      maybe_exit(EX_MYSQLERR);
+    }
+  }
+
+  pthread_mutex_lock(&dump_mutex);
+  dump_next= dump_count= 0;
+  pthread_mutex_unlock(&dump_mutex);
+  dump_jobs_clear();
+  DBUG_VOID_RETURN;
+}
+
+
+static void dump_table(const char *table, const char *db, const uchar *hash_key, size_t len)
+{
+  char ignore_flag;
+  char table_buff[NAME_LEN+3];
+  DYNAMIC_STRING query_string;
+  char table_type[NAME_LEN];
+  char *result_table, table_buff2[NAME_LEN*2+3], *opt_quoted_table;
+  int error= 0;
+  uint num_fields;
+  DUMP_JOB job, *data= &job;
+  DBUG_ENTER("dump_table");
+
+  queued_job= NULL;
+
+  /*
+    Check does table has a sequence structure and if has apply different sql queries
+  */
+  if (check_if_ignore_table(table, table_type) & IGNORE_SEQUENCE_TABLE)
+  {
+    get_sequence_structure(table, db);
+    DBUG_VOID_RETURN;
+  }
+  /*
+    Make sure you get the create table info before the following check for
+    --no-data flag below. Otherwise, the create table info won't be printed.
+  */
+  num_fields= get_table_structure(table, db, table_type, &ignore_flag);
+
+  /*
+    The "table" could be a view.  If so, we don't do anything here.
+  */
+  if (strcmp(table_type, "VIEW") == 0)
+    DBUG_VOID_RETURN;
+
+  /* Check --no-data flag */
+  if (opt_no_data || (hash_key && ignore_table_data(hash_key, len)))
+  {
+    verbose_msg("-- Skipping dump data for table '%s', --no-data was used\n",
+                table);
+    DBUG_VOID_RETURN;
+  }
+
+  DBUG_PRINT("info",
+             ("ignore_flag: %x  num_fields: %d", (int) ignore_flag,
+              num_fields));
+  /*
+    If the table type is a merge table or any type that has to be
+     _completely_ ignored and no data dumped
+  */
+  if (ignore_flag & IGNORE_DATA)
+  {
+    verbose_msg("-- Warning: Skipping data for table '%s' because " \
+                "it's of type %s\n", table, table_type);
+    DBUG_VOID_RETURN;
+  }
+  /* Check that there are any fields in the table */
+  if (num_fields == 0)
+  {
+    verbose_msg("-- Skipping dump data for table '%s', it has no fields\n",
+                table);
+    DBUG_VOID_RETURN;
+  }
+
+  /*
+     Check --skip-events flag: it is not enough to skip creation of events
+     discarding SHOW CREATE EVENT statements generation. The myslq.event
+     table data should be skipped too.
+  */
+  if (!opt_events && !my_strcasecmp(&my_charset_latin1, db, "mysql") &&
+      !my_strcasecmp(&my_charset_latin1, table, "event"))
+  {
+    verbose_msg("-- Skipping data table mysql.event, --skip-events was used\n");
+    DBUG_VOID_RETURN;
+  }
+
+  result_table= quote_name(table,table_buff, 1);
+  opt_quoted_table= quote_name(table, table_buff2, 0);
+
+  verbose_msg("-- Sending SELECT query...\n");
+
+  init_dynamic_string_checked(&query_string, "", 1024, 1024);
+
+  if (path)
+  {
+    char filename[FN_REFLEN], tmp_path[FN_REFLEN];
+
+    /*
+      Convert the path to native os format
+      and resolve to the full filepath.
+    */
+    convert_dirname(tmp_path,path,NullS);    
+    my_load_path(tmp_path, tmp_path, NULL);
+    fn_format(filename, table, tmp_path, ".txt", MYF(MY_UNPACK_FILENAME));
+
+    /* Must delete the file that 'INTO OUTFILE' will write to */
+    my_delete(filename, MYF(0));
+
+    /* convert to a unix path name to stick into the query */
+    to_unix_path(filename);
+
+    /* now build the query string */
+
+    dynstr_append_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ ");
+    dynstr_append_checked(&query_string, select_field_names.str);
+    dynstr_append_checked(&query_string, " INTO OUTFILE '");
+    dynstr_append_checked(&query_string, filename);
+    dynstr_append_checked(&query_string, "'");
+
+    dynstr_append_checked(&query_string, " /*!50138 CHARACTER SET ");
+    dynstr_append_checked(&query_string, default_charset == mysql_universal_client_charset ?
+                                         my_charset_bin.name : /* backward compatibility */
+                                         default_charset);
+    dynstr_append_checked(&query_string, " */");
+
+    if (fields_terminated || enclosed || opt_enclosed || escaped)
+      dynstr_append_checked(&query_string, " FIELDS");
+    
+    add_load_option(&query_string, " TERMINATED BY ", fields_terminated);
+    add_load_option(&query_string, " ENCLOSED BY ", enclosed);
+    add_load_option(&query_string, " OPTIONALLY ENCLOSED BY ", opt_enclosed);
+    add_load_option(&query_string, " ESCAPED BY ", escaped);
+    add_load_option(&query_string, " LINES TERMINATED BY ", lines_terminated);
+
+    dynstr_append_checked(&query_string, " FROM ");
+    dynstr_append_checked(&query_string, result_table);
+
+    if (where)
+    {
+      dynstr_append_checked(&query_string, " WHERE ");
+      dynstr_append_checked(&query_string, where);
     }
 
-    verbose_msg("-- Retrieving rows...\n");
-    if (mysql_num_fields(res) != num_fields)
+    if (order_by)
     {
-      fprintf(stderr,"%s: Error in field count for table: %s !  Aborting.\n",
-              my_progname_short, result_table);
-      error= EX_CONSCHECK;
-      goto err;
+      dynstr_append_checked(&query_string, " ORDER BY ");
+      dynstr_append_checked(&query_string, order_by);
+      my_free(order_by);
+      order_by= 0;
     }
 
-    if (opt_lock)
+    if (mysql_real_query(mysql, query_string.str, (ulong)query_string.length))
     {
-      fprintf(md_result_file,"LOCK TABLES %s WRITE;\n", opt_quoted_table);
-      check_io(md_result_file);
+      dynstr_free(&query_string);
+      DB_error(mysql, "when executing 'SELECT INTO OUTFILE'");
+      DBUG_VOID_RETURN;
     }
-    /* Moved disable keys to after lock per bug 15977 */
-    if (opt_disable_keys)
+  }
+  else
+  {
+    if (dump_workers && (opt_chunk_rows || opt_chunk_bytes) &&
+        dump_table_chunks(db, table, result_table, opt_quoted_table,
+                          num_fields))
     {
-      fprintf(md_result_file, "/*!40000 ALTER TABLE %s DISABLE KEYS */;\n",
-	      opt_quoted_table);
-      check_io(md_result_file);
+      my_free(order_by);
+      order_by= 0;
+      dynstr_free(&query_string);
+      DBUG_VOID_RETURN;
     }
-
-    total_length= opt_net_buffer_length;                /* Force row break */
-    row_break=0;
-    rownr=0;
-    init_length=(uint) insert_pat.length+4;
-    if (opt_xml)
-      print_xml_tag(md_result_file, "\t", "\n", "table_data", "name=", table,
-              NullS);
-    if (opt_autocommit)
+    bzero((char*) &job, sizeof(job));
+    job.file= md_result_file;
+    if (dump_workers &&
+        !(data= dump_job_new(db, table, result_table, opt_quoted_table)))
     {
-      fprintf(md_result_file, "set autocommit=0;\n");
-      check_io(md_result_file);
+      dynstr_free(&query_string);
+      DBUG_VOID_RETURN;
     }
+    print_comment(data->file, 0,
+                  "\n--\n-- Dumping data for table %s\n--\n",
+                  fix_for_comment(result_table));
+    
+    dynstr_append_checked(&query_string, "SELECT /*!40001 SQL_NO_CACHE */ ");
+    dynstr_append_checked(&query_string, select_field_names.str);
+    dynstr_append_checked(&query_string, " FROM ");
+    dynstr_append_checked(&query_string, result_table);
 
-    while ((row= mysql_fetch_row(res)))
+    if (where)
     {
-      uint i;
-      ulong *lengths= mysql_fetch_lengths(res);
-      rownr++;
-
-      // For large tables
-      if (0 == rownr % 100000) {
-        fprintf(stderr, "%lu rows dumpped for %s\n",
-          rownr, result_table);
-      }
-
-      if (!extended_insert && !opt_xml)
-      {
-        fputs(insert_pat.str,md_result_file);
-        check_io(md_result_file);
-      }
-      mysql_field_seek(res,0);
-
-      if (opt_xml)
-      {
-        fputs("\t<row>\n", md_result_file);
-        check_io(md_result_file);
-      }
-
-      for (i= 0; i < mysql_num_fields(res); i++)
-      {
-        int is_blob;
-        ulong length= lengths[i];
-
-        if (!(field= mysql_fetch_field(res)))
-          die(EX_CONSCHECK,
-                      "Not enough fields from table %s! Aborting.\n",
-                      result_table);
-
-        /*
-           63 is my_charset_bin. If charsetnr is not 63,
-           we have not a BLOB but a TEXT column.
-           we'll dump in hex only BLOB columns.
-        */
-        is_blob= (opt_hex_blob && field->charsetnr == 63 &&
-                  (field->type == MYSQL_TYPE_BIT ||
-                   field->type == MYSQL_TYPE_STRING ||
-                   field->type == MYSQL_TYPE_VAR_STRING ||
-                   field->type == MYSQL_TYPE_OB_NVARCHAR2 ||
-                   field->type == MYSQL_TYPE_OB_NCHAR ||
-                   field->type == MYSQL_TYPE_VARCHAR ||
-                   field->type == MYSQL_TYPE_BLOB ||
-                   field->type == MYSQL_TYPE_LONG_BLOB ||
-                   field->type == MYSQL_TYPE_MEDIUM_BLOB ||
-                   field->type == MYSQL_TYPE_TINY_BLOB ||
-                   field->type == MYSQL_TYPE_GEOMETRY)) ? 1 : 0;
-        if (extended_insert && !opt_xml)
-        {
-          if (i == 0)
-            dynstr_set_checked(&extended_row,"(");
-          else
-            dynstr_append_checked(&extended_row,",");
-
-          if (row[i])
-          {
-            if (length)
-            {
-              if (!(field->flags & NUM_FLAG))
-              {
-                /*
-                  "length * 2 + 2" is OK for both HEX and non-HEX modes:
-                  - In HEX mode we need exactly 2 bytes per character
-                  plus 2 bytes for '0x' prefix.
-                  - In non-HEX mode we need up to 2 bytes per character,
-                  plus 2 bytes for leading and trailing '\'' characters.
-                  Also we need to reserve 1 byte for terminating '\0'.
-                */
-                dynstr_realloc_checked(&extended_row,length * 2 + 2 + 1);
-                if (opt_hex_blob && is_blob)
-                {
-                  dynstr_append_checked(&extended_row, "0x");
-                  extended_row.length+= mysql_hex_string(extended_row.str +
-                                                         extended_row.length,
-                                                         row[i], length);
-                  DBUG_ASSERT(extended_row.length+1 <= extended_row.max_length);
-                  /* mysql_hex_string() already terminated string by '\0' */
-                  DBUG_ASSERT(extended_row.str[extended_row.length] == '\0');
-                }
-                else
-                {
-                  dynstr_append_checked(&extended_row,"'");
-                  extended_row.length +=
-                  mysql_real_escape_string(&mysql_connection,
-                                           &extended_row.str[extended_row.length],
-                                           row[i],length);
-                  extended_row.str[extended_row.length]='\0';
-                  dynstr_append_checked(&extended_row,"'");
-                }
-              }
-              else
-              {
-                /* change any strings ("inf", "-inf", "nan") into NULL */
-                char *ptr= row[i];
-                if (my_isalpha(charset_info, *ptr) || (*ptr == '-' &&
-                    my_isalpha(charset_info, ptr[1])))
-                  dynstr_append_checked(&extended_row, "NULL");
-                else
-                {
-                  if (field->type == MYSQL_TYPE_DECIMAL)
-                  {
-                    /* add " signs around */
-                    dynstr_append_checked(&extended_row, "'");
-                    dynstr_append_checked(&extended_row, ptr);
-                    dynstr_append_checked(&extended_row, "'");
-                  }
-                  else
-                    dynstr_append_checked(&extended_row, ptr);
-                }
-              }
-            }
-            else
-              dynstr_append_checked(&extended_row,"''");
-          }
-          else
-            dynstr_append_checked(&extended_row,"NULL");
-        }
-        else
-        {
-          if (i && !opt_xml)
-          {
-            fputc(',', md_result_file);
-            check_io(md_result_file);
-          }
-          if (row[i])
-          {
-            if (!(field->flags & NUM_FLAG))
-            {
-              if (opt_xml)
-              {
-                if (opt_hex_blob && is_blob && length)
-                {
-                  /* Define xsi:type="xs:hexBinary" for hex encoded data */
-                  print_xml_tag(md_result_file, "\t\t", "", "field", "name=",
-                                field->name, "xsi:type=", "xs:hexBinary", NullS);
-                  print_blob_as_hex(md_result_file, row[i], length);
-                }
-                else
-                {
-                  print_xml_tag(md_result_file, "\t\t", "", "field", "name=", 
-                                field->name, NullS);
-                  print_quoted_xml(md_result_file, row[i], length, 0);
-                }
-                fputs("</field>\n", md_result_file);
-              }
-              else if (opt_hex_blob && is_blob && length)
-              {
-                fputs("0x", md_result_file);
-                print_blob_as_hex(md_result_file, row[i], length);
-              }
-              else
-                unescape(md_result_file, row[i], length);
-            }
-            else
-            {
-              /* change any strings ("inf", "-inf", "nan") into NULL */
-              char *ptr= row[i];
-              if (opt_xml)
-              {
-                print_xml_tag(md_result_file, "\t\t", "", "field", "name=",
-                        field->name, NullS);
-                fputs(!my_isalpha(charset_info, *ptr) ? ptr: "NULL",
-                      md_result_file);
-                fputs("</field>\n", md_result_file);
-              }
-              else if (my_isalpha(charset_info, *ptr) ||
-                       (*ptr == '-' && my_isalpha(charset_info, ptr[1])))
-                fputs("NULL", md_result_file);
-              else if (field->type == MYSQL_TYPE_DECIMAL)
-              {
-                /* add " signs around */
-                fputc('\'', md_result_file);
-                fputs(ptr, md_result_file);
-                fputc('\'', md_result_file);
-              }
-              else
-                fputs(ptr, md_result_file);
-            }
-          }
-          else
-          {
-            /* The field value is NULL */
-            if (!opt_xml)
-              fputs("NULL", md_result_file);
-            else
-              print_xml_null_tag(md_result_file, "\t\t", "field name=",
-                                 field->name, "\n");
-          }
-          check_io(md_result_file);
-        }
-      }
-
-      if (opt_xml)
-      {
-        fputs("\t</row>\n", md_result_file);
-        check_io(md_result_file);
-      }
-
-      if (extended_insert)
-      {
-        size_t row_length;
-        dynstr_append_checked(&extended_row,")");
-        row_length= 2 + extended_row.length;
-        if (total_length + row_length < opt_net_buffer_length)
-        {
-          total_length+= row_length;
-          fputc(',',md_result_file);            /* Always row break */
-          fputs(extended_row.str,md_result_file);
-        }
-        else
-        {
-          if (row_break)
-            fputs(";\n", md_result_file);
-          row_break=1;                          /* This is first row */
+      print_comment(data->file, 0, "-- WHERE:  %s\n", fix_for_comment(where));
 
-          fputs(insert_pat.str,md_result_file);
-          fputs(extended_row.str,md_result_file);
-          total_length= row_length+init_length;
-        }
-        check_io(md_result_file);
-      }
-      else if (!opt_xml)
-      {
-        fputs(");\n", md_result_file);
-        check_io(md_result_file);
-      }
+      dynstr_append_checked(&query_string, " WHERE ");
+      dynstr_append_checked(&query_string, where);
     }
+    if (order_by)
+    {
+      print_comment(data->file, 0, "-- ORDER BY:  %s\n", fix_for_comment(order_by));
 
-    /* XML - close table tag and suppress regular output */
-    if (opt_xml)
-        fputs("\t</table_data>\n", md_result_file);
-    else if (extended_insert && row_break)
-      fputs(";\n", md_result_file);             /* If not empty table */
-    fflush(md_result_file);
-    check_io(md_result_file);
-    if (mysql_errno(mysql))
-    {
-      my_snprintf(buf, sizeof(buf),
-                  "%s: Error %d: %s when dumping table %s at row: %ld\n",
-                  my_progname_short,
-                  mysql_errno(mysql),
-                  mysql_error(mysql),
-                  result_table,
-                  rownr);
-      fputs(buf,stderr);
-      error= EX_CONSCHECK;
-      goto err;
+      dynstr_append_checked(&query_string, " ORDER BY ");
+      dynstr_append_checked(&query_string, order_by);
+      my_free(order_by);
+      order_by= 0;
     }
 
-    /* Moved enable keys to before unlock per bug 15977 */
-    if (opt_disable_keys)
+    if (!opt_xml && !opt_compact)
     {
-      fprintf(md_result_file,"/*!40000 ALTER TABLE %s ENABLE KEYS */;\n",
-              opt_quoted_table);
-      check_io(md_result_file);
+      fputs("\n", data->file);
+      check_io(data->file);
     }
-    if (opt_lock)
+    if (dump_workers)
     {
-      fputs("UNLOCK TABLES;\n", md_result_file);
-      check_io(md_result_file);
+      dump_job_queue(data, query_string.str, num_fields);
+      dynstr_free(&query_string);
+      DBUG_VOID_RETURN;
     }
-    if (opt_autocommit)
+    job.db= (char*) db;
+    job.table= (char*) table;
+    job.result_table= result_table;
+    job.quoted_table= opt_quoted_table;
+    job.query= query_string.str;
+    job.insert_pat= insert_pat.str;
+    job.num_fields= num_fields;
+    if ((error= dump_table_data(mysql, &job, &row_block)))
     {
-      fprintf(md_result_file, "commit;\n");
-      check_io(md_result_file);
+      fputs(job.message, stderr);
+      fflush(stderr);
+      goto err;
     }
-    mysql_free_result(res);
   }
   dynstr_free(&query_string);
   DBUG_VOID_RETURN;
@@ -5322,7 +6264,10 @@ static int dump_all_tables_in_db(char *database)
   if (init_dumping(database, init_dumping_tables))
     DBUG_RETURN(1);
   if (opt_xml)
+  {
     print_xml_tag(md_result_file, "", "\n", "database", "name=", database, NullS);
+    check_io(md_result_file);
+  }
 
   if (lock_tables)
   {
@@ -5372,7 +6317,9 @@ static int dump_all_tables_in_db(char *database)
       order_by= 0;
       if (opt_dump_triggers && mysql_get_server_version(mysql) >= 50009)
       {
-        if (dump_triggers_for_table(table, database))
+        if (queued_job)
+          queued_job->triggers= 1;            /* after the data */
+        else if (dump_triggers_for_table(table, database))
         {
           if (path)
             my_fclose(md_result_file, MYF(MY_WME));
@@ -5420,6 +6367,7 @@ static int dump_all_tables_in_db(char *database)
       }
     }
   }
+  dump_jobs_run();
 
   if (opt_single_transaction && mysql_get_server_version(mysql) >= 50500)
   {
@@ -5506,7 +6454,10 @@ static my_bool dump_all_views_in_db(char *database)
   if (init_dumping(database, init_dumping_views))
     return 1;
   if (opt_xml)
+  {
     print_xml_tag(md_result_file, "", "\n", "database", "name=", database, NullS);
+    check_io(md_result_file);
+  }
   if (lock_tables)
   {
     DYNAMIC_STRING query;
@@ -5742,7 +6693,10 @@ static int dump_selected_tables(char *db, char **table_names, int tables)
       verbose_msg("-- dump_selected_tables : logs flushed successfully!\n");
   }
   if (opt_xml)
+  {
     print_xml_tag(md_result_file, "", "\n", "database", "name=", db, NullS);
+    check_io(md_result_file);
+  }
 
 
   /* obtain dump of routines (procs/functions) */
@@ -5769,7 +6723,9 @@ static int dump_selected_tables(char *db, char **table_names, int tables)
     if (opt_dump_triggers &&
         mysql_get_server_version(mysql) >= 50009)
     {
-      if (dump_triggers_for_table(*pos, db))
+      if (queued_job)
+        queued_job->triggers= 1;              /* after the data */
+      else if (dump_triggers_for_table(*pos, db))
       {
         if (path)
           my_fclose(md_result_file, MYF(MY_WME));
@@ -5800,6 +6756,7 @@ static int dump_selected_tables(char *db, char **table_names, int tables)
       }
     }
   }
+  dump_jobs_run();
 
   if (opt_single_transaction && mysql_get_server_version(mysql) >= 50500)
   {
@@ -6177,8 +7134,10 @@ static int run_init_sql(MYSQL *mysql_con)
     if (NULL == end) break;
     *end = '\0';
     if (mysql_query_with_error_report(mysql_con, 0, sql)) {
+      *end = ';';
       goto err;
     }
+    *end = ';';   /* --parallel runs it again on the worker connections */
     // check if more stmt
     sql = end + 1;
   }
@@ -6424,9 +7383,10 @@ char check_if_ignore_table(const char *table_name, char *table_type)
   Get string of comma-separated primary key field names
 
   SYNOPSIS
-    char *primary_key_fields(const char *table_name)
-    RETURNS     pointer to allocated buffer (must be freed by caller)
-    table_name  quoted table name
+    char *primary_key_fields(const char *table_name, my_bool primary_only)
+    RETURNS       pointer to allocated buffer (must be freed by caller)
+    table_name    quoted table name
+    primary_only  ignore UNIQUE keys, which may contain NULLs
 
   DESCRIPTION
     Use SHOW KEYS FROM table_name, allocate a buffer to hold the
@@ -6438,7 +7398,8 @@ char check_if_ignore_table(const char *table_name, char *table_type)
     the table unsorted, rather than exit without dumping the data.
 */
 
-static char *primary_key_fields(const char *table_name)
+static char *primary_key_fields(const char *table_name,
+                                my_bool primary_only)
 {
   MYSQL_RES  *res= NULL;
   MYSQL_ROW  row;
@@ -6467,7 +7428,8 @@ static char *primary_key_fields(const char *table_name)
    * row, and UNIQUE keys come before others.  So we only need to check
    * the first key, not all keys.
    */
-  if ((row= mysql_fetch_row(res)) && atoi(row[1]) == 0)
+  if ((row= mysql_fetch_row(res)) && atoi(row[1]) == 0 &&
+      (!primary_only || !strcmp(row[2], "PRIMARY")))
   {
     /* Key is unique */
     do
@@ -6749,7 +7711,7 @@ static my_bool get_view_structure(char *table, char* db)
   {
     fputs("\n", sql_file);
     write_footer(sql_file);
-    my_fclose(sql_file, MYF(MY_WME));
+    close_sql_file(sql_file, MYF(MY_WME));
   }
   DBUG_RETURN(0);
 }
@@ -6853,8 +7815,18 @@ int main(int argc, char **argv)
     consistent_binlog_pos= check_consistent_binlog_pos(NULL, NULL);
   }
 
+  /*
+    The snapshots of the workers are only the one of the main connection
+    if the read lock holds back commits, which it does not on OceanBase.
+  */
+  if (opt_parallel && strstr(mysql_get_server_info(mysql), "OceanBase"))
+    die(EX_USAGE, "--parallel is not supported by OceanBase, which can't "
+        "give the worker connections the snapshot of the main connection");
+  if (opt_parallel && dump_workers_connect())
+    goto err;
+
   if ((opt_lock_all_tables || (opt_master_data && !consistent_binlog_pos) ||
-       (opt_single_transaction && flush_logs)) &&
+       (opt_single_transaction && (flush_logs || opt_parallel))) &&
       do_flush_tables_read_lock(mysql))
     goto err;
 
@@ -6889,6 +7861,10 @@ int main(int argc, char **argv)
   if (opt_single_transaction && start_transaction(mysql))
     goto err;
 
+  /* The workers start their transactions under the same read lock */
+  if (opt_parallel && dump_workers_start())
+    goto err;
+
   /* Add 'STOP SLAVE to beginning of dump */
   if (opt_slave_apply && add_stop_slave())
     goto err;
@@ -6905,8 +7881,7 @@ int main(int argc, char **argv)
   if (opt_alltspcs)
     dump_all_tablespaces();
 
-  if (extended_insert)
-    init_dynamic_string_checked(&extended_row, "", 1024, 1024);
+  init_dynamic_string_checked(&row_block, "", ROW_BLOCK_SIZE, ROW_BLOCK_SIZE);
 
   if (opt_alldbs)
   {
@@ -6987,6 +7962,8 @@ int main(int argc, char **argv)
     server.
   */
 err:
+  dump_workers_end(FALSE);
+
   /* if --dump-slave , start the slave sql thread */
   if (opt_slave_data)
     do_start_slave_sql(mysql);
@@ -6994,6 +7971,17 @@ err:
   dbDisconnect(current_host);
   if (!path)
     write_footer(md_result_file);
+  if (compress_opts.method != COMPRESS_NONE)
+  {
+    /* The last frames are written here, report if that fails */
+    if (close_sql_file(md_result_file, MYF(0)) && !first_error)
+    {
+      fprintf(stderr, "%s: Got errno %d on writing the compressed output\n",
+              my_progname_short, errno);
+      first_error= EX_EOF;
+    }
+    md_result_file= 0;
+  }
   free_resources();
 
   if (stderror_file)
@@ -788,27 +788,32 @@ void mm_puts(char *s, DYNAMIC_STRING *ds)
 
 }
 
+/* Append the bytes of str as hex digits, padded with spaces to width */
+
+static void
+append_hex_digits(DYNAMIC_STRING *ds, const char *str, ulong len, ulong width)
+{
+  size_t hex_len= 2 * (size_t) len;
+  size_t pad= hex_len < width ? width - hex_len : 0;
+  char *to;
+
+  if (dynstr_realloc(ds, hex_len + pad + 1))
+    die("Out of memory");
+  to= bin2hex(ds->str + ds->length, (const uchar*) str, len);
+  bfill(to, pad, ' ');
+  ds->length+= hex_len + pad;
+  ds->str[ds->length]= '\0';
+}
+
 static void
 print_as_hex(DYNAMIC_STRING *ds,
              const char *str,
              ulong len,
              ulong total_bytes_to_send)
 {
-  const char *ptr= str, *end= ptr+len;
-  ulong i;
-//  if (0 != databuff_printf(buf, buf_len, pos, "0x"))
-//     return;
-  dynstr_append_cstring(ds, "0x");
-  for(; ptr < end; ptr++)
-    dynstr_append_cstring(ds, "%02X", *((uchar*)ptr));
-
-//        if (0 != databuff_printf(buf, buf_len, pos, "%02X", *((uchar*)ptr)))
-//        return;
-  for (i= 2*len+2; i < total_bytes_to_send; i++)
-    dynstr_append_cstring(ds, " ");
-//     if (0 != (databuff_printf(buf, buf_len, pos, " ")))
-//         return;
-
+  dynstr_append_mem(ds, "0x", 2);
+  append_hex_digits(ds, str, len,
+                    total_bytes_to_send > 2 ? total_bytes_to_send - 2 : 0);
 }
 
 static void
@@ -817,12 +822,7 @@ const char *str,
 ulong len,
 ulong total_bytes_to_send)
 {
-  const char *ptr = str, *end = ptr + len;
-  ulong i;
-  for (; ptr < end; ptr++)
-    dynstr_append_cstring(ds, "%02X", *((uchar*)ptr));
-  for (i = 2 * len; i < total_bytes_to_send; i++)
-    dynstr_append_cstring(ds, " ");
+  append_hex_digits(ds, str, len, total_bytes_to_send);
 }
 
 /* Used to determine if we should invoke print_as_hex for this field */
@@ -8808,14 +8808,11 @@ void append_stmt_result(DYNAMIC_STRING *ds, MYSQL_STMT *stmt,
       if (3 == opt_result_format_version || 4 == opt_result_format_version) {
         if (!*my_bind[i].is_null && stmt->mysql->oracle_mode && is_binary_field_oracle(&fields[i])) {
           ulong len = *my_bind[i].length * 2;
-          ulong j = 0;
           uchar *p = (uchar*)my_bind[i].buffer;
           char *tmp = (char*)malloc(len + 2);
           if (tmp) {
             memset(tmp, 0, len + 2);
-            for (j = 0; j < *my_bind[i].length; j++) {
-              sprintf(tmp + 2 * j, "%02X", *(p + j));
-            }
+            bin2hex(tmp, p, *my_bind[i].length);
             append_field(ds, i, &fields[i], tmp, len, *my_bind[i].is_null);
             free(tmp);
           }
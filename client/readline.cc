@@ -28,6 +28,22 @@ static bool init_line_buffer(LINE_BUFFER *buffer,File file,ulong size,
 static bool init_line_buffer_from_string(LINE_BUFFER *buffer,char * str);
 static size_t fill_buffer(LINE_BUFFER *buffer);
 static char *intern_read_line(LINE_BUFFER *buffer, ulong *out_length);
+/* Regular input files are mapped into memory where mmap() is available */
+#if !defined(__WIN__) && defined(HAVE_SYS_MMAN_H)
+#define MAP_INPUT_FILES
+#endif
+
+#ifdef MAP_INPUT_FILES
+static void init_line_buffer_map(LINE_BUFFER *buffer, MY_STAT *stat_info);
+static char *intern_read_mapped_line(LINE_BUFFER *buffer, ulong *out_length);
+#endif
+
+/*
+  Consumed parts of a mapped input file are given back to the system in
+  steps of this size, so that sourcing a large file doesn't keep all of
+  it resident.
+*/
+#define MAP_RELEASE_SIZE (64*1024*1024)
 
 
 LINE_BUFFER *batch_readline_init(ulong max_size,FILE *file)
@@ -50,6 +66,10 @@ LINE_BUFFER *batch_readline_init(ulong max_size,FILE *file)
     my_free(line_buff);
     return 0;
   }
+#ifdef MAP_INPUT_FILES
+  if (MY_S_ISREG(input_file_stat.st_mode))
+    init_line_buffer_map(line_buff, &input_file_stat);
+#endif
   return line_buff;
 }
 
@@ -59,7 +79,13 @@ char *batch_readline(LINE_BUFFER *line_buff, bool binary_mode)
   char *pos;
   ulong UNINIT_VAR(out_length);
 
-  if (!(pos=intern_read_line(line_buff, &out_length)))
+#ifdef MAP_INPUT_FILES
+  if (line_buff->map)
+    pos= intern_read_mapped_line(line_buff, &out_length);
+  else
+#endif
+    pos= intern_read_line(line_buff, &out_length);
+  if (!pos)
     return 0;
   if (out_length && pos[out_length-1] == '\n')
   {
@@ -83,6 +109,10 @@ void batch_readline_end(LINE_BUFFER *line_buff)
 {
   if (line_buff)
   {
+#ifdef MAP_INPUT_FILES
+    if (line_buff->map)
+      my_munmap(line_buff->map, line_buff->map_length);
+#endif
     my_free(line_buff->buffer);
     my_free(line_buff);
   }
@@ -263,3 +293,105 @@ char *intern_read_line(LINE_BUFFER *buffer, ulong *out_length)
     DBUG_RETURN(buffer->start_of_line);
   }
 }
+
+
+#ifdef MAP_INPUT_FILES
+/*****************************************************************************
+      Functions to read lines from a regular file mapped into memory
+******************************************************************************/
+
+/*
+  Map the rest of a regular input file, from the current file position on.
+  Lines are then found with memchr() in the mapping and copied once to the
+  line buffer, instead of being read in IO_SIZE pieces and moved down for
+  every partial line. If the file can't be mapped, the buffered reading
+  used for pipes is kept.
+*/
+
+static void init_line_buffer_map(LINE_BUFFER *buffer, MY_STAT *stat_info)
+{
+  my_off_t offset= my_tell(buffer->file, MYF(0));
+  my_off_t file_size= (my_off_t) stat_info->st_size;
+  size_t skip;
+  void *map;
+
+  if (offset == MY_FILEPOS_ERROR || offset >= file_size)
+    return;
+  skip= (size_t) (offset % my_getpagesize());
+  offset-= skip;
+  if (file_size - offset > (my_off_t) SIZE_T_MAX)
+    return;                                     /* Too big for this platform */
+  map= my_mmap(0, (size_t) (file_size - offset), PROT_READ, MAP_PRIVATE,
+               buffer->file, offset);
+  if (map == MAP_FAILED)
+    return;
+#ifdef HAVE_MADVISE
+  madvise((char*) map, (size_t) (file_size - offset), MADV_SEQUENTIAL);
+#endif
+  buffer->map= (char*) map;
+  buffer->map_length= (size_t) (file_size - offset);
+  buffer->map_pos= skip;
+  buffer->map_released= 0;
+}
+
+
+/*
+  Counterpart of intern_read_line() for mapped files. A line longer than
+  max_size, or than the uint bufread can hold, is returned in pieces,
+  with truncated set, like a line that doesn't fit into the buffer.
+*/
+
+static char *intern_read_mapped_line(LINE_BUFFER *buffer, ulong *out_length)
+{
+  char *start= buffer->map + buffer->map_pos;
+  char *end= buffer->map + buffer->map_length;
+  char *pos;
+  size_t length;
+  DBUG_ENTER("intern_read_mapped_line");
+
+  if (start == end)
+  {
+    buffer->eof= 1;
+    DBUG_RETURN(0);
+  }
+  if ((pos= (char*) memchr(start, '\n', (size_t) (end - start))))
+    length= (size_t) (pos + 1 - start);
+  else
+    length= (size_t) (end - start);             /* Last line without newline */
+
+  buffer->truncated= 0;
+  if (length > buffer->max_size || length >= UINT_MAX)
+  {
+    length= MY_MIN(buffer->max_size, (ulong) UINT_MAX - 1);
+    buffer->truncated= 1;
+  }
+  if (length >= buffer->bufread)
+  {
+    size_t bufread= buffer->bufread;
+    while (length >= bufread)
+      bufread= bufread > UINT_MAX / 2 ? UINT_MAX : bufread * 2;
+    if (!(buffer->buffer= (char*) my_realloc(buffer->buffer, bufread + 1,
+                                             MYF(MY_WME | MY_FAE))))
+    {
+      buffer->error= my_errno;
+      DBUG_RETURN(0);
+    }
+    buffer->bufread= (uint) bufread;
+  }
+  memcpy(buffer->buffer, start, length);
+  buffer->map_pos+= length;
+
+#ifdef HAVE_MADVISE
+  if (buffer->map_pos - buffer->map_released >= MAP_RELEASE_SIZE)
+  {
+    size_t release= (buffer->map_pos & ~((size_t) my_getpagesize() - 1)) -
+                    buffer->map_released;
+    madvise(buffer->map + buffer->map_released, release, MADV_DONTNEED);
+    buffer->map_released+= release;
+  }
+#endif
+
+  *out_length= (ulong) length;
+  DBUG_RETURN(buffer->buffer);
+}
+#endif /* MAP_INPUT_FILES */
@@ -0,0 +1,156 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Row encoder of mysqldump.
+
+  mysqldump used to build every value with a few dynamic string appends,
+  each checking the size of the buffer, and to decide per value how to
+  write it. Here the decision is taken per column, and a row costs one
+  size check for the worst case of all its values.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <m_ctype.h>
+#include "row_encoder.h"
+
+
+my_bool row_encoder_init(ROW_ENCODER *enc, uint columns, my_bool extended,
+                         row_escape_func escape, void *escape_arg)
+{
+  if (!(enc->encodings= (uchar*) my_malloc(MY_MAX(columns, 1), MYF(MY_WME))))
+    return 1;
+  bfill(enc->encodings, columns, ROW_ENC_STRING);
+  enc->columns= columns;
+  enc->extended= extended;
+  enc->escape= escape;
+  enc->escape_arg= escape_arg;
+  return 0;
+}
+
+
+/*
+  Choose the encoding of a column. hex is decided by the caller, which
+  knows which binary types --hex-blob applies to.
+*/
+
+void row_encoder_column(ROW_ENCODER *enc, uint column,
+                        const MYSQL_FIELD *field, my_bool hex)
+{
+  enum enum_row_encoding encoding;
+
+  if (field->flags & NUM_FLAG)
+    encoding= field->type == MYSQL_TYPE_DECIMAL ? ROW_ENC_DECIMAL :
+                                                  ROW_ENC_NUMBER;
+  else
+    encoding= hex ? ROW_ENC_HEX : ROW_ENC_STRING;
+  enc->encodings[column]= (uchar) encoding;
+}
+
+
+/*
+  Append a row to block.
+
+  RETURN
+    0  ok
+    1  out of memory
+*/
+
+my_bool row_encode(const ROW_ENCODER *enc, DYNAMIC_STRING *block,
+                   char **row, const ulong *lengths)
+{
+  size_t need= 3;                               /* ( ) \0 */
+  char *to;
+  uint i;
+
+  /* 2*length+1 for escaping, 2 for quotes or 0x, 1 for the separator */
+  for (i= 0; i < enc->columns; i++)
+    need+= lengths[i] * 2 + 5;
+  if (dynstr_realloc(block, need))
+    return 1;
+
+  to= block->str + block->length;
+  if (enc->extended)
+    *to++= '(';
+  for (i= 0; i < enc->columns; i++)
+  {
+    const char *value= row[i];
+    size_t length= lengths[i];
+
+    if (i)
+      *to++= ',';
+    if (!value)
+    {
+      to= strmov(to, "NULL");
+      continue;
+    }
+    if (!length && enc->extended)
+    {
+      *to++= '\'';
+      *to++= '\'';
+      continue;
+    }
+    switch ((enum enum_row_encoding) enc->encodings[i]) {
+    case ROW_ENC_NUMBER:
+    case ROW_ENC_DECIMAL:
+      /* change any strings ("inf", "-inf", "nan") into NULL */
+      if (my_isalpha(&my_charset_latin1, value[0]) ||
+          (value[0] == '-' && my_isalpha(&my_charset_latin1, value[1])))
+        to= strmov(to, "NULL");
+      else if (enc->encodings[i] == ROW_ENC_DECIMAL)
+      {
+        *to++= '\'';
+        memcpy(to, value, length);
+        to+= length;
+        *to++= '\'';
+      }
+      else
+      {
+        memcpy(to, value, length);
+        to+= length;
+      }
+      break;
+    case ROW_ENC_HEX:
+      if (length)
+      {
+        *to++= '0';
+        *to++= 'x';
+        to= bin2hex(to, (const uchar*) value, length);
+        break;
+      }
+      /* fall through */
+    case ROW_ENC_STRING:
+      *to++= '\'';
+      to+= enc->escape(enc->escape_arg, to, value, length);
+      *to++= '\'';
+      break;
+    }
+  }
+  if (enc->extended)
+    *to++= ')';
+  *to= '\0';
+  block->length= (size_t) (to - block->str);
+  return 0;
+}
+
+
+void row_encoder_free(ROW_ENCODER *enc)
+{
+  my_free(enc->encodings);
+  enc->encodings= NULL;
+}
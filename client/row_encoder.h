@@ -0,0 +1,68 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+#ifndef _row_encoder_h_
+#define _row_encoder_h_
+
+/*
+  Encoding of result rows as the values of the INSERT statements written
+  by mysqldump.
+
+  The encoding of each column is chosen once from its MYSQL_FIELD. A row
+  is then written with a single size check straight into the output
+  block, which the caller flushes when it has grown large enough.
+*/
+
+#include <my_sys.h>
+#include <mysql.h>
+
+C_MODE_START
+
+enum enum_row_encoding
+{
+  ROW_ENC_NUMBER,               /* as is, "inf" and "nan" become NULL */
+  ROW_ENC_DECIMAL,              /* as ROW_ENC_NUMBER, but quoted */
+  ROW_ENC_HEX,                  /* 0x..., '' when empty */
+  ROW_ENC_STRING                /* quoted and escaped */
+};
+
+/*
+  Escape length bytes of from into to, which has room for 2*length+1
+  bytes, and return the length written.
+*/
+typedef size_t (*row_escape_func)(void *arg, char *to, const char *from,
+                                  size_t length);
+
+typedef struct st_row_encoder
+{
+  uchar *encodings;             /* enum enum_row_encoding per column */
+  uint columns;
+  my_bool extended;             /* (v1,v2) for extended INSERT, else v1,v2 */
+  row_escape_func escape;
+  void *escape_arg;
+} ROW_ENCODER;
+
+my_bool row_encoder_init(ROW_ENCODER *enc, uint columns, my_bool extended,
+                         row_escape_func escape, void *escape_arg);
+void row_encoder_column(ROW_ENCODER *enc, uint column,
+                        const MYSQL_FIELD *field, my_bool hex);
+my_bool row_encode(const ROW_ENCODER *enc, DYNAMIC_STRING *block,
+                   char **row, const ulong *lengths);
+void row_encoder_free(ROW_ENCODER *enc);
+
+C_MODE_END
+
+#endif /* _row_encoder_h_ */
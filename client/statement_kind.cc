@@ -0,0 +1,377 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Statement classification for the mysql client.
+
+  The client used to run every statement through several POSIX regular
+  expressions to find the few it handles itself. The words looked at
+  here are the ones the expressions start with, so they are only run
+  on the statements that may match.
+*/
+
+#include <my_global.h>
+#include <m_string.h>
+#include "statement_kind.h"
+
+typedef struct st_statement_word
+{
+  const char *str;
+  size_t length;
+} STATEMENT_WORD;
+
+typedef struct st_statement_lexer
+{
+  const char *pos;
+  const char *end;
+} STATEMENT_LEXER;
+
+
+static inline bool is_word_char(uchar c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '$' || c >= 0x80;
+}
+
+
+static inline bool is_space_char(uchar c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+
+/* Skip white space and comments, like get_trim_comment_sql() */
+
+static void skip_space_and_comments(STATEMENT_LEXER *lex)
+{
+  const char *p= lex->pos, *end= lex->end;
+  for (;;)
+  {
+    while (p < end && is_space_char((uchar) *p))
+      p++;
+    if (p + 1 < end && p[0] == '/' && p[1] == '*')
+    {
+      for (p+= 2; p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/'); p++)
+      {}
+      p= p < end ? p + 2 : end;
+    }
+    else if (p + 1 < end && p[0] == '-' && p[1] == '-')
+    {
+      p= (const char*) memchr(p, '\n', end - p);
+      p= p ? p + 1 : end;
+    }
+    else
+      break;
+  }
+  lex->pos= p;
+}
+
+
+/* Read the next word, returns 0 if the next token is not a word */
+
+static bool next_word(STATEMENT_LEXER *lex, STATEMENT_WORD *word)
+{
+  const char *p;
+  skip_space_and_comments(lex);
+  for (p= lex->pos; p < lex->end && is_word_char((uchar) *p); p++)
+  {}
+  word->str= lex->pos;
+  word->length= (size_t) (p - lex->pos);
+  lex->pos= p;
+  return word->length != 0;
+}
+
+
+/* Case insensitive compare of a word with an upper case keyword */
+
+static bool word_is(const STATEMENT_WORD *word, const char *keyword)
+{
+  size_t i;
+  for (i= 0; i < word->length; i++)
+  {
+    uchar c= (uchar) word->str[i];
+    if (c >= 'a' && c <= 'z')
+      c-= 'a' - 'A';
+    if (c != (uchar) keyword[i])
+      return 0;
+  }
+  return keyword[i] == 0;
+}
+
+
+static bool word_starts_with(const STATEMENT_WORD *word, const char *keyword)
+{
+  size_t length= strlen(keyword);
+  STATEMENT_WORD prefix= { word->str, length };
+  return word->length >= length && word_is(&prefix, keyword);
+}
+
+
+static bool word_is_one_of(const STATEMENT_WORD *word, const char **keywords)
+{
+  for (; *keywords; keywords++)
+    if (word_is(word, *keywords))
+      return 1;
+  return 0;
+}
+
+
+/*
+  Object types after CREATE [OR REPLACE] and SHOW ERRORS. Types of two
+  words, like PACKAGE BODY or ANALYTIC VIEW, are told by the first one.
+*/
+static const char *pl_create_types[]=
+{
+  "VIEW", "PROCEDURE", "FUNCTION", "PACKAGE", "TRIGGER", "TYPE", "LIBRARY",
+  "QUEUE", "JAVA", "DIMENSION", "ASSEMBLY", "HIERARCHY", "ATTRIBUTE",
+  "ANALYTIC", NullS
+};
+
+static const char *pl_alter_types[]=
+{
+  "VIEW", "PROCEDURE", "FUNCTION", "PACKAGE", NullS
+};
+
+
+enum enum_statement_kind get_statement_kind(const char *str, size_t length)
+{
+  STATEMENT_LEXER lex= { str, str + length };
+  STATEMENT_WORD word;
+
+  skip_space_and_comments(&lex);
+  if (lex.pos + 1 < lex.end && lex.pos[0] == '<' && lex.pos[1] == '<')
+    return STATEMENT_KIND_PL_BLOCK;             /* <<label>> */
+  if (!next_word(&lex, &word))
+    return STATEMENT_KIND_OTHER;
+
+  switch (word.str[0]) {
+  case 'b': case 'B':
+    /* The pattern of a PL block does not end the word after BEGIN */
+    if (word_starts_with(&word, "BEGIN"))
+      return STATEMENT_KIND_PL_BLOCK;
+    break;
+  case 'd': case 'D':
+    if (word_starts_with(&word, "DECLARE"))
+      return STATEMENT_KIND_PL_BLOCK;
+    break;
+  case 's': case 'S':
+    if (word_is(&word, "SET"))
+      return STATEMENT_KIND_SET;
+    if (word_is(&word, "SHOW") && next_word(&lex, &word) &&
+        word_starts_with(&word, "ERR"))
+      return STATEMENT_KIND_SHOW_ERRORS;
+    break;
+  case 'c': case 'C':
+    if (word_is(&word, "COLUMN"))
+      return STATEMENT_KIND_COLUMN;
+    if (word_is(&word, "CREATE") && next_word(&lex, &word))
+    {
+      if (word_is(&word, "OR") &&
+          !(next_word(&lex, &word) && word_is(&word, "REPLACE") &&
+            next_word(&lex, &word)))
+        break;
+      if (word_is_one_of(&word, pl_create_types))
+        return STATEMENT_KIND_CREATE_PL;
+    }
+    break;
+  case 'a': case 'A':
+    if (word_is(&word, "ALTER") && next_word(&lex, &word) &&
+        word_is_one_of(&word, pl_alter_types))
+      return STATEMENT_KIND_ALTER_PL;
+    break;
+  }
+  return STATEMENT_KIND_OTHER;
+}
+
+
+size_t statement_delimiter_offset(const char *str, size_t length)
+{
+  const char *p= str, *end= str + length;
+
+  while (p < end)
+  {
+    switch (*p) {
+    case ';':
+      return (size_t) (p - str);
+    case '\'':
+    case '"':
+    case '`':
+    {
+      char quote= *p;
+      for (p++; p < end && *p != quote; p++)
+      {
+        if (*p == '\\' && quote != '`' && p + 1 < end)
+          p++;
+      }
+      p= p < end ? p + 1 : end;
+      break;
+    }
+    case '-':
+      /* The server wants a space after -- */
+      if (!(p + 2 < end && p[1] == '-' && is_space_char((uchar) p[2])))
+      {
+        p++;
+        break;
+      }
+      /* fall through */
+    case '#':
+      p= (const char*) memchr(p, '\n', end - p);
+      p= p ? p + 1 : end;
+      break;
+    case '/':
+      if (p + 1 < end && p[1] == '*')
+      {
+        for (p+= 2; p + 1 < end && !(p[0] == '*' && p[1] == '/'); p++)
+        {}
+        p= p + 1 < end ? p + 2 : end;
+      }
+      else
+        p++;
+      break;
+    default:
+      p++;
+    }
+  }
+  return length;
+}
+
+
+/* Skip a '' string, with its escapes. Return NULL if it is not closed. */
+
+static const char *skip_string(const char *p, const char *end)
+{
+  for (p++; p < end; p++)
+  {
+    if (*p == '\\' && p + 1 < end)
+      p++;
+    else if (*p == '\'')
+    {
+      if (p + 1 == end || p[1] != '\'')
+        return p + 1;
+      p++;                                      /* '' in the string */
+    }
+  }
+  return NULL;
+}
+
+
+static inline bool is_digit_char(uchar c)
+{
+  return c >= '0' && c <= '9';
+}
+
+
+static inline bool is_hex_char(uchar c)
+{
+  return is_digit_char(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+
+static const char *skip_digits(const char *p, const char *end)
+{
+  while (p < end && is_digit_char((uchar) *p))
+    p++;
+  return p;
+}
+
+
+/* Skip a literal that is not a string. Return NULL if there is none. */
+
+static const char *skip_literal(const char *p, const char *end)
+{
+  static const char *words[]= {"NULL", "TRUE", "FALSE", "DEFAULT", NullS};
+  STATEMENT_WORD word;
+  const char *start;
+
+  if (p + 1 < end && *p && strchr("xXbB", *p) && p[1] == '\'')
+  {
+    /* X'0F' or B'01' */
+    for (p+= 2; p < end && is_hex_char((uchar) *p); p++)
+    {}
+    return p < end && *p == '\'' ? p + 1 : NULL;
+  }
+  if (p + 1 < end && *p == '0' && p[1] && strchr("xXbB", p[1]))
+  {
+    /* 0x0F or 0b01 */
+    for (start= p+= 2; p < end && is_hex_char((uchar) *p); p++)
+    {}
+    return p > start && (p == end || !is_word_char((uchar) *p)) ? p : NULL;
+  }
+  while (p < end && (*p == '-' || *p == '+'))
+    p++;
+  start= p;
+  p= skip_digits(p, end);
+  if (p < end && *p == '.')
+    p= skip_digits(p + 1, end);
+  if (p > start && !(p - start == 1 && *start == '.'))
+  {
+    /* A number, maybe with an exponent */
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      if (++p < end && (*p == '-' || *p == '+'))
+        p++;
+      if (p == end || !is_digit_char((uchar) *p))
+        return NULL;
+      p= skip_digits(p, end);
+    }
+    return p == end || !is_word_char((uchar) *p) ? p : NULL;
+  }
+  if (p != start)
+    return NULL;
+  for (; p < end && is_word_char((uchar) *p); p++)
+  {}
+  word.str= start;
+  word.length= (size_t) (p - start);
+  return word.length && word_is_one_of(&word, words) ? p : NULL;
+}
+
+
+bool statement_row_is_literals(const char *row, size_t length)
+{
+  const char *p= row, *end= row + length;
+
+  if (!length || *p++ != '(')
+    return 0;
+  for (;;)
+  {
+    while (p < end && is_space_char((uchar) *p))
+      p++;
+    if (p < end && *p == '\'')
+    {
+      /* 'a' 'b' is one string */
+      while (p < end && *p == '\'')
+      {
+        if (!(p= skip_string(p, end)))
+          return 0;
+        while (p < end && is_space_char((uchar) *p))
+          p++;
+      }
+    }
+    else
+    {
+      if (!(p= skip_literal(p, end)))
+        return 0;
+      while (p < end && is_space_char((uchar) *p))
+        p++;
+    }
+    if (p == end)
+      return 0;
+    if (*p == ')')
+      return p + 1 == end;
+    if (*p++ != ',')
+      return 0;
+  }
+}
@@ -0,0 +1,75 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+#ifndef _statement_kind_h_
+#define _statement_kind_h_
+
+/*
+  Kind of a statement as told by its leading keywords.
+
+  The kind says which of the client side handlers may apply to the
+  statement. It is a filter: a statement matched by the pattern of a
+  handler always gets the kind of that handler, but a statement of some
+  kind is not always accepted by its handler, which still parses it.
+*/
+
+enum enum_statement_kind
+{
+  STATEMENT_KIND_OTHER= 0,
+  STATEMENT_KIND_SET,           /* SET name value */
+  STATEMENT_KIND_COLUMN,        /* COLUMN c FORMAT f */
+  STATEMENT_KIND_SHOW_ERRORS,   /* SHOW ERR[OR[S]] ... */
+  STATEMENT_KIND_CREATE_PL,     /* CREATE [OR REPLACE] PROCEDURE ... */
+  STATEMENT_KIND_ALTER_PL,      /* ALTER VIEW|PROCEDURE|FUNCTION|PACKAGE */
+  STATEMENT_KIND_PL_BLOCK       /* [<<label>>] BEGIN|DECLARE ... */
+};
+
+/*
+  Leading comments and white space are skipped, and only as many words
+  as needed to tell the kind are looked at, so the cost does not depend
+  on the length of the statement.
+*/
+enum enum_statement_kind get_statement_kind(const char *str, size_t length);
+
+/*
+  Delimiter written after each statement packed into one query by
+  --pack-statements. The statements keep their trailing -- and # comments,
+  which the new line ends before the ';'.
+*/
+#define PACKED_STATEMENT_END "\n;\n"
+#define PACKED_STATEMENT_END_LENGTH 3
+
+/*
+  Offset of the first ';' that is not in a comment, a string or a quoted
+  name, or length if there is none.
+*/
+size_t statement_delimiter_offset(const char *str, size_t length);
+
+/*
+  True if row, a parenthesized row of INSERT ... VALUES, holds nothing
+  but literals: '' strings, numbers, hex and bit values, NULL, TRUE,
+  FALSE and DEFAULT. Such a row means the same whatever rows are sent
+  with it, which is not so for functions, variables or column names.
+*/
+bool statement_row_is_literals(const char *row, size_t length);
+
+/* True if the statement may be a PL block to be sent as a whole */
+static inline bool statement_kind_is_pl(enum enum_statement_kind kind)
+{
+  return kind == STATEMENT_KIND_PL_BLOCK || kind == STATEMENT_KIND_CREATE_PL;
+}
+
+#endif /* _statement_kind_h_ */
@@ -78,6 +78,9 @@ extern const char _dig_vec_lower[];
 
 extern char *strmov_overlapp(char *dest, const char *src);
 
+/* Upper case hex digits of from, 2*length of them, not null terminated */
+extern char *bin2hex(char *to, const uchar *from, size_t length);
+
 #if defined(_lint) || defined(FORCE_INIT_OF_VARS)
 #define LINT_INIT_STRUCT(var) bzero(&var, sizeof(var)) /* No uninitialize-warning */
 #else
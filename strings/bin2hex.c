@@ -0,0 +1,132 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  bin2hex(to, from, length)
+
+  Write the bytes of from as upper case hex digits, two per byte, to
+  to. The result is not null terminated; the end of it is returned.
+
+  Clients print BLOB and RAW values this way, which makes the encoding
+  the main cost of dumping tables with large binary columns. On x86_64
+  the nibbles of 16 (SSE2) or 32 (AVX2) bytes are turned into digits at
+  once; the rest, and other platforms, use the table in int2str.c.
+*/
+
+#include "strings_def.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && MY_GNUC_PREREQ(4, 9)
+#define HAVE_BIN2HEX_SIMD
+#include <immintrin.h>
+#endif
+
+static char *bin2hex_scalar(char *to, const uchar *from, size_t length)
+{
+  const uchar *end= from + length;
+  for (; from < end; from++)
+  {
+    *to++= _dig_vec_upper[*from >> 4];
+    *to++= _dig_vec_upper[*from & 15];
+  }
+  return to;
+}
+
+#ifdef HAVE_BIN2HEX_SIMD
+
+/*
+  Digits of 16 nibbles: '0' + n, and 7 more to get from ':' to 'A'
+  for the nibbles above 9.
+*/
+static inline __m128i nibbles2hex_sse2(__m128i n)
+{
+  __m128i above9= _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+  n= _mm_add_epi8(n, _mm_set1_epi8('0'));
+  return _mm_add_epi8(n, _mm_and_si128(above9, _mm_set1_epi8(7)));
+}
+
+static char *bin2hex_sse2(char *to, const uchar *from, size_t length)
+{
+  const __m128i low4= _mm_set1_epi8(0x0F);
+  const uchar *end= from + (length & ~(size_t) 15);
+
+  for (; from < end; from+= 16, to+= 32)
+  {
+    __m128i v=  _mm_loadu_si128((const __m128i*) from);
+    __m128i hi= nibbles2hex_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), low4));
+    __m128i lo= nibbles2hex_sse2(_mm_and_si128(v, low4));
+    _mm_storeu_si128((__m128i*) to, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i*) (to + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+  return bin2hex_scalar(to, from, length & 15);
+}
+
+__attribute__((target("avx2")))
+static char *bin2hex_avx2(char *to, const uchar *from, size_t length)
+{
+  const __m256i low4= _mm256_set1_epi8(0x0F);
+  const __m256i digits= _mm256_setr_epi8('0','1','2','3','4','5','6','7',
+                                         '8','9','A','B','C','D','E','F',
+                                         '0','1','2','3','4','5','6','7',
+                                         '8','9','A','B','C','D','E','F');
+  const uchar *end= from + (length & ~(size_t) 31);
+
+  for (; from < end; from+= 32, to+= 64)
+  {
+    __m256i v=  _mm256_loadu_si256((const __m256i*) from);
+    __m256i hi= _mm256_shuffle_epi8(digits,
+                  _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+    __m256i lo= _mm256_shuffle_epi8(digits, _mm256_and_si256(v, low4));
+    /* The unpacks work within each 128 bit lane; put the lanes in order */
+    __m256i a= _mm256_unpacklo_epi8(hi, lo);
+    __m256i b= _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i*) to, _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i*) (to + 32),
+                        _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  return bin2hex_sse2(to, from, length & 31);
+}
+
+typedef char *(*bin2hex_func)(char *, const uchar *, size_t);
+
+static char *bin2hex_first(char *to, const uchar *from, size_t length);
+
+/*
+  Set on the first call. Threads racing on it all store the same value.
+*/
+static bin2hex_func bin2hex_impl= bin2hex_first;
+
+static char *bin2hex_first(char *to, const uchar *from, size_t length)
+{
+  __builtin_cpu_init();
+  bin2hex_impl= __builtin_cpu_supports("avx2") ? bin2hex_avx2 : bin2hex_sse2;
+  return bin2hex_impl(to, from, length);
+}
+
+#endif /* HAVE_BIN2HEX_SIMD */
+
+
+char *bin2hex(char *to, const uchar *from, size_t length)
+{
+  /* Not worth a call through the pointer for short values */
+  if (length < 16)
+    return bin2hex_scalar(to, from, length);
+#ifdef HAVE_BIN2HEX_SIMD
+  return bin2hex_impl(to, from, length);
+#else
+  return bin2hex_scalar(to, from, length);
+#endif
+}
+
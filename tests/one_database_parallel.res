@@ -0,0 +1,56 @@
+--------------
+drop database if exists one_database_other
+--------------
+
+--------------
+create database one_database_other
+--------------
+
+--------------
+create table one_database_other.t1 (a int)
+--------------
+
+--------------
+drop table if exists t1
+--------------
+
+--------------
+create table t1 (a int)
+--------------
+
+--------------
+insert into t1 values (1),(2),(3)
+--------------
+
+--------------
+delete from t1
+--------------
+
+--------------
+drop table t1
+--------------
+
+--------------
+insert into t1 values (1),(2)
+--------------
+
+--------------
+select count(*) from t1
+--------------
+
+count(*)
+2
+--------------
+select count(*) from one_database_other.t1
+--------------
+
+count(*)
+0
+--------------
+drop table t1
+--------------
+
+--------------
+drop database one_database_other
+--------------
+
@@ -0,0 +1,20 @@
+# Test of --one-database with --parallel: the statements ignored for
+# another database must not reach the workers either
+#
+# mysql -v --one-database --parallel=4 test < this_file
+
+drop database if exists one_database_other;
+create database one_database_other;
+create table one_database_other.t1 (a int);
+drop table if exists t1;
+create table t1 (a int);
+use one_database_other
+insert into t1 values (1),(2),(3);
+delete from t1;
+drop table t1;
+use test
+insert into t1 values (1),(2);
+select count(*) from t1;
+select count(*) from one_database_other.t1;
+drop table t1;
+drop database one_database_other;
@@ -0,0 +1,128 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Tests of the word index used by the tab completion of the mysql client.
+  Built with BENCHMARK, as the completion_hash-bench target is, it also
+  times building and searching it with one million names.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <tap.h>
+#include "completion_hash.h"
+
+static bool matches_are(COMPLETION_INDEX *ci, const char *prefix,
+                        const char **expected, uint count)
+{
+  uint first, found= find_all_matches(ci, prefix, (uint) strlen(prefix),
+                                      &first);
+  if (found != count)
+    return 0;
+  for (uint i= 0; i < count; i++)
+    if (strcmp(ci->words[first + i], expected[i]))
+      return 0;
+  return 1;
+}
+
+
+static void test_matches()
+{
+  COMPLETION_INDEX ci;
+  const char *words[]= { "select", "t1", "t1.a", "t1.b", "t10", "t1", "a" };
+  const char *t1[]= { "t1", "t1.a", "t1.b", "t10" };
+  const char *t1_dot[]= { "t1.a", "t1.b" };
+  const char *all[]= { "a", "select", "t1", "t1.a", "t1.b", "t10" };
+
+  completion_index_init(&ci);
+  for (uint i= 0; i < array_elements(words); i++)
+    add_word(&ci, words[i]);
+
+  ok(matches_are(&ci, "t1", t1, array_elements(t1)), "prefix t1");
+  ok(matches_are(&ci, "t1.", t1_dot, array_elements(t1_dot)), "prefix t1.");
+  ok(matches_are(&ci, "", all, array_elements(all)),
+     "empty prefix gives every word once");
+  ok(matches_are(&ci, "t2", NULL, 0), "no match");
+  ok(matches_are(&ci, "select1", NULL, 0), "prefix longer than word");
+
+  add_word(&ci, "t11");
+  ok(ci.sorted != ci.count, "added word is not sorted yet");
+  {
+    const char *t11[]= { "t11" };
+    ok(matches_are(&ci, "t11", t11, 1), "word added after a search");
+  }
+
+  completion_index_clean(&ci);
+  ok(matches_are(&ci, "", NULL, 0), "clean empties the index");
+  completion_index_free(&ci);
+}
+
+
+#ifdef BENCHMARK
+
+#define BENCH_WORDS 1000000
+
+static void bench_index()
+{
+  COMPLETION_INDEX ci;
+  ulonglong start, built, searched;
+  uint first, found= 0;
+  char name[64];
+
+  completion_index_init(&ci);
+  start= my_interval_timer();
+  for (uint i= 0; i < BENCH_WORDS; i++)
+  {
+    /* Like "table_123.column_45", in a scattered order */
+    uint n= (uint) ((i * 2654435761ULL) % BENCH_WORDS);
+    my_snprintf(name, sizeof(name), "table_%u.column_%u", n / 20, n % 20);
+    add_word(&ci, name);
+  }
+  completion_index_sort(&ci);
+  built= my_interval_timer();
+  for (uint i= 0; i < 10000; i++)
+  {
+    my_snprintf(name, sizeof(name), "table_%u.", (i * 7) % (BENCH_WORDS / 20));
+    found+= find_all_matches(&ci, name, (uint) strlen(name), &first);
+  }
+  searched= my_interval_timer();
+
+  ok(ci.count == BENCH_WORDS && found == 10000 * 20,
+     "%u words indexed, %u matches found", ci.count, found);
+  diag("build: %llu ms, 10000 prefix searches: %llu ms",
+       (built - start) / 1000000, (searched - built) / 1000000);
+  completion_index_free(&ci);
+}
+
+#endif /* BENCHMARK */
+
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  MY_INIT(argv[0]);
+#ifdef BENCHMARK
+  plan(9);
+#else
+  plan(8);
+#endif
+  test_matches();
+#ifdef BENCHMARK
+  bench_index();
+#endif
+  my_end(0);
+  return exit_status();
+}
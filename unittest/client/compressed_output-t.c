@@ -0,0 +1,158 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Tests of the compressed output of mysqldump: the frames written by
+  several compressor threads must come out in order, and each must be
+  found and decompressed from its own header.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <zlib.h>
+#include <tap.h>
+#include "compressed_output.h"
+
+#define TEST_LENGTH (5 * COMPRESS_FRAME_SIZE + 12345)
+
+static uchar *make_data(void)
+{
+  uchar *data= (uchar*) my_malloc(TEST_LENGTH, MYF(MY_FAE));
+  uint32 seed= 1;
+  size_t i;
+  for (i= 0; i < TEST_LENGTH; i++)
+  {
+    seed= seed * 1103515245 + 12345;
+    data[i]= "INSERT (0,'a');\n"[(seed >> 16) & 15];
+  }
+  return data;
+}
+
+
+/* Write data in pieces of varying size, and return the file read back */
+
+static uchar *write_compressed(const uchar *data, size_t *length)
+{
+  FILE *file= tmpfile(), *stream;
+  uchar *packed;
+  size_t pos, piece;
+  long size;
+
+  if (!file || !(stream= compressed_output_open(file, FALSE)))
+    return NULL;
+  for (pos= 0, piece= 1; pos < TEST_LENGTH; pos+= piece, piece= piece * 3 + 1)
+  {
+    piece= MY_MIN(piece % 100000, TEST_LENGTH - pos);
+    fwrite(data + pos, 1, piece, stream);
+  }
+  if (compressed_output_close(stream))
+    return NULL;
+  size= ftell(file);
+  packed= (uchar*) my_malloc(size, MYF(MY_FAE));
+  rewind(file);
+  if (fread(packed, 1, size, file) != (size_t) size)
+    return NULL;
+  fclose(file);
+  *length= (size_t) size;
+  return packed;
+}
+
+
+/*
+  Walk the gzip members by the sizes in their 'MD' extra field and
+  inflate each on its own. Return the number of frames, 0 on error.
+*/
+
+static uint check_frames(const uchar *packed, size_t length,
+                         const uchar *data)
+{
+  size_t pos= 0, data_pos= 0;
+  uint frames= 0;
+  uchar *out= (uchar*) my_malloc(COMPRESS_FRAME_SIZE, MYF(MY_FAE));
+
+  while (pos < length)
+  {
+    const uchar *member= packed + pos;
+    uint32 member_length, data_length;
+    uLongf out_length= COMPRESS_FRAME_SIZE;
+    z_stream zs;
+
+    if (member[0] != 0x1f || member[1] != 0x8b || !(member[3] & 4) ||
+        member[12] != 'M' || member[13] != 'D')
+      break;
+    member_length= uint4korr(member + 16);
+    data_length= uint4korr(member + 20);
+
+    bzero(&zs, sizeof(zs));
+    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+      break;
+    zs.next_in= (Bytef*) member;
+    zs.avail_in= member_length;
+    zs.next_out= out;
+    zs.avail_out= (uInt) out_length;
+    if (inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.total_out != data_length ||
+        data_pos + data_length > TEST_LENGTH ||
+        memcmp(out, data + data_pos, data_length))
+    {
+      inflateEnd(&zs);
+      break;
+    }
+    inflateEnd(&zs);
+    pos+= member_length;
+    data_pos+= data_length;
+    frames++;
+  }
+  my_free(out);
+  return pos == length && data_pos == TEST_LENGTH ? frames : 0;
+}
+
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  COMPRESS_OPTIONS opts;
+  uchar *data, *packed;
+  size_t length= 0;
+  MY_INIT(argv[0]);
+
+  plan(4);
+  ok(compress_options_parse(&opts, "zstd:0") != NULL &&
+     compress_options_parse(&opts, "lz4") != NULL &&
+     compress_options_parse(&opts, "gzip:10") != NULL, "bad methods");
+  if (compress_options_parse(&opts, "gzip:1"))
+  {
+    skip(3, "no compressed output on this platform");
+    my_end(0);
+    return exit_status();
+  }
+  ok(opts.method == COMPRESS_GZIP && opts.level == 1 &&
+     !strcmp(compress_extension(&opts), ".gz"), "gzip:1");
+
+  opts.threads= 3;
+  data= make_data();
+  if (compress_threads_start(&opts))
+    BAIL_OUT("Could not start the compressor threads");
+  packed= write_compressed(data, &length);
+  ok(packed != NULL, "write %u bytes", (uint) TEST_LENGTH);
+  ok(packed && check_frames(packed, length, data) == 6,
+     "6 frames in order, %u bytes", (uint) length);
+  compress_threads_end();
+
+  my_free(packed);
+  my_free(data);
+  my_end(0);
+  return exit_status();
+}
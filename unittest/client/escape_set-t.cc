@@ -0,0 +1,111 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Tests of the escape scan of the result printers of the mysql client.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <tap.h>
+#include "escape_set.h"
+
+static ESCAPE_SET tab_escapes, xml_escapes;
+
+static const char *naive_find(const ESCAPE_SET *set, const char *pos,
+                              const char *end)
+{
+  for (; pos < end; pos++)
+    if (set->member[(uchar) *pos])
+      return pos;
+  return end;
+}
+
+
+/*
+  Compare with a byte by byte search for every length up to a few words,
+  at every alignment, with each member of the set at each position.
+*/
+
+static int test_positions(const ESCAPE_SET *set, const char *chars,
+                          uint count)
+{
+  char buff[96];
+  uint offset, length, at, i;
+
+  for (offset= 0; offset < 8; offset++)
+  {
+    for (length= 0; length <= 80; length++)
+    {
+      for (at= 0; at <= length; at++)
+      {
+        for (i= 0; i < count; i++)
+        {
+          const char *begin= buff + offset, *end= begin + length;
+          memset(buff, 'a', sizeof(buff));
+          if (at < length)
+            buff[offset + at]= chars[i];
+          if (find_escape_char(set, begin, end) != naive_find(set, begin, end))
+          {
+            diag("offset %u length %u byte %u at %u", offset, length,
+                 (uint) (uchar) chars[i], at);
+            return 1;
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+
+/* Bytes that are next to the members, or members plus 0x80 */
+
+static int test_near_misses(const ESCAPE_SET *set)
+{
+  char buff[64];
+  uint c;
+
+  for (c= 0; c < 256; c++)
+  {
+    const char *end= buff + sizeof(buff);
+    memset(buff, c, sizeof(buff));
+    if (find_escape_char(set, buff, end) != naive_find(set, buff, end))
+    {
+      diag("byte %u", c);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  MY_INIT(argv[0]);
+  init_escape_set(&tab_escapes, "\0\t\n\\", 4);
+  init_escape_set(&xml_escapes, "&<>\"\0", 5);
+
+  plan(4);
+  ok(!test_positions(&tab_escapes, "\0\t\n\\", 4), "tab escapes");
+  ok(!test_positions(&xml_escapes, "&<>\"\0", 5), "xml escapes");
+  ok(!test_near_misses(&tab_escapes), "bytes near the tab escapes");
+  ok(!test_near_misses(&xml_escapes), "bytes near the xml escapes");
+
+  my_end(0);
+  return exit_status();
+}
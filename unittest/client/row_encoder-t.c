@@ -0,0 +1,259 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Tests of the row encoder of mysqldump. Built with BENCHMARK, as the
+  row_encoder-bench target is, it also times the encoder against the way
+  mysqldump built extended INSERT rows before.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <m_ctype.h>
+#include <tap.h>
+#include "row_encoder.h"
+
+#define COLUMNS 5
+
+static MYSQL_FIELD fields[COLUMNS];
+
+
+static size_t escape(void *arg __attribute__((unused)), char *to,
+                     const char *from, size_t length)
+{
+  return escape_string_for_mysql(&my_charset_latin1, to, 0, from, length);
+}
+
+
+/* int, old decimal, text, blob with --hex-blob, text */
+static void init_fields()
+{
+  bzero((char*) fields, sizeof(fields));
+  fields[0].type= MYSQL_TYPE_LONG;
+  fields[0].flags= NUM_FLAG;
+  fields[1].type= MYSQL_TYPE_DECIMAL;
+  fields[1].flags= NUM_FLAG;
+  fields[2].type= MYSQL_TYPE_VAR_STRING;
+  fields[2].charsetnr= 8;
+  fields[3].type= MYSQL_TYPE_BLOB;
+  fields[3].charsetnr= 63;
+  fields[4].type= MYSQL_TYPE_VAR_STRING;
+  fields[4].charsetnr= 8;
+}
+
+
+static void init_encoder(ROW_ENCODER *enc, my_bool extended)
+{
+  uint i;
+  row_encoder_init(enc, COLUMNS, extended, escape, NULL);
+  for (i= 0; i < COLUMNS; i++)
+    row_encoder_column(enc, i, fields + i, i == 3);
+}
+
+
+static const char *encode(ROW_ENCODER *enc, DYNAMIC_STRING *block,
+                          const char *c0, const char *c1, const char *c2,
+                          const char *c3, const char *c4)
+{
+  char *row[COLUMNS];
+  ulong lengths[COLUMNS];
+  uint i;
+
+  row[0]= (char*) c0; row[1]= (char*) c1; row[2]= (char*) c2;
+  row[3]= (char*) c3; row[4]= (char*) c4;
+  for (i= 0; i < COLUMNS; i++)
+    lengths[i]= row[i] ? (ulong) strlen(row[i]) : 0;
+  block->length= 0;
+  row_encode(enc, block, row, lengths);
+  return block->str;
+}
+
+
+static void test_encodings()
+{
+  ROW_ENCODER enc;
+  DYNAMIC_STRING block;
+
+  init_dynamic_string(&block, "", 16, 16);
+  init_encoder(&enc, TRUE);
+  ok(!strcmp(encode(&enc, &block, "1", "2.5", "it's", "\x01\xAB", "a\\b"),
+             "(1,'2.5','it\\'s',0x01AB,'a\\\\b')"), "extended row");
+  ok(!strcmp(encode(&enc, &block, NULL, "", "", "", NULL),
+             "(NULL,'','','',NULL)"), "extended NULL and empty values");
+  ok(!strcmp(encode(&enc, &block, "-inf", "nan", "x\ny", "z", "\"\r"),
+             "(NULL,NULL,'x\\ny',0x7A,'\\\"\\r')"),
+     "extended infinities and special characters");
+  row_encoder_free(&enc);
+
+  init_encoder(&enc, FALSE);
+  ok(!strcmp(encode(&enc, &block, "1", "2.5", "it's", "\x01\xAB", "a"),
+             "1,'2.5','it\\'s',0x01AB,'a'"), "plain row");
+  ok(!strcmp(encode(&enc, &block, NULL, "", "", "", NULL),
+             "NULL,'','','',NULL"), "plain NULL and empty values");
+  row_encoder_free(&enc);
+  dynstr_free(&block);
+}
+
+
+#ifdef BENCHMARK
+
+#define BENCH_ROWS 500000
+
+/* The extended INSERT row of mysqldump before the row encoder */
+
+static void old_encode(DYNAMIC_STRING *row_buf, char **row, ulong *lengths)
+{
+  uint i;
+  for (i= 0; i < COLUMNS; i++)
+  {
+    ulong length= lengths[i];
+    if (i == 0)
+      dynstr_set(row_buf, "(");
+    else
+      dynstr_append(row_buf, ",");
+    if (row[i])
+    {
+      if (length)
+      {
+        if (!(fields[i].flags & NUM_FLAG))
+        {
+          dynstr_realloc(row_buf, length * 2 + 2 + 1);
+          if (i == 3)
+          {
+            const uchar *pos= (const uchar*) row[i];
+            char *to;
+            dynstr_append(row_buf, "0x");
+            to= row_buf->str + row_buf->length;
+            for (; pos < (const uchar*) row[i] + length; pos++)
+            {
+              *to++= _dig_vec_upper[*pos >> 4];
+              *to++= _dig_vec_upper[*pos & 15];
+            }
+            *to= '\0';
+            row_buf->length= (size_t) (to - row_buf->str);
+          }
+          else
+          {
+            dynstr_append(row_buf, "'");
+            row_buf->length+= escape(NULL, row_buf->str + row_buf->length,
+                                     row[i], length);
+            row_buf->str[row_buf->length]= '\0';
+            dynstr_append(row_buf, "'");
+          }
+        }
+        else
+        {
+          char *ptr= row[i];
+          if (my_isalpha(&my_charset_latin1, *ptr) ||
+              (*ptr == '-' && my_isalpha(&my_charset_latin1, ptr[1])))
+            dynstr_append(row_buf, "NULL");
+          else if (fields[i].type == MYSQL_TYPE_DECIMAL)
+          {
+            dynstr_append(row_buf, "'");
+            dynstr_append(row_buf, ptr);
+            dynstr_append(row_buf, "'");
+          }
+          else
+            dynstr_append(row_buf, ptr);
+        }
+      }
+      else
+        dynstr_append(row_buf, "''");
+    }
+    else
+      dynstr_append(row_buf, "NULL");
+  }
+  dynstr_append(row_buf, ")");
+}
+
+
+static void bench_encoders()
+{
+  ROW_ENCODER enc;
+  DYNAMIC_STRING old_out, old_row, new_out;
+  char c0[16], c1[16], c2[64], c3[32];
+  char *row[COLUMNS];
+  ulong lengths[COLUMNS];
+  ulonglong start, old_done, new_done;
+  uint i;
+
+  init_dynamic_string(&old_out, "", 1024*1024, 1024*1024);
+  init_dynamic_string(&old_row, "", 1024, 1024);
+  init_dynamic_string(&new_out, "", 1024*1024, 1024*1024);
+  init_encoder(&enc, TRUE);
+  memset(c3, 0xA5, sizeof(c3));
+  row[0]= c0; row[1]= c1; row[2]= c2; row[3]= c3; row[4]= NULL;
+
+  start= my_interval_timer();
+  for (i= 0; i < BENCH_ROWS; i++)
+  {
+    lengths[0]= my_snprintf(c0, sizeof(c0), "%u", i);
+    lengths[1]= my_snprintf(c1, sizeof(c1), "%u.%02u", i / 100, i % 100);
+    lengths[2]= my_snprintf(c2, sizeof(c2), "customer %u's 'quoted' name", i);
+    lengths[3]= sizeof(c3);
+    lengths[4]= 0;
+    old_encode(&old_row, row, lengths);
+    /* what fputc(',') and fputs() of the row did */
+    dynstr_append_mem(&old_out, ",", 1);
+    dynstr_append_mem(&old_out, old_row.str, old_row.length);
+  }
+  old_done= my_interval_timer();
+  for (i= 0; i < BENCH_ROWS; i++)
+  {
+    lengths[0]= my_snprintf(c0, sizeof(c0), "%u", i);
+    lengths[1]= my_snprintf(c1, sizeof(c1), "%u.%02u", i / 100, i % 100);
+    lengths[2]= my_snprintf(c2, sizeof(c2), "customer %u's 'quoted' name", i);
+    lengths[3]= sizeof(c3);
+    lengths[4]= 0;
+    dynstr_append_mem(&new_out, ",", 1);
+    row_encode(&enc, &new_out, row, lengths);
+  }
+  new_done= my_interval_timer();
+
+  ok(old_out.length == new_out.length &&
+     !memcmp(old_out.str, new_out.str, old_out.length),
+     "%u rows encoded the same way", BENCH_ROWS);
+  diag("%lu bytes; old: %llu ms, row encoder: %llu ms",
+       (ulong) new_out.length, (old_done - start) / 1000000,
+       (new_done - old_done) / 1000000);
+  row_encoder_free(&enc);
+  dynstr_free(&old_out);
+  dynstr_free(&old_row);
+  dynstr_free(&new_out);
+}
+
+#endif /* BENCHMARK */
+
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  MY_INIT(argv[0]);
+  init_fields();
+
+#ifdef BENCHMARK
+  plan(6);
+#else
+  plan(5);
+#endif
+  test_encodings();
+#ifdef BENCHMARK
+  bench_encoders();
+#endif
+
+  my_end(0);
+  return exit_status();
+}
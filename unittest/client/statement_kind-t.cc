@@ -0,0 +1,432 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+/*
+  Tests of the statement classification of the mysql client, checked
+  against the regular expressions of mysql.cc it filters for. Built with
+  BENCHMARK, as the statement_kind-bench target is, it also times both on
+  a mix of ordinary statements, and the PL block check on a long package
+  as the client reads it line by line.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+#include <tap.h>
+#include "pcreposix.h"
+#include "statement_kind.h"
+
+/* Copies of the patterns in init_width_and_format_for_result_value() and init_pl_sql() */
+static const char *column_format_re_str=
+  "^("
+  "[[:space:]]*COLUMN[[:space:]]+([[:alnum:]_])[[:space:]]+"
+  "FORMAT[[:space:]]+([[:alnum:]_])[[:space:]]*)";
+
+static const char *pl_create_sql_re_str=
+  "^("
+  "[[:space:]]*CREATE[[:space:]]+(OR[[:space:]]+REPLACE[[:space:]]+)?"
+  "(VIEW|PROCEDURE|FUNCTION|PACKAGE([[:space:]]+BODY)?|TRIGGER|TYPE([[:space:]]+BODY)?|LIBRARY|QUEUE|JAVA[[:space:]]+(SOURCE|CLASS)|DIMENSION|ASSEMBLY|HIERARCHY|ATTRIBUTE[[:space:]]+DIMENSION|ANALYTIC VIEW)[[:space:]]+"
+  "(([[:alnum:]$_]+)\\.|\\\"([^\"]*)\\\"\\.)?[[:space:]]*"
+  "(([[:alnum:]$_]+)|\\\"([^\"]*)\\\")?[[:space:]]*"
+  ")";
+
+static const char *pl_alter_sql_re_str=
+  "^("
+  "[[:space:]]*ALTER[[:space:]]+"
+  "(VIEW|PROCEDURE|FUNCTION|PACKAGE)[[:space:]]+"
+  "(([[:alnum:]$_]+)\\.|\\\"([^\"]*)\\\"\\.)?[[:space:]]*"
+  "(([[:alnum:]$_]+)|\\\"([^\"]*)\\\")?[[:space:]]*"
+  ")";
+
+static const char *pl_show_errors_sql_re_str=
+  "^("
+  "[[:space:]]*SHOW[[:space:]]+ERR(OR|ORS)?"
+  "([[:space:]]+(VIEW|PROCEDURE|FUNCTION|PACKAGE([[:space:]]+BODY)?|TRIGGER|TYPE([[:space:]]+BODY)?|LIBRARY|QUEUE|JAVA[[:space:]]+(SOURCE|CLASS)|DIMENSION|ASSEMBLY|HIERARCHY|ATTRIBUTE[[:space:]]+DIMENSION|ANALYTIC VIEW)[[:space:]]+"
+  "((\\\")?([[:alnum:]_]+)\\\"?\\.)?"
+  "(\\\")?([[:alnum:]_]+)\\\"?)?"
+  "[[:space:]]*"
+  "$)";
+
+static const char *pl_escape_sql_re_str=
+  "^("
+  "[[:space:]]*(<<[[:alnum:]_]+>>)?"
+  "[[:space:]]*(BEGIN|DECLARE)[[:space:]]*|"
+  "[[:space:]]*CREATE[[:space:]]+(OR[[:space:]]+REPLACE[[:space:]]+)?"
+  "(PROCEDURE|FUNCTION|PACKAGE([[:space:]]+BODY)?|TRIGGER|TYPE([[:space:]]+BODY)?)[[:space:]]+"
+  ")";
+
+static regex_t column_format_re, pl_create_sql_re, pl_alter_sql_re;
+static regex_t pl_show_errors_sql_re, pl_escape_sql_re;
+
+static const char *statements[]=
+{
+  "select * from t1",
+  "  insert into t1 values (1, 'set x')",
+  "update t1 set a= 1 where b= 2",
+  "delete from t1 where a in (select a from t2)",
+  "set define off",
+  "SET serveroutput on",
+  "/* hint */ set feedback 10",
+  "-- comment\nset echo on",
+  "column a format b",
+  "COLUMN c1 FORMAT a10",
+  "show errors",
+  "SHOW ERR",
+  "show errors procedure test.p1",
+  "show error package body pkg",
+  "show tables",
+  "show  errors_and_more",
+  "create table t1 (a int)",
+  "create or replace procedure p1 is begin null; end;",
+  "CREATE PACKAGE BODY pkg AS",
+  "create\tfunction f1 return number",
+  "create or replace view v1 as select 1 from dual",
+  "create or replace table t1 (a int)",
+  "create or   replace\n trigger trg before insert on t1",
+  "create java source named hello as",
+  "create analytic view av",
+  "create type body tp as",
+  "create procedure",
+  "create index i1 on t1(a)",
+  "alter procedure test.p1 compile",
+  "alter view v1 compile",
+  "alter table t1 add b int",
+  "alter package \"PKG\" compile",
+  "begin null; end;",
+  "BEGIN",
+  "beginning",
+  "declare x number; begin null; end;",
+  "<<lbl>> begin null; end;",
+  "  <<lbl>>\ndeclare x number;",
+  "/* unterminated",
+  "--",
+  "",
+  "   ",
+  "/**/",
+  "$set x",
+  "commit",
+  "drop procedure p1"
+};
+
+
+static bool matches(regex_t *re, const char *str)
+{
+  regmatch_t subs[20];
+  return regexec(re, str, array_elements(subs), subs, 0) == 0;
+}
+
+
+static enum enum_statement_kind kind_of(const char *str)
+{
+  return get_statement_kind(str, strlen(str));
+}
+
+
+/*
+  Every statement a pattern matches must get the kind of the pattern,
+  or the pattern would never be tried on it.
+*/
+
+static void test_agreement()
+{
+  uint missed= 0;
+  for (uint i= 0; i < array_elements(statements); i++)
+  {
+    const char *str= statements[i];
+    enum enum_statement_kind kind= kind_of(str);
+    if ((matches(&column_format_re, str) && kind != STATEMENT_KIND_COLUMN) ||
+        (matches(&pl_create_sql_re, str) &&
+         kind != STATEMENT_KIND_CREATE_PL) ||
+        (matches(&pl_alter_sql_re, str) && kind != STATEMENT_KIND_ALTER_PL) ||
+        (matches(&pl_show_errors_sql_re, str) &&
+         kind != STATEMENT_KIND_SHOW_ERRORS) ||
+        (matches(&pl_escape_sql_re, str) && !statement_kind_is_pl(kind)))
+    {
+      diag("missed: '%s'", str);
+      missed++;
+    }
+  }
+  ok(missed == 0, "kinds agree with the patterns on %u statements",
+     (uint) array_elements(statements));
+}
+
+
+static void test_kinds()
+{
+  ok(kind_of("select 1") == STATEMENT_KIND_OTHER, "select");
+  ok(kind_of("/* c */ -- d\n  SeT define off") == STATEMENT_KIND_SET,
+     "set after comments");
+  ok(kind_of("settings") == STATEMENT_KIND_OTHER, "set is a whole word");
+  ok(kind_of("column a format b") == STATEMENT_KIND_COLUMN, "column");
+  ok(kind_of("show errors") == STATEMENT_KIND_SHOW_ERRORS, "show errors");
+  ok(kind_of("show tables") == STATEMENT_KIND_OTHER, "show tables");
+  ok(kind_of("create or replace package body p") ==
+     STATEMENT_KIND_CREATE_PL, "create or replace package");
+  ok(kind_of("create table t1 (a int)") == STATEMENT_KIND_OTHER,
+     "create table");
+  ok(kind_of("create or replace table t1") == STATEMENT_KIND_OTHER,
+     "create or replace table");
+  ok(kind_of("alter function f compile") == STATEMENT_KIND_ALTER_PL,
+     "alter function");
+  ok(kind_of("alter table t1 add b int") == STATEMENT_KIND_OTHER,
+     "alter table");
+  ok(kind_of("<<l>> begin null; end;") == STATEMENT_KIND_PL_BLOCK,
+     "labelled block");
+  ok(kind_of("declare x int;") == STATEMENT_KIND_PL_BLOCK, "declare");
+  ok(kind_of("/* set x") == STATEMENT_KIND_OTHER, "unterminated comment");
+  ok(get_statement_kind("set x", 2) == STATEMENT_KIND_OTHER,
+     "length is respected");
+}
+
+
+/*
+  Pack statements as --pack-statements does and split the packet at the
+  delimiters the server would see: trailing comments, kept by the client,
+  must not hide the ';' after them.
+*/
+
+static void test_packed_delimiters()
+{
+  static const char *packed[]=
+  {
+    "UPDATE t SET a=1 -- note",
+    "DELETE FROM t WHERE a=';' # it's gone",
+    "INSERT INTO t VALUES ('--', \"#\") /* ; */",
+    "UPDATE t SET a=5--1"
+  };
+  char packet[512], *pos= packet;
+  uint i, found= 0;
+
+  for (i= 0; i < array_elements(packed); i++)
+  {
+    pos= strmov(pos, packed[i]);
+    pos= strmov(pos, PACKED_STATEMENT_END);
+  }
+  for (char *stmt= packet; stmt < pos; found++)
+  {
+    size_t length= statement_delimiter_offset(stmt, (size_t) (pos - stmt));
+    if (found >= array_elements(packed) ||
+        length != strlen(packed[found]) + 1 ||
+        strncmp(stmt, packed[found], length - 1))
+    {
+      diag("statement %u: '%.*s'", found, (int) length, stmt);
+      break;
+    }
+    stmt+= length + 2;
+  }
+  ok(found == array_elements(packed), "delimiters after trailing comments");
+  ok(statement_delimiter_offset("a -- ;", 6) == 6 &&
+     statement_delimiter_offset("a #;\n;", 6) == 5, "-- and # comments");
+}
+
+
+static void test_literal_rows()
+{
+  static const char *literal[]=
+  {
+    "(1,'a',NULL)",
+    "( -1.5e+3 , .5, 'it''s', 'a\\'b' 'c', X'0aF', 0x1F, b'01', DEFAULT )",
+    "(true,False,'',\t+2)"
+  };
+  static const char *other[]=
+  {
+    "(LAST_INSERT_ID(),1)",
+    "(@a,1)",
+    "(NOW())",
+    "(1,a)",
+    "(\"a\")",
+    "(1+1)",
+    "(1,'a')x",
+    "(1,'a'",
+    "(0xG1)",
+    "(1e)",
+    "()"
+  };
+  uint i, good= 0, bad= 0;
+
+  for (i= 0; i < array_elements(literal); i++)
+  {
+    if (statement_row_is_literals(literal[i], strlen(literal[i])))
+      good++;
+    else
+      diag("not literals: %s", literal[i]);
+  }
+  for (i= 0; i < array_elements(other); i++)
+  {
+    if (!statement_row_is_literals(other[i], strlen(other[i])))
+      bad++;
+    else
+      diag("literals: %s", other[i]);
+  }
+  ok(good == array_elements(literal), "rows of literals");
+  ok(bad == array_elements(other), "rows of expressions");
+}
+
+
+#ifdef BENCHMARK
+
+#define BENCH_STATEMENTS 1000000
+#define BENCH_PACKAGE_LINES 50000
+
+static void bench_kinds()
+{
+  ulonglong start, classified, matched;
+  uint kinds= 0, regex_matches= 0;
+  char query[256];
+
+  start= my_interval_timer();
+  for (uint i= 0; i < BENCH_STATEMENTS; i++)
+  {
+    my_snprintf(query, sizeof(query),
+                "insert into t%u values (%u, 'some text value %u')",
+                i % 64, i, i);
+    if (kind_of(query) != STATEMENT_KIND_OTHER)
+      kinds++;
+  }
+  classified= my_interval_timer();
+  for (uint i= 0; i < BENCH_STATEMENTS; i++)
+  {
+    my_snprintf(query, sizeof(query),
+                "insert into t%u values (%u, 'some text value %u')",
+                i % 64, i, i);
+    /* What com_go() ran for every statement in Oracle mode */
+    if (matches(&column_format_re, query) ||
+        matches(&pl_show_errors_sql_re, query) ||
+        matches(&pl_create_sql_re, query) ||
+        matches(&pl_alter_sql_re, query))
+      regex_matches++;
+  }
+  matched= my_interval_timer();
+
+  ok(kinds == 0 && regex_matches == 0, "%u statements classified",
+     BENCH_STATEMENTS);
+  diag("classifier: %llu ms, regular expressions: %llu ms",
+       (classified - start) / 1000000, (matched - classified) / 1000000);
+}
+
+
+/*
+  is_oracle_pl_escape_sql() of mysql.cc, which read_and_execute() calls
+  for every blank line of a statement in Oracle mode. str is null
+  terminated at length; unbounded is how it was before it passed the
+  length to regexec().
+*/
+
+static bool pl_escape(const char *str, size_t length, bool bounded)
+{
+  regmatch_t whole;
+
+  if (!statement_kind_is_pl(get_statement_kind(str, length)))
+    return 0;
+  if (!bounded)
+    return regexec(&pl_escape_sql_re, str, 0, 0, 0) == 0;
+  whole.rm_so= 0;
+  whole.rm_eo= (regoff_t) length;
+  return regexec(&pl_escape_sql_re, str, 1, &whole, REG_STARTEND) == 0;
+}
+
+
+/*
+  A package body of BENCH_PACKAGE_LINES lines with a blank line every
+  ten, checked at each blank line against all of it read so far.
+*/
+
+static void bench_package()
+{
+  DYNAMIC_STRING package;
+  DYNAMIC_ARRAY blanks;
+  ulonglong start, unbounded, bounded;
+  uint i, agree= 0;
+
+  init_dynamic_string(&package, "create or replace package body pkg as\n",
+                      BENCH_PACKAGE_LINES * 40, 65536);
+  my_init_dynamic_array(&blanks, sizeof(size_t), BENCH_PACKAGE_LINES / 10,
+                        1024, MYF(0));
+  for (i= 1; i < BENCH_PACKAGE_LINES; i++)
+  {
+    char line[64];
+    if (i % 10)
+      my_snprintf(line, sizeof(line), "  v%u number := %u;\n", i, i);
+    else
+    {
+      insert_dynamic(&blanks, (uchar*) &package.length);
+      strmov(line, "\n");
+    }
+    dynstr_append(&package, line);
+  }
+  dynstr_append(&package, "end pkg;\n");
+
+  start= my_interval_timer();
+  for (i= 0; i < blanks.elements; i++)
+  {
+    size_t length= *dynamic_element(&blanks, i, size_t*);
+    char save= package.str[length];
+    package.str[length]= 0;
+    if (pl_escape(package.str, length, 0))
+      agree++;
+    package.str[length]= save;
+  }
+  unbounded= my_interval_timer();
+  for (i= 0; i < blanks.elements; i++)
+  {
+    if (pl_escape(package.str, *dynamic_element(&blanks, i, size_t*), 1))
+      agree++;
+  }
+  bounded= my_interval_timer();
+
+  ok(agree == 2 * blanks.elements, "%u lines, PL block at every blank line",
+     BENCH_PACKAGE_LINES);
+  diag("unbounded: %llu ms, bounded: %llu ms",
+       (unbounded - start) / 1000000, (bounded - unbounded) / 1000000);
+  delete_dynamic(&blanks);
+  dynstr_free(&package);
+}
+
+#endif /* BENCHMARK */
+
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  MY_INIT(argv[0]);
+  regcomp(&column_format_re, column_format_re_str, REG_EXTENDED | REG_ICASE);
+  regcomp(&pl_create_sql_re, pl_create_sql_re_str, REG_EXTENDED | REG_ICASE);
+  regcomp(&pl_alter_sql_re, pl_alter_sql_re_str, REG_EXTENDED | REG_ICASE);
+  regcomp(&pl_show_errors_sql_re, pl_show_errors_sql_re_str,
+          REG_EXTENDED | REG_ICASE);
+  regcomp(&pl_escape_sql_re, pl_escape_sql_re_str, REG_EXTENDED | REG_ICASE);
+
+#ifdef BENCHMARK
+  plan(22);
+#else
+  plan(20);
+#endif
+  test_agreement();
+  test_kinds();
+  test_packed_delimiters();
+  test_literal_rows();
+#ifdef BENCHMARK
+  bench_kinds();
+  bench_package();
+#endif
+
+  regfree(&column_format_re);
+  regfree(&pl_create_sql_re);
+  regfree(&pl_alter_sql_re);
+  regfree(&pl_show_errors_sql_re);
+  regfree(&pl_escape_sql_re);
+  my_end(0);
+  return exit_status();
+}
@@ -0,0 +1,140 @@
+/*
+   Copyright (c) 2021 OceanBase.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA */
+
+#include <tap.h>
+#include <my_global.h>
+#include <my_sys.h>
+#include <m_string.h>
+
+/* What the clients used to do */
+static char *table_hex(char *to, const uchar *from, size_t length)
+{
+  const uchar *end= from + length;
+  for (; from < end; from++)
+  {
+    *to++= _dig_vec_upper[*from >> 4];
+    *to++= _dig_vec_upper[*from & 15];
+  }
+  return to;
+}
+
+/*
+  Compare with the table for every length up to a few vectors, at every
+  alignment of the input, and make sure nothing is written past the end.
+*/
+static int test_lengths(const uchar *bin)
+{
+  char got[2*200+1], want[2*200+1];
+  size_t length, offset;
+
+  for (offset= 0; offset < 32; offset++)
+  {
+    for (length= 0; length <= 160; length++)
+    {
+      char *end;
+      memset(got, '#', sizeof(got));
+      end= bin2hex(got, bin + offset, length);
+      table_hex(want, bin + offset, length);
+      if (end != got + 2 * length || memcmp(got, want, 2 * length) ||
+          got[2 * length] != '#')
+      {
+        diag("offset %u length %u: %.*s", (uint) offset, (uint) length,
+             (int) (2 * length), got);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+#ifdef BENCHMARK
+
+#define BENCH_LENGTH (1024*1024)
+#define BENCH_LOOPS  16
+
+static char *printf_hex(char *to, const uchar *from, size_t length)
+{
+  const uchar *end= from + length;
+  for (; from < end; from++, to+= 2)
+    sprintf(to, "%02X", *from);
+  return to;
+}
+
+static ulonglong bench(char *(*func)(char *, const uchar *, size_t),
+                       char *to, const uchar *from)
+{
+  ulonglong start= my_interval_timer();
+  int i;
+  for (i= 0; i < BENCH_LOOPS; i++)
+    func(to, from, BENCH_LENGTH);
+  return (my_interval_timer() - start) / 1000000;
+}
+
+/* Time bin2hex() against sprintf() and the table on a megabyte */
+static void bench_hex()
+{
+  uchar *big;
+  char *big_hex, *want;
+  uint i;
+
+  big= (uchar*) my_malloc(BENCH_LENGTH, MYF(MY_FAE));
+  big_hex= (char*) my_malloc(2 * BENCH_LENGTH, MYF(MY_FAE));
+  want= (char*) my_malloc(2 * BENCH_LENGTH + 1, MYF(MY_FAE)); /* sprintf */
+  for (i= 0; i < BENCH_LENGTH; i++)
+    big[i]= (uchar) (i * 2654435761U >> 13);
+
+  diag("%u x %u bytes; printf: %llu ms, table: %llu ms, bin2hex: %llu ms",
+       BENCH_LOOPS, BENCH_LENGTH,
+       bench(printf_hex, want, big), bench(table_hex, want, big),
+       bench(bin2hex, big_hex, big));
+  ok(!memcmp(big_hex, want, 2 * BENCH_LENGTH), "benchmark output");
+
+  my_free(big);
+  my_free(big_hex);
+  my_free(want);
+}
+
+#endif /* BENCHMARK */
+
+int main(int argc __attribute__((unused)), char **argv)
+{
+  uchar bin[256];
+  char hex[2*256];
+  uint i;
+  MY_INIT(argv[0]);
+
+#ifdef BENCHMARK
+  plan(4);
+#else
+  plan(3);
+#endif
+
+  for (i= 0; i < 256; i++)
+    bin[i]= (uchar) i;
+  table_hex(hex, bin, 256);
+  ok(!memcmp(hex, "000102", 6) && !memcmp(hex + 2*0x9F, "9FA0", 4) &&
+     !memcmp(hex + 2*254, "FEFF", 4), "table digits");
+  ok(bin2hex(hex, bin, 256) == hex + 512 &&
+     !memcmp(hex, "000102", 6) && !memcmp(hex + 2*0x9F, "9FA0", 4) &&
+     !memcmp(hex + 2*254, "FEFF", 4), "all byte values");
+  ok(!test_lengths(bin), "all lengths and alignments");
+#ifdef BENCHMARK
+  bench_hex();
+#endif
+
+  my_end(0);
+  return exit_status();
+}